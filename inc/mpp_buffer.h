@@ -120,12 +120,15 @@ typedef enum {
  * ion      : use ion device under Android/Linux, MppBuffer will encapsulte ion file handle
  * ext_dma  : the DMABUF(DMA buffers) come from the application
  * drm      : use the drm device interface for memory management
+ * dma_heap : use the dma-buf heap under /dev/dma_heap, cachable flag selects cached heap,
+ *            non-cachable request without uncached heap falls back to drm / ion
  */
 typedef enum {
     MPP_BUFFER_TYPE_NORMAL,
     MPP_BUFFER_TYPE_ION,
     MPP_BUFFER_TYPE_EXT_DMA,
     MPP_BUFFER_TYPE_DRM,
+    MPP_BUFFER_TYPE_DMA_HEAP,
     MPP_BUFFER_TYPE_BUTT,
 } MppBufferType;
 
@@ -257,6 +260,17 @@ typedef struct MppBufferInfo_t {
 #define mpp_buffer_set_offset(buffer, offset) \
         mpp_buffer_set_offset_with_caller(buffer, offset, __FUNCTION__)
 
+/*
+ * CPU access on cached buffer should be put between sync begin and end.
+ * ro is 1 for read only access. len 0 means the whole buffer.
+ * They do nothing on buffer without dma-buf fd.
+ */
+#define mpp_buffer_sync_begin(buffer, ro, offset, len) \
+        mpp_buffer_sync_begin_with_caller(buffer, ro, offset, len, __FUNCTION__)
+
+#define mpp_buffer_sync_end(buffer, ro, offset, len) \
+        mpp_buffer_sync_end_with_caller(buffer, ro, offset, len, __FUNCTION__)
+
 #define mpp_buffer_group_get_internal(group, type, ...) \
         mpp_buffer_group_get(group, type, MPP_BUFFER_INTERNAL, MODULE_TAG, __FUNCTION__)
 
@@ -293,6 +307,8 @@ int     mpp_buffer_get_index_with_caller(MppBuffer buffer, const char *caller);
 MPP_RET mpp_buffer_set_index_with_caller(MppBuffer buffer, int index, const char *caller);
 size_t  mpp_buffer_get_offset_with_caller(MppBuffer buffer, const char *caller);
 MPP_RET mpp_buffer_set_offset_with_caller(MppBuffer buffer, size_t offset, const char *caller);
+MPP_RET mpp_buffer_sync_begin_with_caller(MppBuffer buffer, RK_S32 ro, size_t offset, size_t len, const char *caller);
+MPP_RET mpp_buffer_sync_end_with_caller(MppBuffer buffer, RK_S32 ro, size_t offset, size_t len, const char *caller);
 
 MPP_RET mpp_buffer_group_get(MppBufferGroup *group, MppBufferType type, MppBufferMode mode,
                              const char *tag, const char *caller);
@@ -72,6 +72,7 @@ typedef enum MppMetaKey_e {
     KEY_OUTPUT_BLOCK            = FOURCC_META('o', 'b', 'l', 'k'),
     KEY_INPUT_IDR_REQ           = FOURCC_META('i', 'i', 'd', 'r'),   /* input idr frame request flag */
     KEY_OUTPUT_INTRA            = FOURCC_META('o', 'i', 'd', 'r'),   /* output intra frame indicator */
+    KEY_OUTPUT_REENC            = FOURCC_META('o', 'r', 'e', 'n'),   /* output frame hardware re-encode times */
 
     /* mpp_frame / mpp_packet meta data info key */
     KEY_TEMPORAL_ID             = FOURCC_META('t', 'l', 'i', 'd'),
@@ -19,6 +19,32 @@
 
 #include "mpp_meta.h"
 
+/*
+ * release callback for packet memory lent by user
+ * ctx  - user context set on packet init
+ * data - the data pointer set on packet init
+ */
+typedef void (*MppPacketReleaseCb)(void *ctx, void *data);
+
+/*
+ * packet segment
+ * Encoder output packet is made of segments in stream order: stream header,
+ * sei prefix and hardware stream. offset is counted from packet pos so each
+ * segment can be sent with writev without parsing the stream.
+ */
+typedef enum MppPktSegType_e {
+    MPP_PKT_SEG_HEADER,         /* vps / sps / pps */
+    MPP_PKT_SEG_SEI,            /* version / rc config / user data sei */
+    MPP_PKT_SEG_STREAM,         /* stream generated by hardware */
+    MPP_PKT_SEG_BUTT,
+} MppPktSegType;
+
+typedef struct MppPktSeg_t {
+    MppPktSegType       type;
+    RK_U32              offset;
+    RK_U32              len;
+} MppPktSeg;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -28,11 +54,25 @@ extern "C" {
  *
  * mpp_packet_init = mpp_packet_new + mpp_packet_set_data + mpp_packet_set_size
  * mpp_packet_copy_init = mpp_packet_init + memcpy
+ *
+ * mpp_packet_init_with_release lends user memory to mpp without copy.
+ * mpp_packet_copy_init always copies the data and leaves src unchanged.
+ * mpp_packet_move_init on such packet will NOT copy the data. It moves the
+ * release responsibility to the new packet and the release callback is called
+ * once when the new packet is deinit. src still points to the data but does
+ * not own it any more. Packet without lent memory is copied as copy_init.
+ * Decoder put_packet uses move so the memory is returned after parser has
+ * consumed the packet.
+ * NOTE: parser may read 32bit beyond the valid length so the lent memory
+ *       should have some readable padding bytes after the data.
  */
 MPP_RET mpp_packet_new(MppPacket *packet);
 MPP_RET mpp_packet_init(MppPacket *packet, void *data, size_t size);
 MPP_RET mpp_packet_init_with_buffer(MppPacket *packet, MppBuffer buffer);
+MPP_RET mpp_packet_init_with_release(MppPacket *packet, void *data, size_t size,
+                                     MppPacketReleaseCb release, void *ctx);
 MPP_RET mpp_packet_copy_init(MppPacket *packet, const MppPacket src);
+MPP_RET mpp_packet_move_init(MppPacket *packet, MppPacket src);
 MPP_RET mpp_packet_deinit(MppPacket *packet);
 
 /*
@@ -66,6 +106,13 @@ MPP_RET mpp_packet_set_eos(MppPacket packet);
 MPP_RET mpp_packet_clr_eos(MppPacket packet);
 RK_U32  mpp_packet_get_eos(MppPacket packet);
 MPP_RET mpp_packet_set_extra_data(MppPacket packet);
+/*
+ * Encoder low delay output (MPP_ENC_SPLIT_OUT_LOWDELAY) returns a frame in
+ * several partition packets as its slices are done on hardware. The last
+ * partition of a frame has the eoi (end of image) flag.
+ */
+RK_U32  mpp_packet_is_partition(const MppPacket packet);
+RK_U32  mpp_packet_is_eoi(const MppPacket packet);
 
 void        mpp_packet_set_buffer(MppPacket packet, MppBuffer buffer);
 MppBuffer   mpp_packet_get_buffer(const MppPacket packet);
@@ -82,6 +129,13 @@ MPP_RET mpp_packet_write(MppPacket packet, size_t offset, void *data, size_t siz
 RK_S32  mpp_packet_has_meta(const MppPacket packet);
 MppMeta mpp_packet_get_meta(const MppPacket packet);
 
+/*
+ * segment info access interface
+ * return segment count and the array of segments in stream order
+ */
+RK_U32  mpp_packet_get_segment_nb(const MppPacket packet);
+const MppPktSeg *mpp_packet_get_segment_info(const MppPacket packet);
+
 #ifdef __cplusplus
 }
 #endif
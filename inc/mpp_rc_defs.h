@@ -150,6 +150,8 @@ typedef struct EncRcForceCfg_t {
  * rc   -> hal      bit_target / bit_max / bit_min
  * hal  -> hw       quality_target / quality_max / quality_min
  * hw   -> rc / hal bit_real / quality_real / madi / madp
+ * enc  -> rc       hist_ratio / hist_scene_cut from cpu frame history
+ * rc   -> rc       frame_type / scale_qp from rc start to rc end
  */
 typedef struct EncRcCommonInfo_t {
     /* rc to hal */
@@ -167,7 +169,18 @@ typedef struct EncRcCommonInfo_t {
     RK_S32          madi;
     RK_S32          madp;
 
-    RK_S32          reserve[16];
+    /* rc from cpu frame history, zero when it is off */
+    RK_S32          hist_ratio;
+    RK_S32          hist_scene_cut;
+
+    /*
+     * rc model state of this frame, next frame may start before rc end of
+     * this frame in encoder pipeline mode
+     */
+    RK_S32          frame_type;
+    RK_S32          scale_qp;
+
+    RK_S32          reserve[12];
 } EncRcTaskInfo;
 
 typedef struct EncRcTask_s {
@@ -51,6 +51,11 @@
  *
  * decode_get_frame : get video frame from decoder only, async interface
  *
+ * decode_put_packets / decode_get_frames : batch version of the two above
+ *            which take the queue lock and wake up decoder once per call.
+ *            Each frame got is the same as decode_get_frame. The batch stops
+ *            after an info change or eos frame.
+ *
  * encode_put_frame : send video frame to encoder only, async interface
  *
  * encode_get_packet: get encoded video packet from encoder only, async interface
@@ -206,10 +211,39 @@ typedef struct MppApi_t {
      */
     MPP_RET (*control)(MppCtx ctx, MpiCmd cmd, MppParam param);
 
+    // batch data flow interface
+    /**
+     * @brief send multiple video stream packets to decoder in one call
+     * @param[in] ctx The context of mpp, created by mpp_create() and initiated
+     *                by mpp_init().
+     * @param[in] packets The input video stream array.
+     * @param[in] count The number of packets in the array.
+     * @param[out] done The number of packets accepted. Packets after it are
+     *                  untouched and should be sent again later.
+     * @return 0 for success, MPP_ERR_BUFFER_FULL when input queue is full
+     *         before all packets are accepted, others for failure.
+     */
+    MPP_RET (*decode_put_packets)(MppCtx ctx, MppPacket *packets, RK_U32 count, RK_U32 *done);
+    /**
+     * @brief get all ready video frames from decoder in one call
+     * @param[in] ctx The context of mpp, created by mpp_create() and initiated
+     *                by mpp_init().
+     * @param[out] frames The output picture array.
+     * @param[in] max The size of the output array.
+     * @param[out] count The number of frames returned. Output timeout only
+     *                   applies when no frame is ready.
+     * @return 0 for success, others for failure. The return value is an
+     *         error code. For details, please refer mpp_err.h.
+     */
+    MPP_RET (*decode_get_frames)(MppCtx ctx, MppFrame *frames, RK_U32 max, RK_U32 *count);
+
     /**
      * @brief The reserved segment, may be used in the future
+     *        Function pointers added above take pointer sized slots from the
+     *        original 16 words so sizeof(MppApi) keeps the same on 32 and
+     *        64 bit platform.
      */
-    RK_U32 reserv[16];
+    RK_U32 reserv[16 - 2 * sizeof(void *) / sizeof(RK_U32)];
 } MppApi;
 
 
@@ -69,6 +69,16 @@ typedef enum {
      */
     MPP_SET_INPUT_TIMEOUT,              /* parameter type RK_S64 */
     MPP_SET_OUTPUT_TIMEOUT,             /* parameter type RK_S64 */
+    /*
+     * eventfd readiness handle for decoder put_packet / get_frame
+     * input  - readable while put_packet can accept a new packet
+     * output - readable while get_frame has a frame to return
+     * The fd is owned by mpp. Poll it only, do not read or close it.
+     */
+    MPP_GET_INPUT_EVENTFD,              /* parameter type RK_S32 * */
+    MPP_GET_OUTPUT_EVENTFD,             /* parameter type RK_S32 * */
+    /* max packets queued by decode_put_packet, default 4 */
+    MPP_SET_INPUT_QUEUE_DEPTH,          /* parameter type RK_S32 */
     MPP_CMD_END,
 
     MPP_CODEC_CMD_BASE                  = CMD_MODULE_CODEC,
@@ -81,7 +91,12 @@ typedef enum {
     MPP_DEC_SET_INFO_CHANGE_READY,
     MPP_DEC_SET_PRESENT_TIME_ORDER,     /* use input time order for output */
     MPP_DEC_SET_PARSER_SPLIT_MODE,      /* Need to setup before init */
-    MPP_DEC_SET_PARSER_FAST_MODE,       /* Need to setup before init */
+    /*
+     * Need to setup before init. H.264, H.265 and VP9 hal keep one register
+     * set per task so the parser does not wait for the previous task. Same
+     * as MPP_DEC_SET_PIPELINE_DEPTH 2 when no depth is set.
+     */
+    MPP_DEC_SET_PARSER_FAST_MODE,
     MPP_DEC_GET_STREAM_COUNT,
     MPP_DEC_GET_VPUMEM_USED_COUNT,
     MPP_DEC_SET_VC1_EXTRA_DATA,
@@ -89,6 +104,16 @@ typedef enum {
     MPP_DEC_SET_DISABLE_ERROR,          /* When set it will disable sw/hw error (H.264 / H.265) */
     MPP_DEC_SET_IMMEDIATE_OUT,
     MPP_DEC_SET_ENABLE_DEINTERLACE,     /* MPP enable deinterlace by default. Vpuapi can disable it */
+    MPP_DEC_SET_DISPLAY_DELAY,          /* Frame slots for display besides dpb, default 4. Need to setup before init */
+    /*
+     * Max decode tasks on hardware at once, parameter type RK_U32, 1 to 3.
+     * Need to setup before init. The parser submits the next frame without
+     * waiting for the previous task until depth tasks are on hardware. Its
+     * references are on hardware already and hardware runs tasks in submit
+     * order. Depth above 1 uses the fast mode hal of H.264, H.265 and VP9,
+     * other formats run with depth 1.
+     */
+    MPP_DEC_SET_PIPELINE_DEPTH,
 
     MPP_DEC_CMD_QUERY                   = CMD_MODULE_CODEC | CMD_CTX_ID_DEC | CMD_DEC_QUERY,
     /* query decoder runtime information for decode stage */
@@ -151,6 +176,18 @@ typedef enum {
     MPP_ENC_CFG_MISC                    = CMD_MODULE_CODEC | CMD_CTX_ID_ENC | CMD_ENC_CFG_MISC,
     MPP_ENC_SET_HEADER_MODE,            /* set MppEncHeaderMode */
     MPP_ENC_GET_HEADER_MODE,            /* get MppEncHeaderMode */
+    /*
+     * Max encode tasks in flight, 1 or 2, parameter type RK_U32. Need to setup
+     * before init. With 2 the next frame is prepared while the current frame
+     * runs on hardware. Reencode is disabled then and max_reenc_times is
+     * reset to 0 with a log. Init returns MPP_NOK when the hardware has no
+     * pipeline support. Only vepu541 H.264 supports it. The control wins
+     * over the mpp_enc_pipeline_depth env.
+     */
+    MPP_ENC_SET_PIPELINE_DEPTH,
+    MPP_ENC_SET_SCHED_CFG,              /* set MppEncSchedCfg structure */
+    MPP_ENC_GET_SCHED_CFG,              /* get MppEncSchedCfg structure */
+    MPP_ENC_GET_SCHED_STAT,             /* get MppEncSchedStat, fails when scheduler is disabled */
 
     MPP_ENC_CFG_SPLIT                   = CMD_MODULE_CODEC | CMD_CTX_ID_ENC | CMD_ENC_CFG_SPLIT,
     MPP_ENC_SET_SPLIT,                  /* set MppEncSliceSplit structure */
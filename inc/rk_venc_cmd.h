@@ -451,6 +451,30 @@ typedef enum MppEncSeiMode_e {
     MPP_ENC_SEI_MODE_ONE_FRAME               /* one frame may have one SEI, if SEI info has changed */
 } MppEncSeiMode;
 
+/*
+ * Hardware scheduling between encoders sharing one device. It is enabled by
+ * env mpp_enc_sched with the number of tasks allowed on the device.
+ */
+typedef struct MppEncSchedCfg_t {
+    /* deadline period in us, zero for the rc output frame interval */
+    RK_S32              period;
+    /* deadline is scaled by 16 / weight, zero for the default 16 */
+    RK_S32              weight;
+} MppEncSchedCfg;
+
+/* statistic of one encoder, all time in us */
+typedef struct MppEncSchedStat_t {
+    RK_S64              count;
+    /* task finished after its deadline */
+    RK_S64              miss;
+    /* from request to hardware granted */
+    RK_S64              wait_sum;
+    RK_S64              wait_max;
+    /* from hardware granted to task done */
+    RK_S64              run_sum;
+    RK_S64              run_max;
+} MppEncSchedStat;
+
 /*
  * Mpp codec parameter
  * parameter is defined from here
@@ -963,6 +987,22 @@ typedef enum MppEncSplitMode_e {
     MPP_ENC_SPLIT_BY_CTU,
 } MppEncSplitMode;
 
+/*
+ * slice split output mode, set by MppEncCfg split:out
+ *
+ * MPP_ENC_SPLIT_OUT_LOWDELAY - Each slice is returned as a partition packet
+ *                              as soon as hardware has finished it.
+ *                              The last partition of a frame has eoi flag.
+ *                              Reencode is disabled in this mode.
+ *                              Spare output tasks for the partitions are
+ *                              only allocated when it is set in a MppEncCfg
+ *                              sent by MPP_ENC_SET_CFG before init. Other
+ *                              cfg is rejected before init.
+ */
+typedef enum MppEncSplitOutMode_e {
+    MPP_ENC_SPLIT_OUT_LOWDELAY              = (1 << 0),
+} MppEncSplitOutMode;
+
 typedef struct MppEncSliceSplit_t {
     RK_U32  change;
 
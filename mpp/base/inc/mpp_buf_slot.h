@@ -110,6 +110,8 @@ extern "C" {
  *
  * init / deinit - normal initialize and de-initialize function
  * setup         - called by parser when slot information changed
+ *                 larger slot count takes effect at once for growing on
+ *                 demand, smaller slot count takes effect on next ready
  * is_changed    - called by mpp to detect whether info change flow is needed
  * ready         - called by mpp when info changed is done
  *
@@ -28,6 +28,10 @@
 #define MPP_BUF_DBG_DUMP_ON_EXIT        (0x00000020)
 #define MPP_BUF_DBG_CHECK_SIZE          (0x00000100)
 
+/* unused buffers are kept in power of 2 size class lists from 4K to 128M+ */
+#define MPP_BUF_SIZE_CLASS_SHIFT        12
+#define MPP_BUF_SIZE_CLASS_COUNT        16
+
 #define mpp_buf_dbg(flag, fmt, ...)     _mpp_dbg(mpp_buffer_debug, flag, fmt, ## __VA_ARGS__)
 #define mpp_buf_dbg_f(flag, fmt, ...)   _mpp_dbg_f(mpp_buffer_debug, flag, fmt, ## __VA_ARGS__)
 
@@ -45,6 +49,8 @@ struct MppBufferImpl_t {
     char                tag[MPP_TAG_SIZE];
     const char          *caller;
     RK_U32              group_id;
+    // owner group, it will not be destroyed before all its buffers released
+    MppBufferGroupImpl  *group;
     RK_S32              buffer_id;
     MppBufferMode       mode;
 
@@ -60,8 +66,18 @@ struct MppBufferImpl_t {
     // used flag is for used/unused list detection
     RK_U32              used;
     RK_U32              internal;
+    // atomic, only the 0 / 1 transition is done under group lock
     RK_S32              ref_count;
     struct list_head    list_status;
+
+    /*
+     * import cache key: the fd passed in by user and the file behind it.
+     * Buffer with import_cached set is kept in import cache when released.
+     */
+    RK_U32              import_cached;
+    RK_S32              import_fd;
+    RK_U64              import_dev;
+    RK_U64              import_ino;
 };
 
 struct MppBufferGroupImpl_t {
@@ -80,10 +96,23 @@ struct MppBufferGroupImpl_t {
     RK_S32              buffer_count;
     RK_S32              count_used;
     RK_S32              count_unused;
+    // unused buffer size kept before small buffer is trimmed, internal mode only
+    size_t              unused_size;
+    size_t              retain_size;
+
+    // allocation churn record
+    RK_U32              alloc_count;
+    RK_U32              free_count;
+    RK_U32              trim_count;
+    RK_U32              hit_count;
+    RK_U32              miss_count;
 
     MppAllocator        allocator;
     MppAllocatorApi     *alloc_api;
 
+    // lock for buffer list / status record / log of this group
+    Mutex               *lock;
+
     // thread that will be signal on buffer return
     MppBufCallback      callback;
     void                *arg;
@@ -92,6 +121,8 @@ struct MppBufferGroupImpl_t {
     RK_U32              clear_on_exit;
     // is_orphan: 0 - normal group 1 - orphan group
     RK_U32              is_orphan;
+    // is_misc: group from mpp_buffer_get_misc_group, buffer may go to import cache
+    RK_U32              is_misc;
 
     // buffer log function
     RK_U32              log_runtime_en;
@@ -104,7 +135,8 @@ struct MppBufferGroupImpl_t {
 
     // link to list_status in MppBufferImpl
     struct list_head    list_used;
-    struct list_head    list_unused;
+    // unused buffer in size class list, sorted by size in each class
+    struct list_head    list_unused[MPP_BUF_SIZE_CLASS_COUNT];
 };
 
 #ifdef __cplusplus
@@ -122,9 +154,9 @@ extern RK_U32 mpp_buffer_debug;
  *                            It required map to access. This is an optimization
  *                            for reducing virtual memory usage.
  *
- *  mpp_buffer_get_unused   : get unused buffer with size. it will first search
- *                            the unused list. if failed it will create on from
- *                            group allocator.
+ *  mpp_buffer_get_unused   : get unused buffer with size. it will search the
+ *                            size class lists for the best fit one. if failed
+ *                            caller will create one from group allocator.
  *
  *  mpp_buffer_ref_inc      : increase buffer's reference counter. if it is unused
  *                            then it will be moved to used list.
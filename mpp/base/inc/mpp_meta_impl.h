@@ -64,6 +64,8 @@ extern "C" {
 RK_S32 mpp_meta_size(MppMeta meta);
 MPP_RET mpp_meta_inc_ref(MppMeta meta);
 MppMetaNode *mpp_meta_next_node(MppMeta meta);
+/* release the node detached by mpp_meta_next_node */
+void mpp_meta_free_node(MppMetaNode *node);
 
 #ifdef __cplusplus
 }
@@ -22,6 +22,11 @@
 #define MPP_PACKET_FLAG_EOS             (0x00000001)
 #define MPP_PACKET_FLAG_EXTRA_DATA      (0x00000002)
 #define MPP_PACKET_FLAG_INTERNAL        (0x00000004)
+#define MPP_PACKET_FLAG_EXTERNAL        (0x00000008)
+#define MPP_PACKET_FLAG_PARTITION       (0x00000010)
+#define MPP_PACKET_FLAG_EOI             (0x00000020)
+
+#define MPP_PACKET_SEG_CNT_MAX          (8)
 
 /*
  * mpp_packet_imp structure
@@ -32,6 +37,10 @@
  * length   : valid data length
  * pts      : packet pts
  * dts      : packet dts
+ * release  : release callback for memory lent by user
+ * release_ctx  : user context passed to release callback
+ * segment_nb   : valid segment count
+ * segments     : segments in stream order
  */
 typedef struct MppPacketImpl_t {
     const char  *name;
@@ -48,6 +57,12 @@ typedef struct MppPacketImpl_t {
 
     MppBuffer   buffer;
     MppMeta     meta;
+
+    MppPacketReleaseCb  release;
+    void        *release_ctx;
+
+    RK_U32      segment_nb;
+    MppPktSeg   segments[MPP_PACKET_SEG_CNT_MAX];
 } MppPacketImpl;
 
 #ifdef __cplusplus
@@ -60,6 +75,10 @@ MPP_RET mpp_packet_reset(MppPacketImpl *packet);
 MPP_RET mpp_packet_copy(MppPacket dst, MppPacket src);
 MPP_RET mpp_packet_append(MppPacket dst, MppPacket src);
 
+void    mpp_packet_reset_segment(MppPacket packet);
+MPP_RET mpp_packet_add_segment(MppPacket packet, MppPktSegType type,
+                               RK_U32 offset, RK_U32 len);
+
 /* pointer check function */
 MPP_RET check_is_mpp_packet(void *ptr);
 
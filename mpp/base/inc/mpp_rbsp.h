@@ -0,0 +1,45 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __MPP_RBSP_H__
+#define __MPP_RBSP_H__
+
+#include "rk_type.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Return the offset of the first emulation prevention byte (the 03 of a
+ * 00 00 03 sequence) in buf. Returns size when buf has none, in which case
+ * buf can be used as rbsp directly.
+ */
+RK_S32 mpp_rbsp_find_epb(const RK_U8 *buf, RK_S32 size);
+
+/*
+ * Copy src to dst with emulation prevention bytes removed and return the
+ * rbsp length. dst may be equal to src for in-place extraction, then bytes
+ * before the first emulation prevention byte are not touched.
+ */
+RK_S32 mpp_rbsp_extract(RK_U8 *dst, const RK_U8 *src, RK_S32 size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_RBSP_H__*/
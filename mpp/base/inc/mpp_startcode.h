@@ -0,0 +1,48 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_STARTCODE_H__
+#define __MPP_STARTCODE_H__
+
+#include "rk_type.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Return the offset of the first 00 00 xx sequence with min <= xx <= max.
+ * Returns size when no complete sequence is found.
+ */
+RK_S32 mpp_find_prefix(const RK_U8 *buf, RK_S32 size, RK_U8 min, RK_U8 max);
+
+/*
+ * Return the offset of the first 00 00 01 start code prefix in buf.
+ * Returns size when no complete prefix is found.
+ */
+RK_S32 mpp_find_startcode(const RK_U8 *buf, RK_S32 size);
+
+/*
+ * Return the offset of the first 0xff byte followed by a byte in [min, max].
+ * Returns size when no such pair is found inside buf.
+ */
+RK_S32 mpp_find_marker(const RK_U8 *buf, RK_S32 size, RK_U8 min, RK_U8 max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_STARTCODE_H__*/
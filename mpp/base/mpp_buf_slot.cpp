@@ -22,6 +22,7 @@
 #include "mpp_mem.h"
 #include "mpp_env.h"
 #include "mpp_list.h"
+#include "mpp_atomic.h"
 #include "mpp_common.h"
 
 #include "mpp_frame_impl.h"
@@ -57,6 +58,17 @@ typedef struct MppBufSlotsImpl_t MppBufSlotsImpl;
 
 #define SLOT_OPS_MAX_COUNT              1024
 
+/*
+ * slot entries are allocated in groups of 32 and never moved, so the status
+ * word of a slot can be accessed without lock while the slot count grows.
+ * Each group has one free bitmap word.
+ */
+#define SLOT_GROUP_SHIFT                5
+#define SLOT_GROUP_SIZE                 (1 << SLOT_GROUP_SHIFT)
+#define SLOT_GROUP_MASK                 (SLOT_GROUP_SIZE - 1)
+#define SLOT_GROUP_COUNT                8
+#define SLOT_MAX_COUNT                  SLOT_IDX_BUTT
+
 typedef enum MppBufSlotOps_e {
     // status opertaion
     SLOT_INIT,
@@ -180,6 +192,7 @@ typedef struct MppBufSlotLog_t {
 struct MppBufSlotEntry_t {
     MppBufSlotsImpl     *slots;
     struct list_head    list;
+    // atomic, updated by CAS in slot_ops_with_log
     SlotStatus          status;
     RK_S32              index;
 
@@ -188,6 +201,13 @@ struct MppBufSlotEntry_t {
     MppBuffer           buffer;
 };
 
+/*
+ * lock usage:
+ * impl->lock protects the slot count, info change, queues and the frame /
+ * buffer of slot entries. Slot status flags and the free bitmap are atomic,
+ * so mpp_buf_slot_get_unused / set_flag / clr_flag only take the lock when a
+ * slot is released.
+ */
 struct MppBufSlotsImpl_t {
     Mutex               *lock;
     RK_U32              slots_idx;
@@ -209,6 +229,7 @@ struct MppBufSlotsImpl_t {
     AlignFunc           hal_len_align;          // default NULL
     size_t              buf_size;
     RK_S32              buf_count;
+    // atomic
     RK_S32              used_count;
     // buffer size equal to (h_stride * v_stride) * numerator / denominator
     // internal parameter
@@ -226,12 +247,79 @@ struct MppBufSlotsImpl_t {
     // list for display
     struct list_head    queue[QUEUE_BUTT];
 
-    // list for log
+    // list for log, only created on BUF_SLOT_DBG_OPS_HISTORY
     mpp_list            *logs;
 
-    MppBufSlotEntry     *slots;
+    // bit set for slot index below buf_count and not on used
+    RK_U32              free_bits[SLOT_GROUP_COUNT];
+    MppBufSlotEntry     *groups[SLOT_GROUP_COUNT];
 };
 
+static inline MppBufSlotEntry *get_slot(MppBufSlotsImpl *impl, RK_S32 index)
+{
+    return &impl->groups[index >> SLOT_GROUP_SHIFT][index & SLOT_GROUP_MASK];
+}
+
+static inline void put_free_bit(MppBufSlotsImpl *impl, RK_S32 index)
+{
+    MPP_FETCH_OR(&impl->free_bits[index >> SLOT_GROUP_SHIFT],
+                 1U << (index & SLOT_GROUP_MASK));
+}
+
+/* claim the lowest free slot index, return -1 when all slots are used */
+static RK_S32 get_free_bit(MppBufSlotsImpl *impl)
+{
+    RK_S32 i;
+
+    for (i = 0; i < SLOT_GROUP_COUNT; i++) {
+        RK_U32 bits = impl->free_bits[i];
+
+        while (bits) {
+            RK_U32 bit = bits & (~bits + 1);
+            RK_U32 old = MPP_VAL_CAS(&impl->free_bits[i], bits, bits & ~bit);
+
+            if (old == bits)
+                return (i << SLOT_GROUP_SHIFT) + __builtin_ctz(bit);
+
+            bits = old;
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * Slot count change is done with lock while get_unused takes bits without
+ * it, so live bits are never rebuilt. Grow only frees the new indices after
+ * the count is raised.
+ */
+static void grow_free_bits(MppBufSlotsImpl *impl, RK_S32 start, RK_S32 end)
+{
+    RK_S32 i;
+
+    for (i = start; i < end; i++)
+        put_free_bit(impl, i);
+}
+
+/*
+ * Shrink takes the free bits from the top index down to count. A clear bit
+ * is a slot in use or just taken by get_unused, the slots below it are kept.
+ * Returns the slot count after shrink.
+ */
+static RK_S32 shrink_free_bits(MppBufSlotsImpl *impl, RK_S32 count)
+{
+    RK_S32 i;
+
+    for (i = impl->buf_count - 1; i >= count; i--) {
+        RK_U32 bit = 1U << (i & SLOT_GROUP_MASK);
+
+        if (!(MPP_FETCH_AND(&impl->free_bits[i >> SLOT_GROUP_SHIFT], ~bit) & bit))
+            return i + 1;
+    }
+
+    return count;
+}
+
 static RK_U32 default_align_16(RK_U32 val)
 {
     return MPP_ALIGN(val, 16);
@@ -284,7 +372,6 @@ static void generate_info_set(MppBufSlotsImpl *impl, MppFrame frame, RK_U32 forc
 static void _dump_slots(const char *caller, MppBufSlotsImpl *impl)
 {
     RK_S32 i;
-    MppBufSlotEntry *slot = impl->slots;
 
     mpp_log("\ncaller %s is dumping slots\n", caller, impl->slots_idx);
     mpp_log("slots %d %p buffer count %d buffer size %d\n", impl->slots_idx,
@@ -292,8 +379,8 @@ static void _dump_slots(const char *caller, MppBufSlotsImpl *impl)
     mpp_log("decode  count %d\n", impl->decode_count);
     mpp_log("display count %d\n", impl->display_count);
 
-    for (i = 0; i < impl->buf_count; i++, slot++) {
-        SlotStatus status = slot->status;
+    for (i = 0; i < impl->buf_count && impl->groups[i >> SLOT_GROUP_SHIFT]; i++) {
+        SlotStatus status = get_slot(impl, i)->status;
         mpp_log("slot %2d used %d refer %d decoding %d display %d status %08x\n",
                 i, status.on_used, status.codec_use, status.hal_use, status.queue_use, status.val);
     }
@@ -302,6 +389,8 @@ static void _dump_slots(const char *caller, MppBufSlotsImpl *impl)
 
     mpp_list *logs = impl->logs;
     if (logs) {
+        AutoMutex auto_lock(logs->mutex());
+
         while (logs->list_size()) {
             MppBufSlotLog log;
             logs->del_at_head(&log, sizeof(log));
@@ -318,6 +407,7 @@ static void _dump_slots(const char *caller, MppBufSlotsImpl *impl)
 static void add_slot_log(mpp_list *logs, RK_S32 index, MppBufSlotOps op, SlotStatus before, SlotStatus after)
 {
     if (logs) {
+        AutoMutex auto_lock(logs->mutex());
         MppBufSlotLog log = {
             index,
             op,
@@ -330,12 +420,9 @@ static void add_slot_log(mpp_list *logs, RK_S32 index, MppBufSlotOps op, SlotSta
     }
 }
 
-static void slot_ops_with_log(MppBufSlotsImpl *impl, MppBufSlotEntry *slot, MppBufSlotOps op, void *arg)
+static SlotStatus slot_ops_update(RK_S32 index, SlotStatus status, MppBufSlotOps op,
+                                  void *arg, RK_U32 *error)
 {
-    RK_U32 error = 0;
-    RK_S32 index = slot->index;
-    SlotStatus status = slot->status;
-    SlotStatus before = status;
     switch (op) {
     case SLOT_INIT : {
         status.val = 0;
@@ -371,8 +458,8 @@ static void slot_ops_with_log(MppBufSlotsImpl *impl, MppBufSlotEntry *slot, MppB
         if (status.hal_use)
             status.hal_use--;
         else {
-            mpp_err("can not clr hal_input on slot %d\n", slot->index);
-            error = 1;
+            mpp_err("can not clr hal_input on slot %d\n", index);
+            *error = 1;
         }
     } break;
     case SLOT_SET_HAL_OUTPUT : {
@@ -399,8 +486,8 @@ static void slot_ops_with_log(MppBufSlotsImpl *impl, MppBufSlotEntry *slot, MppB
         if (status.queue_use)
             status.queue_use--;
         else {
-            mpp_err("can not clr queue_use on slot %d\n", slot->index);
-            error = 1;
+            mpp_err("can not clr queue_use on slot %d\n", index);
+            *error = 1;
         }
     } break;
     case SLOT_SET_EOS : {
@@ -408,7 +495,6 @@ static void slot_ops_with_log(MppBufSlotsImpl *impl, MppBufSlotEntry *slot, MppB
     } break;
     case SLOT_CLR_EOS : {
         status.eos = 0;
-        slot->eos = 0;
     } break;
     case SLOT_SET_FRAME : {
         status.has_frame = (arg) ? (1) : (0);
@@ -424,27 +510,70 @@ static void slot_ops_with_log(MppBufSlotsImpl *impl, MppBufSlotEntry *slot, MppB
     } break;
     default : {
         mpp_err("found invalid operation code %d\n", op);
-        error = 1;
+        *error = 1;
     } break;
     }
-    slot->status = status;
+
+    return status;
+}
+
+static SlotStatus slot_ops_with_log(MppBufSlotsImpl *impl, MppBufSlotEntry *slot, MppBufSlotOps op, void *arg)
+{
+    RK_S32 index = slot->index;
+    RK_U32 error;
+    SlotStatus before;
+    SlotStatus status;
+
+    do {
+        error = 0;
+        before.val = slot->status.val;
+        status = slot_ops_update(index, before, op, arg, &error);
+    } while (!MPP_BOOL_CAS(&slot->status.val, before.val, status.val));
+
+    if (op == SLOT_CLR_EOS)
+        slot->eos = 0;
+
     buf_slot_dbg(BUF_SLOT_DBG_OPS_RUNTIME, "slot %3d index %2d op: %s arg %010p status in %08x out %08x",
                  impl->slots_idx, index, op_string[op], arg, before.val, status.val);
-    add_slot_log(impl->logs, index, op, before, status);
+    if (impl->logs)
+        add_slot_log(impl->logs, index, op, before, status);
     if (error)
         dump_slots(impl);
+
+    return status;
 }
 
-static void init_slot_entry(MppBufSlotsImpl *impl, RK_S32 pos, RK_S32 count)
+static MPP_RET init_slot_entry(MppBufSlotsImpl *impl, RK_S32 pos, RK_S32 count)
 {
-    MppBufSlotEntry *slot = impl->slots;
-    for (RK_S32 i = 0; i < count; i++, slot++) {
+    RK_S32 i;
+
+    if (pos + count > SLOT_MAX_COUNT) {
+        mpp_err_f("slot count %d exceed max %d\n", pos + count, SLOT_MAX_COUNT);
+        return MPP_NOK;
+    }
+
+    for (i = pos >> SLOT_GROUP_SHIFT; i <= (pos + count - 1) >> SLOT_GROUP_SHIFT; i++) {
+        if (impl->groups[i])
+            continue;
+
+        impl->groups[i] = mpp_calloc(MppBufSlotEntry, SLOT_GROUP_SIZE);
+        if (NULL == impl->groups[i]) {
+            mpp_err_f("failed to alloc slot group %d\n", i);
+            return MPP_ERR_MALLOC;
+        }
+    }
+
+    for (i = pos; i < pos + count; i++) {
+        MppBufSlotEntry *slot = get_slot(impl, i);
+
         slot->slots = impl;
         INIT_LIST_HEAD(&slot->list);
-        slot->index = pos + i;
+        slot->index = i;
         slot->frame = NULL;
         slot_ops_with_log(impl, slot, SLOT_INIT, NULL);
     }
+
+    return MPP_OK;
 }
 
 /*
@@ -453,16 +582,22 @@ static void init_slot_entry(MppBufSlotsImpl *impl, RK_S32 pos, RK_S32 count)
  * NOTE: MppFrame will be destroyed outside mpp
  *       but MppBuffer must dec_ref here
  */
+static RK_U32 is_entry_unused(SlotStatus status)
+{
+    return status.on_used &&
+           !status.not_ready &&
+           !status.codec_use &&
+           !status.hal_output &&
+           !status.hal_use &&
+           !status.queue_use;
+}
+
+/* called with lock, the free bit is put back after frame and buffer release */
 static void check_entry_unused(MppBufSlotsImpl *impl, MppBufSlotEntry *entry)
 {
     SlotStatus status = entry->status;
 
-    if (status.on_used &&
-        !status.not_ready &&
-        !status.codec_use &&
-        !status.hal_output &&
-        !status.hal_use &&
-        !status.queue_use) {
+    if (is_entry_unused(status)) {
         if (entry->frame) {
             slot_ops_with_log(impl, entry, SLOT_CLR_FRAME, entry->frame);
             mpp_frame_deinit(&entry->frame);
@@ -474,13 +609,13 @@ static void check_entry_unused(MppBufSlotsImpl *impl, MppBufSlotEntry *entry)
         }
 
         slot_ops_with_log(impl, entry, SLOT_CLR_ON_USE, NULL);
-        impl->used_count--;
+        MPP_SUB_FETCH(&impl->used_count, 1);
+        put_free_bit(impl, entry->index);
     }
 }
 
 static void clear_slots_impl(MppBufSlotsImpl *impl)
 {
-    MppBufSlotEntry *slot = (MppBufSlotEntry *)impl->slots;
     RK_S32 i;
 
     for (i = 0; i < (RK_S32)MPP_ARRAY_ELEMS(impl->queue); i++) {
@@ -490,7 +625,9 @@ static void clear_slots_impl(MppBufSlotsImpl *impl)
         mpp_assert(list_empty(&impl->queue[i]));
     }
 
-    for (i = 0; i < impl->buf_count; i++, slot++) {
+    for (i = 0; i < impl->buf_count && impl->groups[i >> SLOT_GROUP_SHIFT]; i++) {
+        MppBufSlotEntry *slot = get_slot(impl, i);
+
         mpp_assert(!slot->status.on_used);
         if (slot->status.on_used) {
             dump_slots(impl);
@@ -512,7 +649,9 @@ static void clear_slots_impl(MppBufSlotsImpl *impl)
     if (impl->lock)
         delete impl->lock;
 
-    mpp_free(impl->slots);
+    for (i = 0; i < SLOT_GROUP_COUNT; i++)
+        MPP_FREE(impl->groups[i]);
+
     mpp_free(impl);
 }
 
@@ -528,7 +667,7 @@ MPP_RET mpp_buf_slot_init(MppBufSlots *slots)
         return MPP_NOK;
     }
 
-    mpp_env_get_u32("buf_slot_debug", &buf_slot_debug, BUF_SLOT_DBG_OPS_HISTORY);
+    mpp_env_get_u32("buf_slot_debug", &buf_slot_debug, 0);
 
     do {
         impl->lock = new Mutex();
@@ -592,18 +731,25 @@ MPP_RET mpp_buf_slot_setup(MppBufSlots slots, RK_S32 count)
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
     AutoMutex auto_lock(impl->lock);
 
-    if (NULL == impl->slots) {
+    if (NULL == impl->groups[0]) {
         // first slot setup
+        if (init_slot_entry(impl, 0, count))
+            return MPP_NOK;
+
         impl->buf_count = impl->new_count = count;
-        impl->slots = mpp_calloc(MppBufSlotEntry, count);
-        init_slot_entry(impl, 0, count);
         impl->used_count = 0;
+        grow_free_bits(impl, 0, count);
+    } else if (count > impl->buf_count) {
+        // grow at once, slot entries do not move so the slots in use are kept
+        RK_S32 old_count = impl->buf_count;
+
+        if (init_slot_entry(impl, old_count, (count - old_count)))
+            return MPP_NOK;
+
+        impl->buf_count = impl->new_count = count;
+        grow_free_bits(impl, old_count, count);
     } else {
         // record the slot count for info changed ready config
-        if (count > impl->buf_count) {
-            mpp_realloc(impl->slots, MppBufSlotEntry, count);
-            init_slot_entry(impl, impl->buf_count, (count - impl->buf_count));
-        }
         impl->new_count = count;
     }
 
@@ -633,22 +779,41 @@ MPP_RET mpp_buf_slot_ready(MppBufSlots slots)
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
     AutoMutex auto_lock(impl->lock);
-    slot_assert(impl, impl->slots);
+    slot_assert(impl, impl->groups[0]);
     if (!impl->info_changed)
         mpp_log("found info change ready set without internal info change\n");
 
     // ready mean the info_set will be copy to info as the new configuration
     if (impl->buf_count != impl->new_count) {
-        mpp_realloc(impl->slots, MppBufSlotEntry, impl->new_count);
-        init_slot_entry(impl, 0, impl->new_count);
+        RK_S32 old_count = impl->buf_count;
+        RK_S32 count = impl->new_count;
+
+        if (count > old_count) {
+            if (init_slot_entry(impl, old_count, count - old_count)) {
+                mpp_err_f("slot %p failed to grow count %d -> %d\n",
+                          impl, old_count, count);
+                return MPP_NOK;
+            }
+
+            impl->buf_count = count;
+            grow_free_bits(impl, old_count, count);
+        } else {
+            // do not shrink below the slots still in use
+            count = shrink_free_bits(impl, count);
+            impl->buf_count = count;
+        }
+
+        buf_slot_dbg(BUF_SLOT_DBG_SETUP, "slot %p count %d -> %d\n",
+                     impl, old_count, count);
     }
-    impl->buf_count = impl->new_count;
 
     mpp_frame_copy(impl->info, impl->info_set);
     impl->buf_size = mpp_frame_get_buf_size(impl->info);
 
     if (impl->logs) {
         mpp_list *logs = impl->logs;
+        AutoMutex log_lock(logs->mutex());
+
         while (logs->list_size())
             logs->del_at_head(NULL, sizeof(MppBufSlotLog));
     }
@@ -688,17 +853,39 @@ MPP_RET mpp_buf_slot_get_unused(MppBufSlots slots, RK_S32 *index)
     }
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
+    RK_S32 i = get_free_bit(impl);
+
+    if (i >= 0) {
+        MppBufSlotEntry *slot = get_slot(impl, i);
+
+        *index = i;
+        slot_ops_with_log(impl, slot, SLOT_SET_ON_USE, NULL);
+        slot_ops_with_log(impl, slot, SLOT_SET_NOT_READY, NULL);
+        MPP_ADD_FETCH(&impl->used_count, 1);
+        return MPP_OK;
+    }
+
     AutoMutex auto_lock(impl->lock);
-    RK_S32 i;
-    MppBufSlotEntry *slot = impl->slots;
-    for (i = 0; i < impl->buf_count; i++, slot++) {
-        if (!slot->status.on_used) {
-            *index = i;
-            slot_ops_with_log(impl, slot, SLOT_SET_ON_USE, NULL);
-            slot_ops_with_log(impl, slot, SLOT_SET_NOT_READY, NULL);
-            impl->used_count++;
-            return MPP_OK;
-        }
+
+    /*
+     * parser may take more than one slot on one frame, eg. missing reference
+     * generation, grow the slot count instead of failure.
+     */
+    i = get_free_bit(impl);
+    if (i < 0 && !init_slot_entry(impl, impl->buf_count, 1)) {
+        i = impl->buf_count++;
+        mpp_log("slots %d all used, grow slot count to %d\n",
+                impl->slots_idx, impl->buf_count);
+    }
+
+    if (i >= 0) {
+        MppBufSlotEntry *slot = get_slot(impl, i);
+
+        *index = i;
+        slot_ops_with_log(impl, slot, SLOT_SET_ON_USE, NULL);
+        slot_ops_with_log(impl, slot, SLOT_SET_NOT_READY, NULL);
+        MPP_ADD_FETCH(&impl->used_count, 1);
+        return MPP_OK;
     }
 
     *index = -1;
@@ -716,9 +903,8 @@ MPP_RET mpp_buf_slot_set_flag(MppBufSlots slots, RK_S32 index, SlotUsageType typ
     }
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
     slot_assert(impl, (index >= 0) && (index < impl->buf_count));
-    slot_ops_with_log(impl, &impl->slots[index], set_flag_op[type], NULL);
+    slot_ops_with_log(impl, get_slot(impl, index), set_flag_op[type], NULL);
     return MPP_OK;
 }
 
@@ -730,15 +916,18 @@ MPP_RET mpp_buf_slot_clr_flag(MppBufSlots slots, RK_S32 index, SlotUsageType typ
     }
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
     slot_assert(impl, (index >= 0) && (index < impl->buf_count));
-    MppBufSlotEntry *slot = &impl->slots[index];
-    slot_ops_with_log(impl, slot, clr_flag_op[type], NULL);
+    MppBufSlotEntry *slot = get_slot(impl, index);
+    SlotStatus status = slot_ops_with_log(impl, slot, clr_flag_op[type], NULL);
 
     if (type == SLOT_HAL_OUTPUT)
-        impl->decode_count++;
+        MPP_ADD_FETCH(&impl->decode_count, 1);
 
-    check_entry_unused(impl, slot);
+    // only the last flag clear releases the slot
+    if (is_entry_unused(status)) {
+        AutoMutex auto_lock(impl->lock);
+        check_entry_unused(impl, slot);
+    }
     return MPP_OK;
 }
 
@@ -752,7 +941,7 @@ MPP_RET mpp_buf_slot_enqueue(MppBufSlots slots, RK_S32 index, SlotQueueType type
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
     AutoMutex auto_lock(impl->lock);
     slot_assert(impl, (index >= 0) && (index < impl->buf_count));
-    MppBufSlotEntry *slot = &impl->slots[index];
+    MppBufSlotEntry *slot = get_slot(impl, index);
     slot_ops_with_log(impl, slot, (MppBufSlotOps)(SLOT_ENQUEUE + type), NULL);
 
     // add slot to display list
@@ -797,7 +986,7 @@ MPP_RET mpp_buf_slot_set_prop(MppBufSlots slots, RK_S32 index, SlotPropType type
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
     AutoMutex auto_lock(impl->lock);
     slot_assert(impl, (index >= 0) && (index < impl->buf_count));
-    MppBufSlotEntry *slot = &impl->slots[index];
+    MppBufSlotEntry *slot = get_slot(impl, index);
     slot_ops_with_log(impl, slot, set_val_op[type], val);
 
     switch (type) {
@@ -887,7 +1076,7 @@ MPP_RET mpp_buf_slot_get_prop(MppBufSlots slots, RK_S32 index, SlotPropType type
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
     AutoMutex auto_lock(impl->lock);
     slot_assert(impl, (index >= 0) && (index < impl->buf_count));
-    MppBufSlotEntry *slot = &impl->slots[index];
+    MppBufSlotEntry *slot = get_slot(impl, index);
 
     switch (type) {
     case SLOT_EOS: {
@@ -934,13 +1123,16 @@ MPP_RET mpp_buf_slot_reset(MppBufSlots slots, RK_S32 index)
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
     AutoMutex auto_lock(impl->lock);
     slot_assert(impl, (index >= 0) && (index < impl->buf_count));
-    MppBufSlotEntry *slot = &impl->slots[index];
+    MppBufSlotEntry *slot = get_slot(impl, index);
 
     // make sure that this slot is just the next display slot
     list_del_init(&slot->list);
     slot_ops_with_log(impl, slot, SLOT_CLR_QUEUE_USE, NULL);
     slot_ops_with_log(impl, slot, SLOT_DEQUEUE, NULL);
-    slot_ops_with_log(impl, slot, SLOT_CLR_ON_USE, NULL);
+    if (slot->status.on_used) {
+        slot_ops_with_log(impl, slot, SLOT_CLR_ON_USE, NULL);
+        put_free_bit(impl, index);
+    }
     return MPP_OK;
 }
 
@@ -954,7 +1146,7 @@ MPP_RET mpp_buf_slot_default_info(MppBufSlots slots, RK_S32 index, void *val)
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
     AutoMutex auto_lock(impl->lock);
     slot_assert(impl, (index >= 0) && (index < impl->buf_count));
-    MppBufSlotEntry *slot = &impl->slots[index];
+    MppBufSlotEntry *slot = get_slot(impl, index);
 
     slot_assert(impl, slot->status.not_ready);
     slot_assert(impl, NULL == slot->frame);
@@ -992,8 +1184,7 @@ RK_S32 mpp_slots_get_used_count(MppBufSlots slots)
         return 0;
     }
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
-    return impl->used_count;
+    return MPP_ADD_FETCH(&impl->used_count, 0);
 }
 
 RK_S32 mpp_slots_get_unused_count(MppBufSlots slots)
@@ -1005,8 +1196,10 @@ RK_S32 mpp_slots_get_unused_count(MppBufSlots slots)
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
     AutoMutex auto_lock(impl->lock);
-    slot_assert(impl, (impl->used_count >= 0) && (impl->used_count <= impl->buf_count));
-    return impl->buf_count - impl->used_count;
+    RK_S32 used_count = MPP_ADD_FETCH(&impl->used_count, 0);
+
+    slot_assert(impl, (used_count >= 0) && (used_count <= impl->buf_count));
+    return impl->buf_count - used_count;
 }
 
 MPP_RET mpp_slots_set_prop(MppBufSlots slots, SlotsPropType type, void *val)
@@ -1039,7 +1232,17 @@ MPP_RET mpp_slots_set_prop(MppBufSlots slots, SlotsPropType type, void *val)
         impl->hal_len_align = (AlignFunc)val;
     } break;
     case SLOTS_COUNT: {
-        impl->buf_count = value;
+        RK_S32 old_count = impl->buf_count;
+
+        if ((RK_S32)value > old_count) {
+            if (init_slot_entry(impl, old_count, value - old_count))
+                return MPP_NOK;
+
+            impl->buf_count = value;
+            grow_free_bits(impl, old_count, value);
+        } else {
+            impl->buf_count = shrink_free_bits(impl, value);
+        }
     } break;
     case SLOTS_SIZE: {
         impl->buf_size = value;
@@ -20,6 +20,7 @@
 
 #include "mpp_log.h"
 #include "mpp_mem.h"
+#include "mpp_dmabuf.h"
 #include "mpp_buffer_impl.h"
 
 MPP_RET mpp_buffer_import_with_tag(MppBufferGroup group, MppBufferInfo *info, MppBuffer *buffer,
@@ -258,6 +259,49 @@ MPP_RET mpp_buffer_set_offset_with_caller(MppBuffer buffer, size_t offset, const
     return MPP_OK;
 }
 
+/* only buffers from dma-buf allocators need cpu access sync */
+static RK_U32 mpp_buffer_is_dmabuf(MppBufferImpl *p)
+{
+    if (p->info.fd < 0)
+        return 0;
+
+    return mpp_allocator_get_type(p->group->allocator) != MPP_BUFFER_TYPE_NORMAL;
+}
+
+static MPP_RET mpp_buffer_sync(MppBuffer buffer, RK_S32 ro, size_t offset, size_t len,
+                               RK_U32 end, const char *caller)
+{
+    if (NULL == buffer) {
+        mpp_err("mpp_buffer_sync invalid NULL input from %s\n", caller);
+        return MPP_ERR_UNKNOW;
+    }
+
+    MppBufferImpl *p = (MppBufferImpl*)buffer;
+    if (offset + len > p->info.size) {
+        mpp_err("mpp_buffer_sync offset %lu len %lu over size %lu from %s\n",
+                (unsigned long)offset, (unsigned long)len,
+                (unsigned long)p->info.size, caller);
+        return MPP_ERR_VALUE;
+    }
+
+    if (!mpp_buffer_is_dmabuf(p))
+        return MPP_OK;
+
+    return (end) ?
+           mpp_dmabuf_sync_end(p->info.fd, ro, offset, len, caller) :
+           mpp_dmabuf_sync_begin(p->info.fd, ro, offset, len, caller);
+}
+
+MPP_RET mpp_buffer_sync_begin_with_caller(MppBuffer buffer, RK_S32 ro, size_t offset, size_t len, const char *caller)
+{
+    return mpp_buffer_sync(buffer, ro, offset, len, 0, caller);
+}
+
+MPP_RET mpp_buffer_sync_end_with_caller(MppBuffer buffer, RK_S32 ro, size_t offset, size_t len, const char *caller)
+{
+    return mpp_buffer_sync(buffer, ro, offset, len, 1, caller);
+}
+
 MPP_RET mpp_buffer_info_get_with_caller(MppBuffer buffer, MppBufferInfo *info, const char *caller)
 {
     if (NULL == buffer || NULL == info) {
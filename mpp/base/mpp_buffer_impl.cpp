@@ -17,16 +17,19 @@
 #define MODULE_TAG "mpp_buffer"
 
 #include <string.h>
+#include <sys/stat.h>
 
 #include "mpp_log.h"
 #include "mpp_mem.h"
 #include "mpp_env.h"
+#include "mpp_atomic.h"
 
 #include "mpp_buffer_impl.h"
 
 #define BUFFER_OPS_MAX_COUNT            1024
-
-#define SEARCH_GROUP_BY_ID(id)  ((MppBufferService::get_instance())->get_group_by_id(id))
+#define BUFFER_IMPORT_CACHE_DEFAULT     16
+#define BUFFER_IMPORT_SIZE_DEFAULT      (SZ_1M * 64)
+#define BUFFER_RETAIN_SIZE_DEFAULT      (SZ_1M * 16)
 
 typedef MPP_RET (*BufferOp)(MppAllocator allocator, MppBufferInfo *data);
 
@@ -86,6 +89,16 @@ private:
     // list for used buffer which do not have group
     struct list_head    mListOrphan;
 
+    // released buffers of misc external group kept for import in LRU order
+    RK_U32              import_max;
+    RK_U32              import_count;
+    RK_U32              import_size_max;
+    size_t              import_size;
+    struct list_head    mListImport;
+
+    // unused buffer size kept by internal group before trimming small ones
+    RK_U32              retain_size;
+
 public:
     static MppBufferService *get_instance() {
         static MppBufferService instance;
@@ -105,6 +118,12 @@ public:
     MppBufferGroupImpl  *get_group_by_id(RK_U32 id);
     void                dump_misc_group();
     RK_U32              is_finalizing();
+
+    RK_U32              check_import(MppBufferGroupImpl *group, MppBufferInfo *info,
+                                     struct stat *st);
+    MppBufferImpl       *get_import(MppBufferInfo *info, struct stat *st);
+    RK_U32              put_import(MppBufferImpl *buffer);
+    void                clear_import(RK_U32 stale_only);
 };
 
 static const char *mode2str[MPP_BUFFER_MODE_BUTT] = {
@@ -117,6 +136,7 @@ static const char *type2str[MPP_BUFFER_TYPE_BUTT] = {
     "ion",
     "dma-buf",
     "drm",
+    "dma-heap",
 };
 static const char *ops2str[BUF_OPS_BUTT] = {
     "grp create ",
@@ -194,29 +214,97 @@ static void buffer_group_dump_log(MppBufferGroupImpl *group)
     }
 }
 
+/*
+ * Buffer lock rule:
+ *
+ * The service lock protects the group list, orphan list, misc groups and the
+ * import cache. Each group has its own lock for its buffer lists, status
+ * record and log. When both are needed the service lock is taken first.
+ *
+ * Reference changes which do not cross 0 / 1 do not touch any list. They are
+ * done with cas on ref_count without lock. Groups with ops log enabled always
+ * go to the locked path to keep the log complete.
+ */
+static RK_U32 buffer_ref_fast(MppBufferImpl *buffer, RK_S32 delta)
+{
+    MppBufferGroupImpl *group = buffer->group;
+    RK_S32 ref = buffer->ref_count;
+
+    if (group->log_runtime_en || group->log_history_en)
+        return 0;
+
+    while (ref > 0 && ref + delta > 0) {
+        RK_S32 old = MPP_VAL_CAS(&buffer->ref_count, ref, ref + delta);
+
+        if (old == ref)
+            return 1;
+
+        ref = old;
+    }
+
+    return 0;
+}
+
+static RK_S32 buffer_size_class(size_t size)
+{
+    RK_S32 cls = 0;
+
+    size >>= MPP_BUF_SIZE_CLASS_SHIFT + 1;
+    while (size && cls < MPP_BUF_SIZE_CLASS_COUNT - 1) {
+        size >>= 1;
+        cls++;
+    }
+
+    return cls;
+}
+
+/* keep each size class sorted and same size buffer in release order */
+static void buffer_unused_add(MppBufferGroupImpl *group, MppBufferImpl *buffer)
+{
+    struct list_head *head = &group->list_unused[buffer_size_class(buffer->info.size)];
+    MppBufferImpl *pos;
+
+    list_for_each_entry(pos, head, MppBufferImpl, list_status) {
+        if (pos->info.size > buffer->info.size)
+            break;
+    }
+
+    list_add_tail(&buffer->list_status, &pos->list_status);
+    group->count_unused++;
+    group->unused_size += buffer->info.size;
+}
+
+static void buffer_unused_del(MppBufferGroupImpl *group, MppBufferImpl *buffer)
+{
+    list_del_init(&buffer->list_status);
+    group->count_unused--;
+    group->unused_size -= buffer->info.size;
+}
+
 static MPP_RET deinit_buffer_no_lock(MppBufferImpl *buffer, const char *caller)
 {
+    MppBufferGroupImpl *group = buffer->group;
+
     if (!MppBufferService::get_instance()->is_finalizing()) {
         mpp_assert(buffer->ref_count == 0);
         mpp_assert(buffer->used == 0);
     }
 
-    list_del_init(&buffer->list_status);
-    MppBufferGroupImpl *group = SEARCH_GROUP_BY_ID(buffer->group_id);
     if (group) {
+        AutoMutex auto_lock(group->lock);
         BufferOp func = (group->mode == MPP_BUFFER_INTERNAL) ?
                         (group->alloc_api->free) :
                         (group->alloc_api->release);
+
+        list_del_init(&buffer->list_status);
         func(group->allocator, &buffer->info);
         group->usage -= buffer->info.size;
         group->buffer_count--;
+        group->free_count++;
 
         buffer_group_add_log(group, buffer, BUF_DESTROY, caller);
-
-        if (group->is_orphan && !group->usage) {
-            MppBufferService::get_instance()->put_group(group);
-        }
     } else {
+        list_del_init(&buffer->list_status);
         mpp_assert(MppBufferService::get_instance()->is_finalizing());
     }
 
@@ -227,25 +315,60 @@ static MPP_RET deinit_buffer_no_lock(MppBufferImpl *buffer, const char *caller)
 
 static MPP_RET inc_buffer_ref_no_lock(MppBufferImpl *buffer, const char *caller)
 {
-    MPP_RET ret = MPP_OK;
-    MppBufferGroupImpl *group = SEARCH_GROUP_BY_ID(buffer->group_id);
+    MppBufferGroupImpl *group = buffer->group;
+    AutoMutex auto_lock(group->lock);
+
     if (!buffer->used) {
-        // NOTE: when increasing ref_count the unused buffer must be under certain group
-        mpp_assert(group);
         buffer->used = 1;
-        if (group) {
-            list_del_init(&buffer->list_status);
-            list_add_tail(&buffer->list_status, &group->list_used);
-            group->count_used++;
-            group->count_unused--;
+        buffer_unused_del(group, buffer);
+        list_add_tail(&buffer->list_status, &group->list_used);
+        group->count_used++;
+    }
+    buffer_group_add_log(group, buffer, BUF_REF_INC, caller);
+    MPP_ADD_FETCH(&buffer->ref_count, 1);
+    return MPP_OK;
+}
+
+/*
+ * Caller should hold service lock for misc group buffer.
+ * release_group is set when the group is an orphan and its last buffer is gone.
+ */
+static MPP_RET dec_buffer_ref_no_lock(MppBufferImpl *buffer, const char *caller,
+                                      RK_U32 *release_group)
+{
+    MppBufferGroupImpl *group = buffer->group;
+    AutoMutex auto_lock(group->lock);
+
+    buffer_group_add_log(group, buffer, BUF_REF_DEC, caller);
+
+    if (buffer->ref_count <= 0) {
+        mpp_err_f("found non-positive ref_count %d caller %s\n",
+                  buffer->ref_count, buffer->caller);
+        mpp_abort();
+        return MPP_NOK;
+    }
+
+    if (MPP_SUB_FETCH(&buffer->ref_count, 1))
+        return MPP_OK;
+
+    buffer->used = 0;
+    list_del_init(&buffer->list_status);
+    group->count_used--;
+    if (group->is_misc) {
+        if (!MppBufferService::get_instance()->put_import(buffer))
+            deinit_buffer_no_lock(buffer, caller);
+    } else {
+        if (buffer->discard) {
+            deinit_buffer_no_lock(buffer, caller);
         } else {
-            mpp_err_f("unused buffer without group\n");
-            ret = MPP_NOK;
+            buffer_unused_add(group, buffer);
         }
     }
-    buffer_group_add_log(group, buffer, BUF_REF_INC, caller);
-    buffer->ref_count++;
-    return ret;
+    if (group->callback)
+        group->callback(group->arg, group);
+
+    *release_group = group->is_orphan && !group->usage;
+    return MPP_OK;
 }
 
 static void dump_buffer_info(MppBufferImpl *buffer)
@@ -255,41 +378,52 @@ static void dump_buffer_info(MppBufferImpl *buffer)
             buffer->ref_count, buffer->discard, buffer->caller);
 }
 
-MPP_RET mpp_buffer_create(const char *tag, const char *caller,
-                          MppBufferGroupImpl *group, MppBufferInfo *info,
-                          MppBufferImpl **buffer)
+static MPP_RET create_buffer_no_lock(const char *tag, const char *caller,
+                                     MppBufferGroupImpl *group, MppBufferInfo *info,
+                                     MppBufferImpl **buffer)
 {
-    AutoMutex auto_lock(MppBufferService::get_lock());
-    MPP_BUF_FUNCTION_ENTER();
-
+    AutoMutex auto_lock(group->lock);
     MPP_RET ret = MPP_OK;
     BufferOp func = NULL;
     MppBufferImpl *p = NULL;
-
-    if (NULL == group) {
-        mpp_err_f("can not create buffer without group\n");
-        ret = MPP_NOK;
-        goto RET;
-    }
+    MppBufferService *srv = MppBufferService::get_instance();
+    RK_U32 import_cached = 0;
+    RK_S32 import_fd = info->fd;
+    struct stat st;
 
     if (group->limit_count && group->buffer_count >= group->limit_count) {
         if (group->log_runtime_en)
             mpp_log_f("group %d reach count limit %d\n", group->group_id, group->limit_count);
-        ret = MPP_NOK;
-        goto RET;
+        return MPP_NOK;
     }
 
     if (group->limit_size && info->size > group->limit_size) {
         mpp_err_f("required size %d reach group size limit %d\n", info->size, group->limit_size);
-        ret = MPP_NOK;
-        goto RET;
+        return MPP_NOK;
+    }
+
+    if (buffer && group->is_misc)
+        import_cached = srv->check_import(group, info, &st);
+
+    if (import_cached) {
+        p = srv->get_import(info, &st);
+        if (p) {
+            *info = p->info;
+            p->caller = caller;
+            buffer_group_add_log(group, p, BUF_COMMIT, caller);
+            inc_buffer_ref_no_lock(p, caller);
+            *buffer = p;
+            return MPP_OK;
+        }
+
+        /* a new file comes in drop the closed ones */
+        srv->clear_import(1);
     }
 
     p = mpp_calloc(MppBufferImpl, 1);
     if (NULL == p) {
         mpp_err_f("failed to allocate context\n");
-        ret = MPP_ERR_MALLOC;
-        goto RET;
+        return MPP_ERR_MALLOC;
     }
 
     func = (group->mode == MPP_BUFFER_INTERNAL) ?
@@ -298,8 +432,7 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
     if (MPP_OK != ret) {
         mpp_err_f("failed to create buffer with size %d\n", info->size);
         mpp_free(p);
-        ret = MPP_ERR_MALLOC;
-        goto RET;
+        return MPP_ERR_MALLOC;
     }
 
     p->info = *info;
@@ -311,14 +444,21 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
     strncpy(p->tag, tag, sizeof(p->tag));
     p->caller = caller;
     p->group_id = group->group_id;
+    p->group = group;
     p->buffer_id = group->buffer_id;
+    if (import_cached) {
+        p->import_cached = 1;
+        p->import_fd = import_fd;
+        p->import_dev = st.st_dev;
+        p->import_ino = st.st_ino;
+    }
     INIT_LIST_HEAD(&p->list_status);
-    list_add_tail(&p->list_status, &group->list_unused);
+    buffer_unused_add(group, p);
 
     group->buffer_id++;
     group->usage += info->size;
     group->buffer_count++;
-    group->count_unused++;
+    group->alloc_count++;
 
     buffer_group_add_log(group, p,
                          (group->mode == MPP_BUFFER_INTERNAL) ? (BUF_CREATE) : (BUF_COMMIT),
@@ -331,20 +471,42 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
 
     if (group->callback)
         group->callback(group->arg, group);
-RET:
+
+    return ret;
+}
+
+MPP_RET mpp_buffer_create(const char *tag, const char *caller,
+                          MppBufferGroupImpl *group, MppBufferInfo *info,
+                          MppBufferImpl **buffer)
+{
+    MPP_BUF_FUNCTION_ENTER();
+
+    MPP_RET ret = MPP_OK;
+
+    if (NULL == group) {
+        mpp_err_f("can not create buffer without group\n");
+        ret = MPP_NOK;
+    } else if (group->is_misc) {
+        // misc group may reuse buffer from import cache
+        AutoMutex auto_lock(MppBufferService::get_lock());
+        ret = create_buffer_no_lock(tag, caller, group, info, buffer);
+    } else {
+        ret = create_buffer_no_lock(tag, caller, group, info, buffer);
+    }
+
     MPP_BUF_FUNCTION_LEAVE();
     return ret;
 }
 
 MPP_RET mpp_buffer_mmap(MppBufferImpl *buffer, const char* caller)
 {
-    AutoMutex auto_lock(MppBufferService::get_lock());
+    MppBufferGroupImpl *group = buffer->group;
+    AutoMutex auto_lock(group->lock);
     MPP_BUF_FUNCTION_ENTER();
 
     MPP_RET ret = MPP_NOK;
-    MppBufferGroupImpl *group = SEARCH_GROUP_BY_ID(buffer->group_id);
 
-    if (group && group->alloc_api && group->alloc_api->mmap) {
+    if (group->alloc_api && group->alloc_api->mmap) {
         ret = group->alloc_api->mmap(group->allocator, &buffer->info);
 
         buffer_group_add_log(group, buffer, BUF_MMAP, caller);
@@ -360,10 +522,12 @@ MPP_RET mpp_buffer_mmap(MppBufferImpl *buffer, const char* caller)
 
 MPP_RET mpp_buffer_ref_inc(MppBufferImpl *buffer, const char* caller)
 {
-    AutoMutex auto_lock(MppBufferService::get_lock());
     MPP_BUF_FUNCTION_ENTER();
 
-    MPP_RET ret = inc_buffer_ref_no_lock(buffer, caller);
+    MPP_RET ret = MPP_OK;
+
+    if (!buffer_ref_fast(buffer, 1))
+        ret = inc_buffer_ref_no_lock(buffer, caller);
 
     MPP_BUF_FUNCTION_LEAVE();
     return ret;
@@ -372,74 +536,116 @@ MPP_RET mpp_buffer_ref_inc(MppBufferImpl *buffer, const char* caller)
 
 MPP_RET mpp_buffer_ref_dec(MppBufferImpl *buffer, const char* caller)
 {
-    AutoMutex auto_lock(MppBufferService::get_lock());
     MPP_BUF_FUNCTION_ENTER();
 
     MPP_RET ret = MPP_OK;
-    MppBufferGroupImpl *group = SEARCH_GROUP_BY_ID(buffer->group_id);
-    if (group)
-        buffer_group_add_log(group, buffer, BUF_REF_DEC, caller);
+    MppBufferGroupImpl *group = buffer->group;
+    RK_U32 release_group = 0;
 
-    if (buffer->ref_count <= 0) {
-        mpp_err_f("found non-positive ref_count %d caller %s\n",
-                  buffer->ref_count, buffer->caller);
-        mpp_abort();
-        ret = MPP_NOK;
+    if (buffer_ref_fast(buffer, -1)) {
+        MPP_BUF_FUNCTION_LEAVE();
+        return ret;
+    }
+
+    if (group->is_misc) {
+        // released misc buffer may go to import cache
+        AutoMutex auto_lock(MppBufferService::get_lock());
+        ret = dec_buffer_ref_no_lock(buffer, caller, &release_group);
     } else {
-        buffer->ref_count--;
-        if (0 == buffer->ref_count) {
-            buffer->used = 0;
-            list_del_init(&buffer->list_status);
-            if (group == MppBufferService::get_instance()->get_misc(group->mode, group->type)) {
-                deinit_buffer_no_lock(buffer, caller);
-            } else {
-                if (buffer->discard) {
-                    deinit_buffer_no_lock(buffer, caller);
-                } else {
-                    list_add_tail(&buffer->list_status, &group->list_unused);
-                    group->count_unused++;
-                }
-            }
-            group->count_used--;
-            if (group->callback)
-                group->callback(group->arg, group);
-        }
+        ret = dec_buffer_ref_no_lock(buffer, caller, &release_group);
+    }
+
+    // no buffer is left in the orphan group so nobody else can access it
+    if (release_group) {
+        AutoMutex auto_lock(MppBufferService::get_lock());
+        MppBufferService::get_instance()->put_group(group);
     }
 
     MPP_BUF_FUNCTION_LEAVE();
     return ret;
 }
 
+/*
+ * Internal group keeps unused buffers smaller than the request until it is
+ * under memory pressure: unused size over retain size, usage over the group
+ * limit or buffer count reaching the count limit.
+ */
+static RK_U32 buffer_group_pressure(MppBufferGroupImpl *p, size_t size)
+{
+    if (p->unused_size > p->retain_size)
+        return 1;
+
+    if (p->usage + size > p->limit)
+        return 1;
+
+    if (p->limit_count && p->buffer_count >= p->limit_count)
+        return 1;
+
+    return 0;
+}
+
+static void buffer_group_trim(MppBufferGroupImpl *p, size_t size)
+{
+    RK_S32 i;
+
+    for (i = 0; i < MPP_BUF_SIZE_CLASS_COUNT; i++) {
+        MppBufferImpl *pos, *n;
+
+        list_for_each_entry_safe(pos, n, &p->list_unused[i], MppBufferImpl, list_status) {
+            if (pos->info.size >= size || !buffer_group_pressure(p, size))
+                return;
+
+            buffer_unused_del(p, pos);
+            deinit_buffer_no_lock(pos, __FUNCTION__);
+            p->trim_count++;
+        }
+    }
+}
+
+static void buffer_group_clear_unused(MppBufferGroupImpl *p, const char *caller)
+{
+    RK_S32 i;
+
+    for (i = 0; i < MPP_BUF_SIZE_CLASS_COUNT; i++) {
+        MppBufferImpl *pos, *n;
+
+        list_for_each_entry_safe(pos, n, &p->list_unused[i], MppBufferImpl, list_status) {
+            buffer_unused_del(p, pos);
+            deinit_buffer_no_lock(pos, caller);
+        }
+    }
+}
+
 MppBufferImpl *mpp_buffer_get_unused(MppBufferGroupImpl *p, size_t size)
 {
-    AutoMutex auto_lock(MppBufferService::get_lock());
+    AutoMutex auto_lock(p->lock);
     MPP_BUF_FUNCTION_ENTER();
 
     MppBufferImpl *buffer = NULL;
+    RK_S32 i;
 
-    if (!list_empty(&p->list_unused)) {
-        MppBufferImpl *pos, *n;
-        RK_S32 found = 0;
-        RK_S32 search_count = 0;
+    // first buffer not smaller than size in the sorted class lists is the best fit
+    for (i = buffer_size_class(size); i < MPP_BUF_SIZE_CLASS_COUNT && !buffer; i++) {
+        MppBufferImpl *pos;
 
-        list_for_each_entry_safe(pos, n, &p->list_unused, MppBufferImpl, list_status) {
+        list_for_each_entry(pos, &p->list_unused[i], MppBufferImpl, list_status) {
             mpp_buf_dbg(MPP_BUF_DBG_CHECK_SIZE, "request size %d on buf idx %d size %d\n",
                         size, pos->buffer_id, pos->info.size);
             if (pos->info.size >= size) {
                 buffer = pos;
-                inc_buffer_ref_no_lock(buffer, __FUNCTION__);
-                found = 1;
                 break;
-            } else {
-                if (MPP_BUFFER_INTERNAL == p->mode) {
-                    deinit_buffer_no_lock(pos, __FUNCTION__);
-                    p->count_unused--;
-                } else
-                    search_count++;
             }
         }
+    }
 
-        if (!found && search_count)
+    if (buffer) {
+        inc_buffer_ref_no_lock(buffer, __FUNCTION__);
+        p->hit_count++;
+    } else {
+        p->miss_count++;
+        if (MPP_BUFFER_INTERNAL == p->mode)
+            buffer_group_trim(p, size);
+        else if (p->count_unused)
             mpp_err_f("can not found match buffer with size larger than %d\n", size);
     }
 
@@ -503,12 +709,13 @@ MPP_RET mpp_buffer_group_deinit(MppBufferGroupImpl *p)
 
 MPP_RET mpp_buffer_group_reset(MppBufferGroupImpl *p)
 {
-    AutoMutex auto_lock(MppBufferService::get_lock());
     if (NULL == p) {
         mpp_err_f("found NULL pointer\n");
         return MPP_ERR_NULL_PTR;
     }
 
+    AutoMutex auto_lock(p->lock);
+
     MPP_BUF_FUNCTION_ENTER();
 
     buffer_group_add_log(p, NULL, GRP_RESET, NULL);
@@ -522,13 +729,7 @@ MPP_RET mpp_buffer_group_reset(MppBufferGroupImpl *p)
     }
 
     // remove unused list
-    if (!list_empty(&p->list_unused)) {
-        MppBufferImpl *pos, *n;
-        list_for_each_entry_safe(pos, n, &p->list_unused, MppBufferImpl, list_status) {
-            deinit_buffer_no_lock(pos, __FUNCTION__);
-            p->count_unused--;
-        }
-    }
+    buffer_group_clear_unused(p, __FUNCTION__);
 
     MPP_BUF_FUNCTION_LEAVE();
     return MPP_OK;
@@ -537,12 +738,13 @@ MPP_RET mpp_buffer_group_reset(MppBufferGroupImpl *p)
 MPP_RET mpp_buffer_group_set_callback(MppBufferGroupImpl *p,
                                       MppBufCallback callback, void *arg)
 {
-    AutoMutex auto_lock(MppBufferService::get_lock());
     if (NULL == p) {
         mpp_err_f("found NULL pointer\n");
         return MPP_ERR_NULL_PTR;
     }
 
+    AutoMutex auto_lock(p->lock);
+
     MPP_BUF_FUNCTION_ENTER();
 
     p->callback = callback;
@@ -554,22 +756,33 @@ MPP_RET mpp_buffer_group_set_callback(MppBufferGroupImpl *p,
 
 void mpp_buffer_group_dump(MppBufferGroupImpl *group, const char *caller)
 {
+    AutoMutex auto_lock(group->lock);
+
     mpp_log("\ndumping buffer group %p id %d from %s\n", group,
             group->group_id, caller);
     mpp_log("mode %s\n", mode2str[group->mode]);
     mpp_log("type %s\n", type2str[group->type]);
     mpp_log("limit size %d count %d\n", group->limit_size, group->limit_count);
 
+    mpp_log("churn alloc %d free %d trim %d hit %d miss %d\n",
+            group->alloc_count, group->free_count, group->trim_count,
+            group->hit_count, group->miss_count);
+
     mpp_log("used buffer count %d\n", group->count_used);
 
     MppBufferImpl *pos, *n;
+    RK_S32 i;
+
     list_for_each_entry_safe(pos, n, &group->list_used, MppBufferImpl, list_status) {
         dump_buffer_info(pos);
     }
 
-    mpp_log("unused buffer count %d\n", group->count_unused);
-    list_for_each_entry_safe(pos, n, &group->list_unused, MppBufferImpl, list_status) {
-        dump_buffer_info(pos);
+    mpp_log("unused buffer count %d size %lu retain %lu\n", group->count_unused,
+            (unsigned long)group->unused_size, (unsigned long)group->retain_size);
+    for (i = 0; i < MPP_BUF_SIZE_CLASS_COUNT; i++) {
+        list_for_each_entry_safe(pos, n, &group->list_unused[i], MppBufferImpl, list_status) {
+            dump_buffer_info(pos);
+        }
     }
 
     buffer_group_dump_log(group);
@@ -592,7 +805,8 @@ MppBufferGroupImpl *mpp_buffer_get_misc_group(MppBufferMode mode, MppBufferType
         offset += snprintf(tag + offset, sizeof(tag) - offset, "misc");
         offset += snprintf(tag + offset, sizeof(tag) - offset, "_%s",
                            type == MPP_BUFFER_TYPE_ION ? "ion" :
-                           type == MPP_BUFFER_TYPE_DRM ? "drm" : "na");
+                           type == MPP_BUFFER_TYPE_DRM ? "drm" :
+                           type == MPP_BUFFER_TYPE_DMA_HEAP ? "dmh" : "na");
         offset += snprintf(tag + offset, sizeof(tag) - offset, "_%s",
                            mode == MPP_BUFFER_INTERNAL ? "int" : "ext");
 
@@ -606,12 +820,25 @@ MppBufferService::MppBufferService()
       group_count(0),
       finalizing(0),
       finished(0),
-      misc_count(0)
+      misc_count(0),
+      import_max(0),
+      import_count(0),
+      import_size_max(0),
+      import_size(0),
+      retain_size(0)
 {
     RK_S32 i, j;
 
     INIT_LIST_HEAD(&mListGroup);
     INIT_LIST_HEAD(&mListOrphan);
+    INIT_LIST_HEAD(&mListImport);
+
+    mpp_env_get_u32("mpp_buffer_import_cache", &import_max,
+                    BUFFER_IMPORT_CACHE_DEFAULT);
+    mpp_env_get_u32("mpp_buffer_import_cache_size", &import_size_max,
+                    BUFFER_IMPORT_SIZE_DEFAULT);
+    mpp_env_get_u32("mpp_buffer_retain_size", &retain_size,
+                    BUFFER_RETAIN_SIZE_DEFAULT);
 
     // NOTE: Do not create misc group at beginning. Only create on when needed.
     for (i = 0; i < MPP_BUFFER_MODE_BUTT; i++)
@@ -625,6 +852,8 @@ MppBufferService::~MppBufferService()
 
     finalizing = 1;
 
+    clear_import(0);
+
     // first remove legacy group which is the normal case
     if (misc_count) {
         mpp_log_f("cleaning misc group\n");
@@ -677,17 +906,26 @@ MppBufferGroupImpl *MppBufferService::get_group(const char *tag, const char *cal
 {
     MppBufferType buffer_type = (MppBufferType)(type & MPP_BUFFER_TYPE_MASK);
     MppBufferGroupImpl *p = mpp_calloc(MppBufferGroupImpl, 1);
+    RK_S32 i;
     if (NULL == p) {
         mpp_err("MppBufferService failed to allocate group context\n");
         return NULL;
     }
 
+    p->lock = new Mutex();
+    if (NULL == p->lock) {
+        mpp_err("MppBufferService failed to create group lock\n");
+        mpp_free(p);
+        return NULL;
+    }
+
     RK_U32 id = get_group_id();
 
     INIT_LIST_HEAD(&p->list_logs);
     INIT_LIST_HEAD(&p->list_group);
     INIT_LIST_HEAD(&p->list_used);
-    INIT_LIST_HEAD(&p->list_unused);
+    for (i = 0; i < MPP_BUF_SIZE_CLASS_COUNT; i++)
+        INIT_LIST_HEAD(&p->list_unused[i]);
 
     mpp_env_get_u32("mpp_buffer_debug", &mpp_buffer_debug, 0);
     p->log_runtime_en   = (mpp_buffer_debug & MPP_BUF_DBG_OPS_RUNTIME) ? (1) : (0);
@@ -704,6 +942,7 @@ MppBufferGroupImpl *MppBufferService::get_group(const char *tag, const char *cal
     p->mode     = mode;
     p->type     = buffer_type;
     p->limit    = BUFFER_GROUP_SIZE_DEFAULT;
+    p->retain_size = retain_size;
     p->group_id = id;
     p->clear_on_exit = (mpp_buffer_debug & MPP_BUF_DBG_CLR_ON_EXIT) ? (1) : (0);
 
@@ -717,6 +956,7 @@ MppBufferGroupImpl *MppBufferService::get_group(const char *tag, const char *cal
     if (is_misc) {
         misc[mode][buffer_type] = p;
         misc_count++;
+        p->is_misc = 1;
     }
 
     return p;
@@ -748,55 +988,59 @@ void MppBufferService::set_misc(MppBufferMode mode, MppBufferType type, MppBuffe
 
 void MppBufferService::put_group(MppBufferGroupImpl *p)
 {
+    RK_U32 destroy = 0;
+
     if (finished)
         return ;
 
-    buffer_group_add_log(p, NULL, GRP_RELEASE, __FUNCTION__);
+    {
+        AutoMutex auto_lock(p->lock);
 
-    // remove unused list
-    if (!list_empty(&p->list_unused)) {
-        MppBufferImpl *pos, *n;
-        list_for_each_entry_safe(pos, n, &p->list_unused, MppBufferImpl, list_status) {
-            deinit_buffer_no_lock(pos, __FUNCTION__);
-            p->count_unused--;
-        }
-    }
+        buffer_group_add_log(p, NULL, GRP_RELEASE, __FUNCTION__);
 
-    if (list_empty(&p->list_used)) {
-        destroy_group(p);
-    } else {
-        if (!finalizing ||
-            (finalizing && (mpp_buffer_debug & MPP_BUF_DBG_DUMP_ON_EXIT))) {
-            mpp_err("mpp_group %p tag %s caller %s mode %s type %s deinit with %d bytes not released\n",
-                    p, p->tag, p->caller, mode2str[p->mode], type2str[p->type], p->usage);
+        // remove unused list
+        buffer_group_clear_unused(p, __FUNCTION__);
 
-            mpp_buffer_group_dump(p, __FUNCTION__);
-        }
+        if (list_empty(&p->list_used)) {
+            destroy = 1;
+        } else {
+            if (!finalizing ||
+                (finalizing && (mpp_buffer_debug & MPP_BUF_DBG_DUMP_ON_EXIT))) {
+                mpp_err("mpp_group %p tag %s caller %s mode %s type %s deinit with %d bytes not released\n",
+                        p, p->tag, p->caller, mode2str[p->mode], type2str[p->type], p->usage);
 
-        /* if clear on exit we need to release remaining buffer */
-        if (p->clear_on_exit) {
-            MppBufferImpl *pos, *n;
+                mpp_buffer_group_dump(p, __FUNCTION__);
+            }
 
-            mpp_err("force release all remaining buffer\n");
+            /* if clear on exit we need to release remaining buffer */
+            if (p->clear_on_exit) {
+                MppBufferImpl *pos, *n;
 
-            list_for_each_entry_safe(pos, n, &p->list_used, MppBufferImpl, list_status) {
-                mpp_err("clearing buffer %p\n", pos);
-                pos->ref_count = 0;
-                pos->used = 0;
-                pos->discard = 0;
-                deinit_buffer_no_lock(pos, __FUNCTION__);
-                p->count_used--;
-            }
+                mpp_err("force release all remaining buffer\n");
 
-            destroy_group(p);
-        } else {
-            // otherwise move the group to list_orphan and wait for buffer release
-            buffer_group_add_log(p, NULL, GRP_ORPHAN, __FUNCTION__);
-            list_del_init(&p->list_group);
-            list_add_tail(&p->list_group, &mListOrphan);
-            p->is_orphan = 1;
+                list_for_each_entry_safe(pos, n, &p->list_used, MppBufferImpl, list_status) {
+                    mpp_err("clearing buffer %p\n", pos);
+                    pos->ref_count = 0;
+                    pos->used = 0;
+                    pos->discard = 0;
+                    deinit_buffer_no_lock(pos, __FUNCTION__);
+                    p->count_used--;
+                }
+
+                destroy = 1;
+            } else {
+                // otherwise move the group to list_orphan and wait for buffer release
+                buffer_group_add_log(p, NULL, GRP_ORPHAN, __FUNCTION__);
+                list_del_init(&p->list_group);
+                list_add_tail(&p->list_group, &mListOrphan);
+                p->is_orphan = 1;
+            }
         }
     }
+
+    // group without buffer can only be accessed by service
+    if (destroy)
+        destroy_group(p);
 }
 
 void MppBufferService::destroy_group(MppBufferGroupImpl *group)
@@ -829,6 +1073,7 @@ void MppBufferService::destroy_group(MppBufferGroupImpl *group)
     mpp_assert(group->allocator);
     mpp_allocator_put(&group->allocator);
     list_del_init(&group->list_group);
+    delete group->lock;
     mpp_free(group);
     group_count--;
 
@@ -872,3 +1117,120 @@ RK_U32 MppBufferService::is_finalizing()
     return finalizing;
 }
 
+
+/*
+ * Import cache
+ *
+ * Camera and display pipelines pass the same small ring of dma-buf fds to the
+ * encoder again and again. Each import costs import / map ioctls, a mmap on
+ * first access and the same again on release. Buffers imported into the misc
+ * external group are kept in an LRU list when the last reference is released
+ * and reused when the same fd comes back.
+ *
+ * An fd number can be reused by another file after close, so the key also
+ * has the device and inode of the file. Kernels before 5.3 share one
+ * anonymous inode with zero size among all dma-bufs, so caching is only done
+ * when the file reports its own size. Entries whose fd is closed or points to
+ * another file are dropped when a buffer is released to the cache or a new
+ * file is imported. Both the entry count and the total size kept are bounded.
+ */
+RK_U32 MppBufferService::check_import(MppBufferGroupImpl *group, MppBufferInfo *info,
+                                      struct stat *st)
+{
+    if (!import_max || finalizing)
+        return 0;
+
+    if (group->mode != MPP_BUFFER_EXTERNAL || group != get_misc(group->mode, group->type))
+        return 0;
+
+    if (info->fd < 0 || info->ptr || info->size > import_size_max)
+        return 0;
+
+    if (fstat(info->fd, st) || st->st_size <= 0)
+        return 0;
+
+    return 1;
+}
+
+MppBufferImpl *MppBufferService::get_import(MppBufferInfo *info, struct stat *st)
+{
+    MppBufferImpl *pos, *n;
+
+    list_for_each_entry_safe(pos, n, &mListImport, MppBufferImpl, list_status) {
+        if (pos->import_fd == info->fd &&
+            pos->import_dev == (RK_U64)st->st_dev &&
+            pos->import_ino == (RK_U64)st->st_ino &&
+            pos->info.type == info->type &&
+            pos->info.size == info->size) {
+            list_del_init(&pos->list_status);
+            import_count--;
+            import_size -= pos->info.size;
+            return pos;
+        }
+    }
+
+    return NULL;
+}
+
+RK_U32 MppBufferService::put_import(MppBufferImpl *buffer)
+{
+    MppBufferGroupImpl *group = buffer->group;
+
+    if (!buffer->import_cached || buffer->discard || finalizing || NULL == group)
+        return 0;
+
+    list_add_tail(&buffer->list_status, &mListImport);
+    group->count_unused++;
+    group->unused_size += buffer->info.size;
+    import_count++;
+    import_size += buffer->info.size;
+
+    /* drop entries whose fd is closed, the released one included */
+    clear_import(1);
+
+    /* cached buffers pin the external memory, bound both count and size */
+    while (import_count > import_max || import_size > import_size_max) {
+        MppBufferImpl *lru = list_entry(mListImport.next, MppBufferImpl, list_status);
+
+        list_del_init(&lru->list_status);
+        import_count--;
+        import_size -= lru->info.size;
+        group = lru->group;
+        {
+            AutoMutex auto_lock(group->lock);
+
+            buffer_unused_del(group, lru);
+            deinit_buffer_no_lock(lru, __FUNCTION__);
+        }
+    }
+
+    return 1;
+}
+
+void MppBufferService::clear_import(RK_U32 stale_only)
+{
+    MppBufferImpl *pos, *n;
+
+    list_for_each_entry_safe(pos, n, &mListImport, MppBufferImpl, list_status) {
+        MppBufferGroupImpl *group = pos->group;
+
+        if (stale_only) {
+            struct stat st;
+
+            if (!fstat(pos->import_fd, &st) &&
+                pos->import_dev == (RK_U64)st.st_dev &&
+                pos->import_ino == (RK_U64)st.st_ino)
+                continue;
+        }
+
+        list_del_init(&pos->list_status);
+        import_count--;
+        import_size -= pos->info.size;
+        {
+            AutoMutex auto_lock(group->lock);
+
+            buffer_unused_del(group, pos);
+            deinit_buffer_no_lock(pos, __FUNCTION__);
+        }
+    }
+}
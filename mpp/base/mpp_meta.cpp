@@ -20,6 +20,7 @@
 
 #include "mpp_mem.h"
 #include "mpp_list.h"
+#include "mpp_mem_pool.h"
 
 #include "mpp_meta_impl.h"
 
@@ -36,6 +37,7 @@ static MppMetaDef meta_defs[] = {
     {   KEY_HDR_INFO,           TYPE_BUFFER,    },
 
     {   KEY_OUTPUT_INTRA,       TYPE_S32,       },
+    {   KEY_OUTPUT_REENC,       TYPE_S32,       },
     {   KEY_INPUT_BLOCK,        TYPE_S32,       },
     {   KEY_OUTPUT_BLOCK,       TYPE_S32,       },
 
@@ -72,6 +74,9 @@ private:
     RK_U32              node_count;
     RK_U32              finished;
 
+    MppMemPool          pool_meta;
+    MppMemPool          pool_node;
+
 public:
     static MppMetaService *get_instance() {
         static MppMetaService instance;
@@ -98,6 +103,7 @@ public:
     void          put_node(MppMetaNode *node);
     MppMetaNode  *find_node(MppMetaImpl *meta, RK_S32 index);
     MppMetaNode  *next_node(MppMetaImpl *meta);
+    void          free_node(MppMetaNode *node);
 };
 
 MppMetaService::MppMetaService()
@@ -108,6 +114,9 @@ MppMetaService::MppMetaService()
 {
     INIT_LIST_HEAD(&mlist_meta);
     INIT_LIST_HEAD(&mlist_node);
+
+    pool_meta = mpp_mem_pool_init("mpp_meta", sizeof(MppMetaImpl));
+    pool_node = mpp_mem_pool_init("mpp_meta_node", sizeof(MppMetaNode));
 }
 
 MppMetaService::~MppMetaService()
@@ -149,7 +158,7 @@ RK_S32 MppMetaService::get_index_of_key(MppMetaKey key, MppMetaType type)
 
 MppMetaImpl *MppMetaService::get_meta(const char *tag, const char *caller)
 {
-    MppMetaImpl *impl = mpp_malloc(MppMetaImpl, 1);
+    MppMetaImpl *impl = (MppMetaImpl *)mpp_mem_pool_get(pool_meta);
     if (impl) {
         const char *tag_src = (tag) ? (tag) : (MODULE_TAG);
         strncpy(impl->tag, tag_src, sizeof(impl->tag));
@@ -187,7 +196,7 @@ void MppMetaService::put_meta(MppMetaImpl *meta)
     mpp_assert(meta->node_count == 0);
     list_del_init(&meta->list_meta);
     meta_count--;
-    mpp_free(meta);
+    mpp_mem_pool_put(pool_meta, meta);
 }
 
 void MppMetaService::inc_ref(MppMetaImpl *meta)
@@ -231,7 +240,7 @@ MppMetaNode *MppMetaService::get_node(MppMetaImpl *meta, RK_S32 type_id)
     MppMetaNode *node = find_node(meta, type_id);
 
     if (NULL == node) {
-        node = mpp_malloc(MppMetaNode, 1);
+        node = (MppMetaNode *)mpp_mem_pool_get(pool_node);
         if (node) {
             INIT_LIST_HEAD(&node->list_meta);
             INIT_LIST_HEAD(&node->list_node);
@@ -273,7 +282,12 @@ void MppMetaService::put_node(MppMetaNode *node)
     default : {
     } break;
     }
-    mpp_free(node);
+    free_node(node);
+}
+
+void MppMetaService::free_node(MppMetaNode *node)
+{
+    mpp_mem_pool_put(pool_node, node);
 }
 
 MPP_RET mpp_meta_get_with_tag(MppMeta *meta, const char *tag, const char *caller)
@@ -345,6 +359,12 @@ MppMetaNode *mpp_meta_next_node(MppMeta meta)
     return node;
 }
 
+void mpp_meta_free_node(MppMetaNode *node)
+{
+    if (node)
+        MppMetaService::get_instance()->free_node(node);
+}
+
 static MPP_RET set_val_by_key(MppMetaImpl *meta, MppMetaKey key, MppMetaType type, MppMetaVal *val)
 {
     MPP_RET ret = MPP_NOK;
@@ -20,6 +20,7 @@
 
 #include "mpp_log.h"
 #include "mpp_mem.h"
+#include "mpp_mem_pool.h"
 #include "mpp_packet_impl.h"
 #include "mpp_meta_impl.h"
 
@@ -28,6 +29,12 @@ static const char *module_name = MODULE_TAG;
 #define setup_mpp_packet_name(packet) \
     ((MppPacketImpl*)packet)->name = module_name;
 
+static MppMemPool get_packet_pool()
+{
+    static MppMemPool pool = mpp_mem_pool_init(module_name, sizeof(MppPacketImpl));
+    return pool;
+}
+
 MPP_RET check_is_mpp_packet(void *packet)
 {
     if (packet && ((MppPacketImpl*)packet)->name == module_name)
@@ -45,7 +52,7 @@ MPP_RET mpp_packet_new(MppPacket *packet)
         return MPP_ERR_NULL_PTR;
     }
 
-    MppPacketImpl *p = mpp_calloc(MppPacketImpl, 1);
+    MppPacketImpl *p = (MppPacketImpl *)mpp_mem_pool_get(get_packet_pool());
     *packet = p;
     if (NULL == p) {
         mpp_err_f("malloc failed\n");
@@ -96,7 +103,27 @@ MPP_RET mpp_packet_init_with_buffer(MppPacket *packet, MppBuffer buffer)
     return MPP_OK;
 }
 
-MPP_RET mpp_packet_copy_init(MppPacket *packet, const MppPacket src)
+MPP_RET mpp_packet_init_with_release(MppPacket *packet, void *data, size_t size,
+                                     MppPacketReleaseCb release, void *ctx)
+{
+    if (NULL == packet || NULL == release) {
+        mpp_err_f("invalid input packet %p release %p\n", packet, release);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    MPP_RET ret = mpp_packet_init(packet, data, size);
+    if (ret)
+        return ret;
+
+    MppPacketImpl *p = (MppPacketImpl *)*packet;
+    p->flag |= MPP_PACKET_FLAG_EXTERNAL;
+    p->release = release;
+    p->release_ctx = ctx;
+
+    return MPP_OK;
+}
+
+static MPP_RET packet_dup_init(MppPacket *packet, MppPacket src, RK_U32 move)
 {
     if (NULL == packet || check_is_mpp_packet(src)) {
         mpp_err_f("found invalid input %p %p\n", packet, src);
@@ -121,6 +148,14 @@ MPP_RET mpp_packet_copy_init(MppPacket *packet, const MppPacket src)
     if (src_impl->buffer) {
         /* if source packet has buffer just create a new reference to buffer */
         mpp_buffer_inc_ref(src_impl->buffer);
+    } else if (move && (src_impl->flag & MPP_PACKET_FLAG_EXTERNAL)) {
+        /*
+         * if source packet memory is lent by user just move the release
+         * responsibility to the new packet and skip the copy
+         */
+        src_impl->flag &= ~MPP_PACKET_FLAG_EXTERNAL;
+        src_impl->release = NULL;
+        src_impl->release_ctx = NULL;
     } else {
         /*
          * NOTE: only copy valid data
@@ -140,7 +175,10 @@ MPP_RET mpp_packet_copy_init(MppPacket *packet, const MppPacket src)
         MppPacketImpl *p = (MppPacketImpl *)pkt;
         p->data = p->pos = pos;
         p->size = p->length = length;
+        p->flag &= ~MPP_PACKET_FLAG_EXTERNAL;
         p->flag |= MPP_PACKET_FLAG_INTERNAL;
+        p->release = NULL;
+        p->release_ctx = NULL;
 
         if (length) {
             memcpy(pos, src_impl->pos, length);
@@ -155,6 +193,16 @@ MPP_RET mpp_packet_copy_init(MppPacket *packet, const MppPacket src)
     return MPP_OK;
 }
 
+MPP_RET mpp_packet_copy_init(MppPacket *packet, const MppPacket src)
+{
+    return packet_dup_init(packet, src, 0);
+}
+
+MPP_RET mpp_packet_move_init(MppPacket *packet, MppPacket src)
+{
+    return packet_dup_init(packet, src, 1);
+}
+
 MPP_RET mpp_packet_deinit(MppPacket *packet)
 {
     if (NULL == packet || check_is_mpp_packet(*packet)) {
@@ -171,10 +219,13 @@ MPP_RET mpp_packet_deinit(MppPacket *packet)
     if (p->flag & MPP_PACKET_FLAG_INTERNAL)
         mpp_free(p->data);
 
+    if ((p->flag & MPP_PACKET_FLAG_EXTERNAL) && p->release)
+        p->release(p->release_ctx, p->data);
+
     if (p->meta)
         mpp_meta_put(p->meta);
 
-    mpp_free(p);
+    mpp_mem_pool_put(get_packet_pool(), p);
     *packet = NULL;
     return MPP_OK;
 }
@@ -251,6 +302,24 @@ MPP_RET mpp_packet_set_extra_data(MppPacket packet)
     return MPP_OK;
 }
 
+RK_U32 mpp_packet_is_partition(const MppPacket packet)
+{
+    if (check_is_mpp_packet(packet))
+        return 0;
+
+    MppPacketImpl *p = (MppPacketImpl *)packet;
+    return (p->flag & MPP_PACKET_FLAG_PARTITION) ? (1) : (0);
+}
+
+RK_U32 mpp_packet_is_eoi(const MppPacket packet)
+{
+    if (check_is_mpp_packet(packet))
+        return 0;
+
+    MppPacketImpl *p = (MppPacketImpl *)packet;
+    return (p->flag & MPP_PACKET_FLAG_EOI) ? (1) : (0);
+}
+
 MPP_RET mpp_packet_reset(MppPacketImpl *packet)
 {
     if (check_is_mpp_packet(packet))
@@ -379,6 +448,57 @@ MPP_RET mpp_packet_append(MppPacket dst, MppPacket src)
     return MPP_OK;
 }
 
+void mpp_packet_reset_segment(MppPacket packet)
+{
+    if (check_is_mpp_packet(packet))
+        return ;
+
+    ((MppPacketImpl *)packet)->segment_nb = 0;
+}
+
+MPP_RET mpp_packet_add_segment(MppPacket packet, MppPktSegType type,
+                               RK_U32 offset, RK_U32 len)
+{
+    if (check_is_mpp_packet(packet))
+        return MPP_ERR_UNKNOW;
+
+    MppPacketImpl *p = (MppPacketImpl *)packet;
+    MppPktSeg *seg = NULL;
+
+    if (!len)
+        return MPP_OK;
+
+    if (p->segment_nb >= MPP_PACKET_SEG_CNT_MAX) {
+        mpp_err_f("segment count reach max %d\n", MPP_PACKET_SEG_CNT_MAX);
+        return MPP_NOK;
+    }
+
+    seg = &p->segments[p->segment_nb++];
+    seg->type = type;
+    seg->offset = offset;
+    seg->len = len;
+
+    return MPP_OK;
+}
+
+RK_U32 mpp_packet_get_segment_nb(const MppPacket packet)
+{
+    if (check_is_mpp_packet(packet))
+        return 0;
+
+    return ((MppPacketImpl *)packet)->segment_nb;
+}
+
+const MppPktSeg *mpp_packet_get_segment_info(const MppPacket packet)
+{
+    if (check_is_mpp_packet(packet))
+        return NULL;
+
+    MppPacketImpl *p = (MppPacketImpl *)packet;
+
+    return p->segment_nb ? p->segments : NULL;
+}
+
 /*
  * object access function macro
  */
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define MODULE_TAG "mpp_rbsp"
+
+#include <string.h>
+
+#include "mpp_rbsp.h"
+#include "mpp_startcode.h"
+
+RK_S32 mpp_rbsp_find_epb(const RK_U8 *buf, RK_S32 size)
+{
+    RK_S32 pos = mpp_find_prefix(buf, size, 3, 3);
+
+    return (pos < size) ? pos + 2 : size;
+}
+
+RK_S32 mpp_rbsp_extract(RK_U8 *dst, const RK_U8 *src, RK_S32 size)
+{
+    RK_S32 src_pos = 0;
+    RK_S32 dst_pos = 0;
+
+    while (src_pos < size) {
+        /* the escape byte is non-zero so the next search restarts cleanly */
+        RK_S32 n = mpp_rbsp_find_epb(src + src_pos, size - src_pos);
+
+        if (dst + dst_pos != src + src_pos)
+            memmove(dst + dst_pos, src + src_pos, n);
+
+        dst_pos += n;
+        src_pos += n + 1;
+    }
+
+    return dst_pos;
+}
@@ -0,0 +1,236 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_startcode"
+
+#include <string.h>
+
+#include "mpp_startcode.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define STARTCODE_VEC_SIZE  32
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define STARTCODE_VEC_SIZE  16
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define STARTCODE_VEC_SIZE  16
+#endif
+
+#define WORD_HAS_ZERO(v)    (((v) - 0x0101010101010101ULL) & ~(v) & 0x8080808080808080ULL)
+#define WORD_HAS_FF(v)      WORD_HAS_ZERO(~(v))
+
+static RK_U64 load_u64(const RK_U8 *p)
+{
+    RK_U64 v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+#if defined(STARTCODE_VEC_SIZE)
+static RK_U32 ctz32(RK_U32 v)
+{
+    return (RK_U32)__builtin_ctz(v);
+}
+#endif
+
+#if defined(__ARM_NEON)
+/* pack 16 byte lanes of 0x00/0xff into a 16 bit mask like movemask */
+static RK_U32 neon_movemask(uint8x16_t v)
+{
+    static const uint8_t weight[16] = {
+        1, 2, 4, 8, 16, 32, 64, 128,
+        1, 2, 4, 8, 16, 32, 64, 128,
+    };
+    uint8x16_t bits = vandq_u8(v, vld1q_u8(weight));
+    uint8x8_t lo = vget_low_u8(bits);
+    uint8x8_t hi = vget_high_u8(bits);
+
+    lo = vpadd_u8(lo, lo);
+    lo = vpadd_u8(lo, lo);
+    lo = vpadd_u8(lo, lo);
+    hi = vpadd_u8(hi, hi);
+    hi = vpadd_u8(hi, hi);
+    hi = vpadd_u8(hi, hi);
+
+    return vget_lane_u8(lo, 0) | ((RK_U32)vget_lane_u8(hi, 0) << 8);
+}
+#endif
+
+/*
+ * Mask of positions i in [p, p + STARTCODE_VEC_SIZE) with p[i] p[i + 1] equal
+ * to 00 00 and min <= p[i + 2] <= max. Reads STARTCODE_VEC_SIZE + 2 bytes.
+ */
+#if defined(STARTCODE_VEC_SIZE)
+static RK_U32 prefix_mask(const RK_U8 *p, RK_U8 min, RK_U8 max)
+{
+#if defined(__AVX2__)
+    __m256i zero = _mm256_setzero_si256();
+    __m256i lo = _mm256_set1_epi8((char)min);
+    __m256i hi = _mm256_set1_epi8((char)max);
+    __m256i v0 = _mm256_loadu_si256((const __m256i *)p);
+    __m256i v1 = _mm256_loadu_si256((const __m256i *)(p + 1));
+    __m256i v2 = _mm256_loadu_si256((const __m256i *)(p + 2));
+    __m256i m = _mm256_and_si256(_mm256_cmpeq_epi8(v0, zero),
+                                 _mm256_cmpeq_epi8(v1, zero));
+
+    /* unsigned range check: max(v, lo) == v and min(v, hi) == v */
+    m = _mm256_and_si256(m, _mm256_cmpeq_epi8(_mm256_max_epu8(v2, lo), v2));
+    m = _mm256_and_si256(m, _mm256_cmpeq_epi8(_mm256_min_epu8(v2, hi), v2));
+    return (RK_U32)_mm256_movemask_epi8(m);
+#elif defined(__SSE2__)
+    __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_set1_epi8((char)min);
+    __m128i hi = _mm_set1_epi8((char)max);
+    __m128i v0 = _mm_loadu_si128((const __m128i *)p);
+    __m128i v1 = _mm_loadu_si128((const __m128i *)(p + 1));
+    __m128i v2 = _mm_loadu_si128((const __m128i *)(p + 2));
+    __m128i m = _mm_and_si128(_mm_cmpeq_epi8(v0, zero),
+                              _mm_cmpeq_epi8(v1, zero));
+
+    m = _mm_and_si128(m, _mm_cmpeq_epi8(_mm_max_epu8(v2, lo), v2));
+    m = _mm_and_si128(m, _mm_cmpeq_epi8(_mm_min_epu8(v2, hi), v2));
+    return (RK_U32)_mm_movemask_epi8(m);
+#else
+    uint8x16_t v0 = vld1q_u8(p);
+    uint8x16_t v1 = vld1q_u8(p + 1);
+    uint8x16_t v2 = vld1q_u8(p + 2);
+    uint8x16_t m = vandq_u8(vceqq_u8(v0, vdupq_n_u8(0)),
+                            vceqq_u8(v1, vdupq_n_u8(0)));
+
+    m = vandq_u8(m, vandq_u8(vcgeq_u8(v2, vdupq_n_u8(min)),
+                             vcleq_u8(v2, vdupq_n_u8(max))));
+    return neon_movemask(m);
+#endif
+}
+
+/*
+ * Mask of positions i with p[i] == 0xff and min <= p[i + 1] <= max.
+ * Reads STARTCODE_VEC_SIZE + 1 bytes.
+ */
+static RK_U32 marker_mask(const RK_U8 *p, RK_U8 min, RK_U8 max)
+{
+#if defined(__AVX2__)
+    __m256i ff = _mm256_set1_epi8((char)0xff);
+    __m256i lo = _mm256_set1_epi8((char)min);
+    __m256i hi = _mm256_set1_epi8((char)max);
+    __m256i v0 = _mm256_loadu_si256((const __m256i *)p);
+    __m256i v1 = _mm256_loadu_si256((const __m256i *)(p + 1));
+    /* unsigned range check: max(v, lo) == v and min(v, hi) == v */
+    __m256i in = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_max_epu8(v1, lo), v1),
+                                  _mm256_cmpeq_epi8(_mm256_min_epu8(v1, hi), v1));
+
+    return (RK_U32)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(v0, ff), in));
+#elif defined(__SSE2__)
+    __m128i ff = _mm_set1_epi8((char)0xff);
+    __m128i lo = _mm_set1_epi8((char)min);
+    __m128i hi = _mm_set1_epi8((char)max);
+    __m128i v0 = _mm_loadu_si128((const __m128i *)p);
+    __m128i v1 = _mm_loadu_si128((const __m128i *)(p + 1));
+    __m128i in = _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(v1, lo), v1),
+                               _mm_cmpeq_epi8(_mm_min_epu8(v1, hi), v1));
+
+    return (RK_U32)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(v0, ff), in));
+#else
+    uint8x16_t v0 = vld1q_u8(p);
+    uint8x16_t v1 = vld1q_u8(p + 1);
+    uint8x16_t in = vandq_u8(vcgeq_u8(v1, vdupq_n_u8(min)),
+                             vcleq_u8(v1, vdupq_n_u8(max)));
+
+    return neon_movemask(vandq_u8(vceqq_u8(v0, vdupq_n_u8(0xff)), in));
+#endif
+}
+#endif
+
+RK_S32 mpp_find_prefix(const RK_U8 *buf, RK_S32 size, RK_U8 min, RK_U8 max)
+{
+    RK_S32 i = 0;
+
+    if (!buf || size < 3)
+        return size > 0 ? size : 0;
+
+#if defined(STARTCODE_VEC_SIZE)
+    for (; i + STARTCODE_VEC_SIZE + 2 <= size; i += STARTCODE_VEC_SIZE) {
+        RK_U32 mask = prefix_mask(buf + i, min, max);
+
+        if (mask)
+            return i + ctz32(mask);
+    }
+#endif
+
+    /* word-at-a-time: skip 8 bytes without any zero byte */
+    for (; i + 10 <= size; i += 8) {
+        RK_U64 v = load_u64(buf + i);
+
+        if (!WORD_HAS_ZERO(v))
+            continue;
+
+        for (RK_S32 j = i; j < i + 8; j++) {
+            if (!buf[j] && !buf[j + 1] && buf[j + 2] >= min && buf[j + 2] <= max)
+                return j;
+        }
+    }
+
+    for (; i + 2 < size; i++) {
+        if (!buf[i] && !buf[i + 1] && buf[i + 2] >= min && buf[i + 2] <= max)
+            return i;
+    }
+
+    return size;
+}
+
+RK_S32 mpp_find_startcode(const RK_U8 *buf, RK_S32 size)
+{
+    return mpp_find_prefix(buf, size, 1, 1);
+}
+
+RK_S32 mpp_find_marker(const RK_U8 *buf, RK_S32 size, RK_U8 min, RK_U8 max)
+{
+    RK_S32 i = 0;
+
+    if (!buf || size < 2)
+        return size > 0 ? size : 0;
+
+#if defined(STARTCODE_VEC_SIZE)
+    for (; i + STARTCODE_VEC_SIZE + 1 <= size; i += STARTCODE_VEC_SIZE) {
+        RK_U32 mask = marker_mask(buf + i, min, max);
+
+        if (mask)
+            return i + ctz32(mask);
+    }
+#endif
+
+    for (; i + 9 <= size; i += 8) {
+        RK_U64 v = load_u64(buf + i);
+
+        if (!WORD_HAS_FF(v))
+            continue;
+
+        for (RK_S32 j = i; j < i + 8; j++) {
+            if (buf[j] == 0xff && buf[j + 1] >= min && buf[j + 1] <= max)
+                return j;
+        }
+    }
+
+    for (; i + 1 < size; i++) {
+        if (buf[i] == 0xff && buf[i + 1] >= min && buf[i + 1] <= max)
+            return i;
+    }
+
+    return size;
+}
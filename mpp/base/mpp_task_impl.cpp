@@ -478,7 +478,7 @@ MPP_RET mpp_task_queue_deinit(MppTaskQueue queue)
                     mpp_err_f("meta %p node %p id %d type %d\n",
                               meta, node, node->node_id, node->type_id);
 
-                    MPP_FREE(node);
+                    mpp_meta_free_node(node);
                 }
             }
 
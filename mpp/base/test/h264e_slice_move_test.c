@@ -0,0 +1,192 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "h264e_slice_move_test"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+
+#include "h264e_slice.h"
+
+#define TEST_BUF_SIZE   (SZ_1K + 37)
+#define TEST_LOOP       2000
+#define PERF_BUF_SIZE   (SZ_4M)
+#define PERF_LOOP       4
+
+/* byte by byte reference of h264e_slice_move */
+static RK_S32 ref_slice_move(RK_U8 *dst, RK_U8 *src, RK_S32 dst_bit, RK_S32 src_bit, RK_S32 src_size)
+{
+    RK_S32 dst_byte = dst_bit / 8;
+    RK_S32 src_byte = src_bit / 8;
+    RK_S32 dst_bit_r = dst_bit & 7;
+    RK_S32 src_bit_r = src_bit & 7;
+    RK_S32 src_len = src_size - src_byte;
+    RK_S32 diff_len = 0;
+    RK_U8 *psrc = src + src_byte;
+    RK_U8 *pdst = dst + dst_byte;
+    RK_U16 tmp16a, tmp16b, tmp16c, last_tmp, dst_mask;
+    RK_U8 tmp0, tmp1;
+    RK_U32 loop = src_len + (src_bit_r > 0);
+    RK_U32 src_zero_cnt = 0;
+    RK_U32 dst_zero_cnt = 0;
+    RK_U32 i;
+
+    if (src_bit_r == 0 && dst_bit_r == 0) {
+        memcpy(dst + dst_byte, src + src_byte, src_len);
+        return diff_len;
+    }
+
+    last_tmp = (RK_U16)pdst[0];
+    dst_mask = 0xFFFF << (8 - dst_bit_r);
+
+    for (i = 0; i < loop; i++) {
+        if (psrc[0] == 0)
+            src_zero_cnt++;
+        else
+            src_zero_cnt = 0;
+
+        tmp0 = psrc[0];
+        tmp1 = (i < loop - 1) ? psrc[1] : 0;
+
+        if (src_zero_cnt >= 2 && tmp1 == 3) {
+            psrc++;
+            i++;
+            tmp1 = psrc[1];
+            src_zero_cnt = 0;
+            diff_len--;
+        }
+
+        tmp16a = ((RK_U16)tmp0 << 8) | (RK_U16)tmp1;
+        tmp16b = src_bit_r ? tmp16a << src_bit_r : tmp16a;
+        tmp16c = dst_bit_r ? (tmp16b >> dst_bit_r | ((last_tmp << 8) & dst_mask)) : tmp16b;
+
+        pdst[0] = (tmp16c >> 8) & 0xFF;
+        pdst[1] = tmp16c & 0xFF;
+
+        if (dst_zero_cnt == 2 && pdst[0] <= 0x3) {
+            pdst[2] = pdst[1];
+            pdst[1] = pdst[0];
+            pdst[0] = 0x3;
+            pdst++;
+            diff_len++;
+            dst_zero_cnt = 0;
+        }
+
+        if (pdst[0] == 0)
+            dst_zero_cnt++;
+        else
+            dst_zero_cnt = 0;
+
+        last_tmp = tmp16c;
+        psrc++;
+        pdst++;
+    }
+
+    return diff_len;
+}
+
+/* slice payload with zero runs and emulation prevention bytes at random spots */
+static void fill_slice(RK_U8 *buf, RK_S32 size, RK_S32 zero_rate)
+{
+    RK_S32 i;
+
+    for (i = 0; i < size; i++) {
+        RK_S32 r = rand() % zero_rate;
+
+        if (r == 0 && i + 3 < size) {
+            buf[i++] = 0;
+            buf[i++] = 0;
+            buf[i] = (rand() & 1) ? 3 : 0;
+        } else if (r == 1) {
+            buf[i] = 0;
+        } else {
+            buf[i] = (RK_U8)(rand() % 255 + 1);
+        }
+    }
+}
+
+int main()
+{
+    RK_S32 dst_size = PERF_BUF_SIZE * 3 / 2 + 64;
+    RK_U8 *src = mpp_malloc(RK_U8, PERF_BUF_SIZE + 64);
+    RK_U8 *dst = mpp_malloc(RK_U8, dst_size);
+    RK_U8 *ref = mpp_malloc(RK_U8, dst_size);
+    RK_S32 i;
+    RK_S32 err = 0;
+    RK_S64 start;
+    RK_S64 time_ref;
+    RK_S64 time_new;
+
+    mpp_log("h264e_slice_move_test start\n");
+
+    srand(0x1234);
+    for (i = 0; i < TEST_LOOP && !err; i++) {
+        RK_S32 size = rand() % TEST_BUF_SIZE + 16;
+        RK_S32 src_bit = rand() % 64;
+        RK_S32 dst_bit = rand() % 64;
+        RK_S32 zero_rate = (i & 1) ? 8 : 256;
+        RK_S32 ret_ref;
+        RK_S32 ret;
+
+        fill_slice(src, size + 8, zero_rate);
+        memset(ref, 0x5a, TEST_BUF_SIZE * 2);
+        memset(dst, 0x5a, TEST_BUF_SIZE * 2);
+
+        ret_ref = ref_slice_move(ref, src, dst_bit, src_bit, size);
+        ret = h264e_slice_move(dst, src, dst_bit, src_bit, size);
+
+        if (ret != ret_ref || memcmp(dst, ref, TEST_BUF_SIZE * 2)) {
+            mpp_err("mismatch size %d bit src %d dst %d diff %d vs %d\n",
+                    size, src_bit, dst_bit, ret, ret_ref);
+            err = 1;
+        }
+    }
+
+    /* multi-megabyte I slice moved by an odd bit offset */
+    fill_slice(src, PERF_BUF_SIZE + 64, 256);
+    memset(ref, 0, dst_size);
+    memset(dst, 0, dst_size);
+
+    start = mpp_time();
+    for (i = 0; i < PERF_LOOP; i++)
+        ref_slice_move(ref, src, 13, 27, PERF_BUF_SIZE);
+    time_ref = mpp_time() - start;
+
+    start = mpp_time();
+    for (i = 0; i < PERF_LOOP; i++)
+        h264e_slice_move(dst, src, 13, 27, PERF_BUF_SIZE);
+    time_new = mpp_time() - start;
+
+    if (memcmp(dst, ref, dst_size)) {
+        mpp_err("large slice mismatch\n");
+        err = 1;
+    }
+
+    mpp_log("move %d bytes x %d: byte loop %lld us word loop %lld us\n",
+            PERF_BUF_SIZE, PERF_LOOP, time_ref, time_new);
+
+    MPP_FREE(src);
+    MPP_FREE(dst);
+    MPP_FREE(ref);
+    mpp_log("h264e_slice_move_test %s\n", err ? "failed" : "success");
+
+    return err;
+}
@@ -0,0 +1,312 @@
+/*
+ * Copyright 2020 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_buf_slot_test"
+
+#include <pthread.h>
+
+#include "mpp_log.h"
+
+#include "mpp_buf_slot.h"
+
+/* cross the 32 slot group boundary */
+#define SLOT_TEST_COUNT         40
+#define SLOT_TEST_LOOP          1000
+
+/* slots held by the get thread while the count changes */
+#define SLOT_TEST_HOLD          4
+#define SLOT_TEST_RESIZE_LOOP   200000
+
+typedef struct SlotTestThread_t {
+    MppBufSlots     slots;
+    SlotUsageType   type;
+} SlotTestThread;
+
+static void *slot_clr_thread(void *arg)
+{
+    SlotTestThread *ctx = (SlotTestThread *)arg;
+    RK_S32 i;
+
+    for (i = 0; i < SLOT_TEST_COUNT; i++)
+        mpp_buf_slot_clr_flag(ctx->slots, i, ctx->type);
+
+    return NULL;
+}
+
+/* slots are handed out from the lowest free index */
+static MPP_RET test_get_unused(MppBufSlots slots)
+{
+    RK_S32 index = -1;
+    RK_S32 i;
+
+    for (i = 0; i < SLOT_TEST_COUNT; i++) {
+        if (mpp_buf_slot_get_unused(slots, &index) || index != i) {
+            mpp_err("get unused slot %d expect %d\n", index, i);
+            return MPP_NOK;
+        }
+        mpp_buf_slot_set_flag(slots, index, SLOT_HAL_OUTPUT);
+    }
+
+    if (mpp_slots_get_unused_count(slots)) {
+        mpp_err("found %d unused slot after all slot used\n",
+                mpp_slots_get_unused_count(slots));
+        return MPP_NOK;
+    }
+
+    /* release slot 33 and 5, the next get should return 5 then 33 */
+    mpp_buf_slot_clr_flag(slots, 33, SLOT_HAL_OUTPUT);
+    mpp_buf_slot_clr_flag(slots, 5, SLOT_HAL_OUTPUT);
+
+    if (mpp_buf_slot_get_unused(slots, &index) || index != 5) {
+        mpp_err("get unused slot %d expect 5\n", index);
+        return MPP_NOK;
+    }
+    mpp_buf_slot_set_flag(slots, index, SLOT_HAL_OUTPUT);
+
+    if (mpp_buf_slot_get_unused(slots, &index) || index != 33) {
+        mpp_err("get unused slot %d expect 33\n", index);
+        return MPP_NOK;
+    }
+    mpp_buf_slot_set_flag(slots, index, SLOT_HAL_OUTPUT);
+
+    for (i = 0; i < SLOT_TEST_COUNT; i++)
+        mpp_buf_slot_clr_flag(slots, i, SLOT_HAL_OUTPUT);
+
+    return MPP_OK;
+}
+
+/* codec and hal flags cleared from two threads release each slot once */
+static MPP_RET test_clr_threads(MppBufSlots slots)
+{
+    SlotTestThread ctx[2];
+    pthread_t thd[2];
+    RK_S32 index = -1;
+    RK_S32 loop;
+    RK_S32 i;
+
+    ctx[0].slots = slots;
+    ctx[0].type = SLOT_CODEC_USE;
+    ctx[1].slots = slots;
+    ctx[1].type = SLOT_HAL_OUTPUT;
+
+    for (loop = 0; loop < SLOT_TEST_LOOP; loop++) {
+        for (i = 0; i < SLOT_TEST_COUNT; i++) {
+            if (mpp_buf_slot_get_unused(slots, &index))
+                return MPP_NOK;
+
+            mpp_buf_slot_set_flag(slots, index, SLOT_CODEC_USE);
+            mpp_buf_slot_set_flag(slots, index, SLOT_HAL_OUTPUT);
+        }
+
+        for (i = 0; i < 2; i++)
+            pthread_create(&thd[i], NULL, slot_clr_thread, &ctx[i]);
+
+        for (i = 0; i < 2; i++)
+            pthread_join(thd[i], NULL);
+
+        if (mpp_slots_get_used_count(slots)) {
+            mpp_err("loop %d found %d slot still used\n", loop,
+                    mpp_slots_get_used_count(slots));
+            return MPP_NOK;
+        }
+    }
+
+    return MPP_OK;
+}
+
+/* slot count grows at once, shrinks on ready but not below slot in use */
+static MPP_RET test_grow(void)
+{
+    MppBufSlots slots = NULL;
+    MPP_RET ret = MPP_NOK;
+    RK_S32 index[4];
+    RK_S32 i;
+
+    if (mpp_buf_slot_init(&slots) || mpp_buf_slot_setup(slots, 2))
+        goto DONE;
+
+    for (i = 0; i < 2; i++) {
+        mpp_buf_slot_get_unused(slots, &index[i]);
+        mpp_buf_slot_set_flag(slots, index[i], SLOT_HAL_OUTPUT);
+    }
+
+    /* all slot used, get unused grows one more slot */
+    mpp_buf_slot_get_unused(slots, &index[2]);
+    mpp_buf_slot_set_flag(slots, index[2], SLOT_HAL_OUTPUT);
+    if (index[2] != 2 || mpp_buf_slot_get_count(slots) != 3) {
+        mpp_err("grow on get unused index %d count %d\n", index[2],
+                mpp_buf_slot_get_count(slots));
+        goto DONE;
+    }
+
+    mpp_buf_slot_setup(slots, 6);
+    if (mpp_buf_slot_get_count(slots) != 6 || mpp_slots_get_unused_count(slots) != 3) {
+        mpp_err("grow on setup count %d unused %d\n", mpp_buf_slot_get_count(slots),
+                mpp_slots_get_unused_count(slots));
+        goto DONE;
+    }
+
+    mpp_buf_slot_get_unused(slots, &index[3]);
+    mpp_buf_slot_set_flag(slots, index[3], SLOT_HAL_OUTPUT);
+
+    /* slot 3 is still used, shrink stops at 4 */
+    mpp_buf_slot_setup(slots, 2);
+    if (mpp_buf_slot_get_count(slots) != 6)
+        goto DONE;
+
+    mpp_buf_slot_ready(slots);
+    if (mpp_buf_slot_get_count(slots) != 4) {
+        mpp_err("shrink on ready count %d\n", mpp_buf_slot_get_count(slots));
+        goto DONE;
+    }
+
+    for (i = 0; i < 4; i++)
+        mpp_buf_slot_clr_flag(slots, index[i], SLOT_HAL_OUTPUT);
+
+    if (mpp_slots_get_unused_count(slots) != 4) {
+        mpp_err("found %d unused slot after shrink\n",
+                mpp_slots_get_unused_count(slots));
+        goto DONE;
+    }
+
+    ret = MPP_OK;
+DONE:
+    if (slots)
+        mpp_buf_slot_deinit(slots);
+
+    return ret;
+}
+
+static RK_S32 slot_owned[SLOT_TEST_COUNT];
+static RK_S32 slot_resize_errors = 0;
+static volatile RK_S32 slot_resize_done = 0;
+
+static void *slot_get_thread(void *arg)
+{
+    MppBufSlots slots = (MppBufSlots)arg;
+    RK_S32 hold[SLOT_TEST_HOLD];
+    RK_S32 loop;
+    RK_S32 i;
+
+    for (i = 0; i < SLOT_TEST_HOLD; i++)
+        hold[i] = -1;
+
+    for (loop = 0; loop < SLOT_TEST_RESIZE_LOOP; loop++) {
+        RK_S32 pos = loop % SLOT_TEST_HOLD;
+        RK_S32 index = -1;
+
+        if (hold[pos] >= 0) {
+            slot_owned[hold[pos]] = 0;
+            mpp_buf_slot_clr_flag(slots, hold[pos], SLOT_HAL_OUTPUT);
+            hold[pos] = -1;
+        }
+
+        if (mpp_buf_slot_get_unused(slots, &index) ||
+            index < 0 || index >= SLOT_TEST_COUNT ||
+            __sync_lock_test_and_set(&slot_owned[index], 1)) {
+            mpp_err("slot %d handed out twice\n", index);
+            __sync_fetch_and_add(&slot_resize_errors, 1);
+            break;
+        }
+
+        mpp_buf_slot_set_flag(slots, index, SLOT_HAL_OUTPUT);
+        hold[pos] = index;
+    }
+
+    for (i = 0; i < SLOT_TEST_HOLD; i++) {
+        if (hold[i] >= 0) {
+            slot_owned[hold[i]] = 0;
+            mpp_buf_slot_clr_flag(slots, hold[i], SLOT_HAL_OUTPUT);
+        }
+    }
+
+    slot_resize_done = 1;
+    return NULL;
+}
+
+/* slot count changes never hand out a slot which is being taken */
+static MPP_RET test_resize_threads(MppBufSlots slots)
+{
+    pthread_t thd;
+    RK_U32 count = 0;
+
+    pthread_create(&thd, NULL, slot_get_thread, slots);
+
+    while (!slot_resize_done) {
+        count = (count == SLOT_TEST_HOLD) ? SLOT_TEST_COUNT : SLOT_TEST_HOLD;
+        mpp_slots_set_prop(slots, SLOTS_COUNT, &count);
+    }
+
+    pthread_join(thd, NULL);
+
+    if (mpp_slots_get_used_count(slots)) {
+        mpp_err("found %d slot still used\n", mpp_slots_get_used_count(slots));
+        return MPP_NOK;
+    }
+
+    return slot_resize_errors ? MPP_NOK : MPP_OK;
+}
+
+int main()
+{
+    MPP_RET ret = MPP_NOK;
+    MppBufSlots slots = NULL;
+
+    mpp_log("mpp_buf_slot_test start\n");
+
+    if (mpp_buf_slot_init(&slots)) {
+        mpp_err("mpp_buf_slot_test init failed\n");
+        goto DONE;
+    }
+
+    if (mpp_buf_slot_setup(slots, SLOT_TEST_COUNT))
+        goto DONE;
+
+    if (mpp_buf_slot_get_count(slots) != SLOT_TEST_COUNT) {
+        mpp_err("slot count %d mismatch %d\n", mpp_buf_slot_get_count(slots),
+                SLOT_TEST_COUNT);
+        goto DONE;
+    }
+
+    ret = test_get_unused(slots);
+    if (ret) {
+        mpp_err("mpp_buf_slot_test get unused failed\n");
+        goto DONE;
+    }
+
+    ret = test_clr_threads(slots);
+    if (ret) {
+        mpp_err("mpp_buf_slot_test clear from threads failed\n");
+        goto DONE;
+    }
+
+    ret = test_resize_threads(slots);
+    if (ret) {
+        mpp_err("mpp_buf_slot_test resize from threads failed\n");
+        goto DONE;
+    }
+
+    ret = test_grow();
+    if (ret)
+        mpp_err("mpp_buf_slot_test grow failed\n");
+
+DONE:
+    if (slots)
+        mpp_buf_slot_deinit(slots);
+
+    mpp_log("mpp_buf_slot_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
@@ -16,13 +16,16 @@
 
 #define MODULE_TAG "mpp_buffer_test"
 
+#include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
 #if defined(_WIN32)
 #include "vld.h"
 #endif
 #include "mpp_log.h"
 #include "mpp_env.h"
+#include "mpp_thread.h"
 #include "mpp_common.h"
 #include "mpp_buffer.h"
 #include "mpp_allocator.h"
@@ -31,6 +34,279 @@
 #define MPP_BUFFER_TEST_SIZE            (SZ_1K*4)
 #define MPP_BUFFER_TEST_COMMIT_COUNT    10
 #define MPP_BUFFER_TEST_NORMAL_COUNT    10
+#define MPP_BUFFER_TEST_THREAD_COUNT    4
+#define MPP_BUFFER_TEST_THREAD_LOOP     10000
+
+typedef struct MppBufferTestThread_t {
+    MppBufferGroup  group;
+    MppBuffer       shared;
+    RK_S32          failed;
+} MppBufferTestThread;
+
+static RK_S32 import_tmp_file(FILE **fp, RK_U8 val, MppBuffer *buffer)
+{
+    MppBufferInfo info;
+    RK_U8 *ptr = NULL;
+    RK_S32 fd;
+
+    if (NULL == *fp) {
+        *fp = tmpfile();
+        if (NULL == *fp)
+            return -1;
+
+        fd = fileno(*fp);
+        if (ftruncate(fd, MPP_BUFFER_TEST_SIZE))
+            return -1;
+
+        if (pwrite(fd, &val, 1, 0) != 1)
+            return -1;
+    }
+
+    memset(&info, 0, sizeof(info));
+    info.type = MPP_BUFFER_TYPE_EXT_DMA;
+    info.size = MPP_BUFFER_TEST_SIZE;
+    info.fd = fileno(*fp);
+
+    if (mpp_buffer_import(buffer, &info))
+        return -1;
+
+    ptr = (RK_U8 *)mpp_buffer_get_ptr(*buffer);
+    if (NULL == ptr || ptr[0] != val)
+        return -1;
+
+    return 0;
+}
+
+/* same fd hits the import cache and a reused fd number does not */
+static MPP_RET test_import_cache(void)
+{
+    MPP_RET ret = MPP_NOK;
+    FILE *fp[3] = { NULL, NULL, NULL };
+    MppBuffer buf0 = NULL;
+    MppBuffer buf1 = NULL;
+    MppBuffer hit = NULL;
+    RK_S32 fd0;
+
+    if (import_tmp_file(&fp[0], 0x10, &buf0))
+        goto DONE;
+
+    fd0 = fileno(fp[0]);
+    mpp_buffer_put(buf0);
+
+    if (import_tmp_file(&fp[1], 0x11, &buf1))
+        goto DONE;
+
+    if (import_tmp_file(&fp[0], 0x10, &hit) || hit != buf0) {
+        mpp_err("import fd %d again does not hit cache\n", fd0);
+        goto DONE;
+    }
+
+    mpp_buffer_put(hit);
+    hit = NULL;
+
+    /* new file usually takes the closed fd number */
+    fclose(fp[0]);
+    fp[0] = NULL;
+
+    if (import_tmp_file(&fp[2], 0x12, &hit)) {
+        mpp_err("import fd %d reused by another file got stale buffer\n",
+                fileno(fp[2]));
+        goto DONE;
+    }
+
+    ret = MPP_OK;
+DONE:
+    if (hit)
+        mpp_buffer_put(hit);
+    if (buf1)
+        mpp_buffer_put(buf1);
+    if (fp[0])
+        fclose(fp[0]);
+    if (fp[1])
+        fclose(fp[1]);
+    if (fp[2])
+        fclose(fp[2]);
+
+    return ret;
+}
+
+/* best fit buffer is reused and smaller ones are retained on miss */
+static MPP_RET test_size_class(void)
+{
+    static const size_t sizes[] = { SZ_4K, SZ_16K, SZ_64K };
+    MppBufferGroup group = NULL;
+    MppBuffer buf[MPP_ARRAY_ELEMS(sizes)];
+    MppBuffer big = NULL;
+    MppBuffer fit = NULL;
+    MPP_RET ret = MPP_NOK;
+    size_t usage = 0;
+    RK_U32 i;
+
+    if (mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_NORMAL))
+        return MPP_NOK;
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(sizes); i++) {
+        buf[i] = NULL;
+        if (mpp_buffer_get(group, &buf[i], sizes[i]))
+            goto DONE;
+        usage += sizes[i];
+    }
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(sizes); i++) {
+        mpp_buffer_put(buf[i]);
+        buf[i] = NULL;
+    }
+
+    if (mpp_buffer_get(group, &fit, SZ_16K - SZ_4K))
+        goto DONE;
+
+    if (mpp_buffer_get_size(fit) != SZ_16K) {
+        mpp_err("request %d got size %d not the best fit\n", SZ_16K - SZ_4K,
+                mpp_buffer_get_size(fit));
+        goto DONE;
+    }
+
+    if (mpp_buffer_get(group, &big, SZ_256K))
+        goto DONE;
+
+    usage += SZ_256K;
+    if (mpp_buffer_group_usage(group) != usage) {
+        mpp_err("group usage %d mismatch %d small buffer is not retained\n",
+                mpp_buffer_group_usage(group), usage);
+        goto DONE;
+    }
+
+    ret = MPP_OK;
+DONE:
+    for (i = 0; i < MPP_ARRAY_ELEMS(sizes); i++) {
+        if (buf[i])
+            mpp_buffer_put(buf[i]);
+    }
+    if (fit)
+        mpp_buffer_put(fit);
+    if (big)
+        mpp_buffer_put(big);
+
+    mpp_buffer_group_put(group);
+    return ret;
+}
+
+/* cpu access bracket on dma heap buffer, falls back to other allocator */
+static MPP_RET test_sync(void)
+{
+    MppBufferGroup group = NULL;
+    MppBuffer buf = NULL;
+    MPP_RET ret = MPP_NOK;
+    RK_U8 *ptr;
+
+    if (mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_DMA_HEAP |
+                                      MPP_BUFFER_FLAGS_CACHABLE))
+        return MPP_NOK;
+
+    if (mpp_buffer_get(group, &buf, MPP_BUFFER_TEST_SIZE))
+        goto DONE;
+
+    ptr = (RK_U8 *)mpp_buffer_get_ptr(buf);
+    if (NULL == ptr)
+        goto DONE;
+
+    if (mpp_buffer_sync_begin(buf, 0, 0, 0))
+        goto DONE;
+
+    memset(ptr, 0x5a, MPP_BUFFER_TEST_SIZE);
+
+    if (mpp_buffer_sync_end(buf, 0, 0, 0))
+        goto DONE;
+
+    if (mpp_buffer_sync_begin(buf, 1, SZ_1K, SZ_1K) || ptr[SZ_1K] != 0x5a ||
+        mpp_buffer_sync_end(buf, 1, SZ_1K, SZ_1K))
+        goto DONE;
+
+    if (MPP_OK == mpp_buffer_sync_begin(buf, 1, SZ_1K, MPP_BUFFER_TEST_SIZE)) {
+        mpp_err("sync out of buffer range is not rejected\n");
+        goto DONE;
+    }
+
+    ret = MPP_OK;
+DONE:
+    if (buf)
+        mpp_buffer_put(buf);
+
+    mpp_buffer_group_put(group);
+    return ret;
+}
+
+static void *buffer_ref_thread(void *arg)
+{
+    MppBufferTestThread *ctx = (MppBufferTestThread *)arg;
+    RK_S32 i;
+
+    for (i = 0; i < MPP_BUFFER_TEST_THREAD_LOOP; i++) {
+        MppBuffer buf = NULL;
+
+        mpp_buffer_inc_ref(ctx->shared);
+
+        /* get / put on the same group goes through the 0 / 1 transition */
+        if (mpp_buffer_get(ctx->group, &buf, MPP_BUFFER_TEST_SIZE) || NULL == buf) {
+            ctx->failed = 1;
+            mpp_buffer_put(ctx->shared);
+            break;
+        }
+
+        mpp_buffer_inc_ref(buf);
+        mpp_buffer_put(buf);
+        mpp_buffer_put(buf);
+        mpp_buffer_put(ctx->shared);
+    }
+
+    return NULL;
+}
+
+/* reference from multiple threads on one group keeps the buffer counter */
+static MPP_RET test_ref_threads(void)
+{
+    MppBufferTestThread ctx[MPP_BUFFER_TEST_THREAD_COUNT];
+    pthread_t thd[MPP_BUFFER_TEST_THREAD_COUNT];
+    MppBufferGroup group = NULL;
+    MppBuffer shared = NULL;
+    MPP_RET ret = MPP_NOK;
+    RK_S32 i;
+
+    if (mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_NORMAL))
+        return MPP_NOK;
+
+    /* each thread holds one buffer at most besides the shared one */
+    mpp_buffer_group_limit_config(group, 0, MPP_BUFFER_TEST_THREAD_COUNT + 1);
+
+    if (mpp_buffer_get(group, &shared, MPP_BUFFER_TEST_SIZE))
+        goto DONE;
+
+    for (i = 0; i < MPP_BUFFER_TEST_THREAD_COUNT; i++) {
+        ctx[i].group = group;
+        ctx[i].shared = shared;
+        ctx[i].failed = 0;
+        pthread_create(&thd[i], NULL, buffer_ref_thread, &ctx[i]);
+    }
+
+    ret = MPP_OK;
+    for (i = 0; i < MPP_BUFFER_TEST_THREAD_COUNT; i++) {
+        pthread_join(thd[i], NULL);
+        if (ctx[i].failed)
+            ret = MPP_NOK;
+    }
+
+    mpp_buffer_put(shared);
+
+    if (mpp_buffer_group_unused(group) != MPP_BUFFER_TEST_THREAD_COUNT + 1) {
+        mpp_err("group unused %d mismatch with limit %d\n",
+                mpp_buffer_group_unused(group), MPP_BUFFER_TEST_THREAD_COUNT + 1);
+        ret = MPP_NOK;
+    }
+
+DONE:
+    mpp_buffer_group_put(group);
+    return ret;
+}
 
 int main()
 {
@@ -239,6 +515,36 @@ int main()
         group = NULL;
     }
 
+    mpp_log("mpp_buffer_test import cache start\n");
+
+    ret = test_import_cache();
+    if (MPP_OK != ret) {
+        mpp_err("mpp_buffer_test import cache failed\n");
+        goto MPP_BUFFER_failed;
+    }
+
+    mpp_log("mpp_buffer_test import cache success\n");
+
+    mpp_log("mpp_buffer_test size class start\n");
+
+    ret = test_size_class();
+    if (MPP_OK != ret) {
+        mpp_err("mpp_buffer_test size class failed\n");
+        goto MPP_BUFFER_failed;
+    }
+
+    mpp_log("mpp_buffer_test size class success\n");
+
+    mpp_log("mpp_buffer_test sync start\n");
+
+    ret = test_sync();
+    if (MPP_OK != ret) {
+        mpp_err("mpp_buffer_test sync failed\n");
+        goto MPP_BUFFER_failed;
+    }
+
+    mpp_log("mpp_buffer_test sync success\n");
+
     mpp_log("mpp_buffer_test success\n");
 
     ret = mpp_buffer_get(NULL, &legacy_buffer, MPP_BUFFER_TEST_SIZE);
@@ -255,6 +561,17 @@ int main()
 
     mpp_env_set_u32("mpp_buffer_debug", 0);
 
+    /* without ops log the reference goes through the lock free path */
+    mpp_log("mpp_buffer_test multi-thread reference start\n");
+
+    ret = test_ref_threads();
+    if (MPP_OK != ret) {
+        mpp_err("mpp_buffer_test multi-thread reference failed\n");
+        return ret;
+    }
+
+    mpp_log("mpp_buffer_test multi-thread reference success\n");
+
     return ret;
 
 MPP_BUFFER_failed:
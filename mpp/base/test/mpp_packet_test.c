@@ -19,14 +19,23 @@
 #include <stdlib.h>
 
 #include "mpp_log.h"
-#include "mpp_packet.h"
+#include "mpp_packet_impl.h"
 
 #define MPP_PACKET_TEST_SIZE    1024
 
+static RK_S32 release_count = 0;
+
+static void mpp_packet_test_release(void *ctx, void *data)
+{
+    if (ctx == data)
+        release_count++;
+}
+
 int main()
 {
     MPP_RET ret = MPP_ERR_UNKNOW;
     MppPacket packet = NULL;
+    MppPacket copy = NULL;
     void *data = NULL;
     size_t size = MPP_PACKET_TEST_SIZE;
 
@@ -50,6 +59,85 @@ int main()
     }
     mpp_packet_deinit(&packet);
 
+    ret = mpp_packet_init_with_release(&packet, data, size,
+                                       mpp_packet_test_release, data);
+    if (MPP_OK != ret) {
+        mpp_err("mpp_packet_test mpp_packet_init_with_release failed\n");
+        goto MPP_PACKET_failed;
+    }
+
+    /* copy of lent packet owns a new copy and keeps the release on source */
+    ret = mpp_packet_copy_init(&copy, packet);
+    if (MPP_OK != ret || mpp_packet_get_data(copy) == data) {
+        mpp_err("mpp_packet_test copy init of lent packet failed\n");
+        ret = MPP_NOK;
+        goto MPP_PACKET_failed;
+    }
+    mpp_packet_deinit(&copy);
+    if (release_count) {
+        mpp_err("mpp_packet_test release on copied packet\n");
+        ret = MPP_NOK;
+        goto MPP_PACKET_failed;
+    }
+
+    /* move of lent packet should share the data and take the release */
+    ret = mpp_packet_move_init(&copy, packet);
+    if (MPP_OK != ret || mpp_packet_get_data(copy) != data) {
+        mpp_err("mpp_packet_test zero copy init failed\n");
+        ret = MPP_NOK;
+        goto MPP_PACKET_failed;
+    }
+    mpp_packet_deinit(&packet);
+    if (release_count) {
+        mpp_err("mpp_packet_test release on source packet\n");
+        ret = MPP_NOK;
+        goto MPP_PACKET_failed;
+    }
+    mpp_packet_deinit(&copy);
+    if (release_count != 1) {
+        mpp_err("mpp_packet_test release count %d\n", release_count);
+        ret = MPP_NOK;
+        goto MPP_PACKET_failed;
+    }
+
+    /* segments are kept on copy */
+    ret = mpp_packet_init(&packet, data, size);
+    if (MPP_OK != ret) {
+        mpp_err("mpp_packet_test mpp_packet_init failed\n");
+        goto MPP_PACKET_failed;
+    }
+    mpp_packet_set_length(packet, 96);
+    mpp_packet_add_segment(packet, MPP_PKT_SEG_HEADER, 0, 32);
+    mpp_packet_add_segment(packet, MPP_PKT_SEG_SEI, 32, 0);
+    mpp_packet_add_segment(packet, MPP_PKT_SEG_STREAM, 32, 64);
+
+    ret = mpp_packet_copy_init(&copy, packet);
+    if (MPP_OK != ret || mpp_packet_get_segment_nb(copy) != 2) {
+        mpp_err("mpp_packet_test segment count %d\n",
+                copy ? mpp_packet_get_segment_nb(copy) : 0);
+        ret = MPP_NOK;
+        goto MPP_PACKET_failed;
+    } else {
+        const MppPktSeg *seg = mpp_packet_get_segment_info(copy);
+
+        if (seg[0].type != MPP_PKT_SEG_HEADER || seg[0].len != 32 ||
+            seg[1].type != MPP_PKT_SEG_STREAM || seg[1].offset != 32 ||
+            seg[1].len != 64) {
+            mpp_err("mpp_packet_test segment info mismatch\n");
+            ret = MPP_NOK;
+            goto MPP_PACKET_failed;
+        }
+    }
+
+    mpp_packet_reset_segment(packet);
+    if (mpp_packet_get_segment_nb(packet) || mpp_packet_get_segment_info(packet)) {
+        mpp_err("mpp_packet_test segment reset failed\n");
+        ret = MPP_NOK;
+        goto MPP_PACKET_failed;
+    }
+    mpp_packet_deinit(&packet);
+    mpp_packet_deinit(&copy);
+
     free(data);
     mpp_log("mpp_packet_test success\n");
     return ret;
@@ -58,6 +146,9 @@ MPP_PACKET_failed:
     if (packet)
         mpp_packet_deinit(&packet);
 
+    if (copy)
+        mpp_packet_deinit(&copy);
+
     if (data)
         free(data);
 
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_startcode_test"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+
+#include "mpp_rbsp.h"
+#include "mpp_startcode.h"
+
+#define TEST_BUF_SIZE   (SZ_1K + 37)
+#define TEST_LOOP       2000
+#define PERF_BUF_SIZE   (SZ_4M)
+
+static RK_S32 ref_find_startcode(const RK_U8 *buf, RK_S32 size)
+{
+    RK_S32 i;
+
+    for (i = 0; i + 2 < size; i++)
+        if (!buf[i] && !buf[i + 1] && buf[i + 2] == 1)
+            return i;
+
+    return size;
+}
+
+static RK_S32 ref_find_prefix(const RK_U8 *buf, RK_S32 size, RK_U8 min, RK_U8 max)
+{
+    RK_S32 i;
+
+    for (i = 0; i + 2 < size; i++)
+        if (!buf[i] && !buf[i + 1] && buf[i + 2] >= min && buf[i + 2] <= max)
+            return i;
+
+    return size;
+}
+
+/* same rule as the bit reader emulation prevention detection */
+static RK_S32 ref_rbsp_extract(RK_U8 *dst, const RK_U8 *src, RK_S32 size)
+{
+    RK_U32 prev = 0xffff;
+    RK_S32 i, n = 0;
+
+    for (i = 0; i < size; i++) {
+        if (src[i] == 0x03 && !(prev & 0xffff)) {
+            prev = 0xffff;
+            continue;
+        }
+        dst[n++] = src[i];
+        prev = (prev << 8) | src[i];
+    }
+
+    return n;
+}
+
+static RK_S32 ref_find_marker(const RK_U8 *buf, RK_S32 size, RK_U8 min, RK_U8 max)
+{
+    RK_S32 i;
+
+    for (i = 0; i + 1 < size; i++)
+        if (buf[i] == 0xff && buf[i + 1] >= min && buf[i + 1] <= max)
+            return i;
+
+    return size;
+}
+
+int main()
+{
+    RK_U8 *buf = mpp_malloc(RK_U8, PERF_BUF_SIZE);
+    RK_U8 *rbsp = mpp_malloc(RK_U8, TEST_BUF_SIZE + 8);
+    RK_U8 *ref = mpp_malloc(RK_U8, TEST_BUF_SIZE + 8);
+    RK_S32 i, j;
+    RK_S32 err = 0;
+    RK_S64 start;
+    RK_S64 end;
+
+    mpp_log("mpp_startcode_test start\n");
+
+    srand(0x1234);
+    for (i = 0; i < TEST_LOOP && !err; i++) {
+        RK_S32 size = rand() % TEST_BUF_SIZE;
+        RK_S32 off = rand() % 8;
+
+        /* sparse small values so prefixes and markers show up at random spots */
+        for (j = 0; j < size + off; j++) {
+            RK_S32 r = rand() % 64;
+
+            buf[j] = (r < 4) ? r : (r == 4) ? 0xff : (RK_U8)(0xc0 + rand() % 64);
+        }
+
+        if (mpp_find_startcode(buf + off, size) != ref_find_startcode(buf + off, size)) {
+            mpp_err("startcode mismatch size %d off %d\n", size, off);
+            err = 1;
+        }
+        if (mpp_find_prefix(buf + off, size, 0, 2) != ref_find_prefix(buf + off, size, 0, 2)) {
+            mpp_err("prefix mismatch size %d off %d\n", size, off);
+            err = 1;
+        }
+        {
+            RK_S32 ref_len = ref_rbsp_extract(ref, buf + off, size);
+            RK_S32 len = mpp_rbsp_extract(rbsp, buf + off, size);
+            RK_S32 len_inplace = mpp_rbsp_extract(buf + off, buf + off, size);
+
+            if (len != ref_len || len_inplace != ref_len ||
+                memcmp(rbsp, ref, len) || memcmp(buf + off, ref, len)) {
+                mpp_err("rbsp mismatch size %d off %d\n", size, off);
+                err = 1;
+            }
+        }
+        if (mpp_find_marker(buf + off, size, 0xc0, 0xfe) !=
+            ref_find_marker(buf + off, size, 0xc0, 0xfe)) {
+            mpp_err("marker mismatch size %d off %d\n", size, off);
+            err = 1;
+        }
+    }
+
+    /* a start code as the last three bytes must be found */
+    memset(buf, 0x55, 64);
+    buf[61] = 0;
+    buf[62] = 0;
+    buf[63] = 1;
+    if (mpp_find_startcode(buf, 64) != 61 || mpp_find_startcode(buf, 63) != 63) {
+        mpp_err("tail startcode check failed\n");
+        err = 1;
+    }
+
+    memset(buf, 0x55, PERF_BUF_SIZE);
+    start = mpp_time();
+    i = mpp_find_startcode(buf, PERF_BUF_SIZE);
+    end = mpp_time();
+    mpp_log("scan %d bytes for startcode in %lld us\n", PERF_BUF_SIZE, end - start);
+    if (i != PERF_BUF_SIZE)
+        err = 1;
+
+    MPP_FREE(buf);
+    MPP_FREE(rbsp);
+    MPP_FREE(ref);
+    mpp_log("mpp_startcode_test %s\n", err ? "failed" : "success");
+
+    return err;
+}
@@ -23,6 +23,7 @@
 #include "mpp_mem.h"
 #include "mpp_log.h"
 #include "mpp_packet_impl.h"
+#include "mpp_startcode.h"
 #include "hal_task.h"
 
 #include "avsd_api.h"
@@ -729,6 +730,19 @@ MPP_RET avsd_parse_prepare(AvsdCtx_t *p_dec, MppPacket *pkt, HalDecTask *task)
             }
             got_frame_flag = 1;
         }
+        //!< no start code can straddle here, jump to the next one
+        if ((prefix & 0xFF) && (prefix & 0xFFFFFF) != 0x000001) {
+            RK_U32 skip = mpp_find_startcode(p_curdata, pkt_length);
+            RK_U32 i;
+
+            if (skip) {
+                for (i = (skip > 4) ? skip - 4 : 0; i < skip; i++)
+                    prefix = (prefix << 8) | p_curdata[i];
+                p_curdata += skip;
+                pkt_length -= skip;
+                continue;
+            }
+        }
 
         prefix = (prefix << 8) | (*p_curdata);
         p_curdata++;
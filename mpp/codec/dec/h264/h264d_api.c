@@ -256,7 +256,9 @@ static MPP_RET init_dec_ctx(H264_DecCtx_t *p_Dec)
         reset_dpb_mark(&p_Dec->dpb_mark[i]);
         p_Dec->dpb_mark[i].mark_idx = i;
     }
-    mpp_buf_slot_setup(p_Dec->frame_slots, MAX_MARK_SIZE);
+    //!< grown to dpb size on sps activation
+    mpp_buf_slot_setup(p_Dec->frame_slots, p_Dec->p_Inp->init.task_count +
+                       p_Dec->p_Inp->init.display_delay + 1);
     //!< malloc mpp packet
     mpp_packet_init(&p_Dec->task_pkt, p_Dec->dxva_ctx->bitstream, p_Dec->dxva_ctx->max_strm_size);
     MEM_CHECK(ret, p_Dec->task_pkt);
@@ -22,6 +22,8 @@
 
 #include "mpp_mem.h"
 #include "mpp_packet_impl.h"
+#include "mpp_startcode.h"
+#include "mpp_rbsp.h"
 #include "hal_task.h"
 
 #include "h264d_global.h"
@@ -146,6 +148,45 @@ static void find_prefix_code(RK_U8 *p_data, H264dCurStream_t *p_strm)
     }
 }
 
+/*
+ * Bulk copy nalu payload up to the last byte of the next start code prefix.
+ * The last prefix byte is left to the per-byte loop to detect the end code.
+ * Caller makes sure the last consumed byte is not zero, so no prefix can
+ * straddle the consumed data.
+ */
+static MPP_RET copy_nalu_payload(H264dInputCtx_t *p_Inp, H264dCurStream_t *p_strm,
+                                 MppPacketImpl *pkt_impl)
+{
+    MPP_RET ret = MPP_OK;
+    RK_U8 *src = &p_Inp->in_buf[p_strm->nalu_offset];
+    RK_S32 len = (RK_S32)pkt_impl->length;
+    RK_S32 pos = mpp_find_startcode(src, len);
+    RK_U32 n = (pos < len) ? (RK_U32)pos + 2 : (RK_U32)len;
+    RK_U32 i;
+
+    if (!n)
+        return ret;
+
+    if (p_strm->nalu_len + n > p_strm->nalu_max_size) {
+        RK_U32 add_size = p_strm->nalu_len + n - p_strm->nalu_max_size;
+
+        FUN_CHECK(ret = realloc_buffer(&p_strm->nalu_buf, &p_strm->nalu_max_size,
+                                       MPP_MAX(NALU_BUF_ADD_SIZE, add_size)));
+    }
+    memcpy(&p_strm->nalu_buf[p_strm->nalu_len], src, n);
+    p_strm->nalu_len += n;
+    p_strm->nalu_offset += n;
+    pkt_impl->length -= n;
+
+    for (i = (n > 4) ? n - 4 : 0; i < n; i++)
+        p_strm->prefixdata = (p_strm->prefixdata << 8) | src[i];
+    p_strm->curdata = &src[n - 1];
+
+    return ret;
+__FAILED:
+    return ret;
+}
+
 static MPP_RET parser_nalu_header(H264_SLICE_t *currSlice)
 {
     MPP_RET ret = MPP_ERR_UNKNOW;
@@ -154,8 +195,8 @@ static MPP_RET parser_nalu_header(H264_SLICE_t *currSlice)
     BitReadCtx_t    *p_bitctx = &p_Cur->bitctx;
     H264_Nalu_t     *cur_nal  = &p_Cur->nalu;
 
+    /* head buffer holds rbsp, no emulation prevention detection needed */
     mpp_set_bitread_ctx(p_bitctx, cur_nal->sodb_buf, cur_nal->sodb_len);
-    mpp_set_pre_detection(p_bitctx);
 
     READ_BITS(p_bitctx, 1, &cur_nal->forbidden_bit);
     ASSERT(cur_nal->forbidden_bit == 0);
@@ -211,7 +252,6 @@ static MPP_RET parser_nalu_header(H264_SLICE_t *currSlice)
     mpp_set_bitread_ctx(p_bitctx,
                         cur_nal->sodb_buf + cur_nal->ualu_header_bytes,
                         cur_nal->sodb_len - cur_nal->ualu_header_bytes);
-    mpp_set_pre_detection(p_bitctx);
     p_Cur->p_Dec->nalu_ret = StartofNalu;
 
     return ret = MPP_OK;
@@ -339,16 +379,20 @@ static MPP_RET store_cur_nalu(H264dCurCtx_t *p_Cur, H264dCurStream_t *p_strm, H2
 
         RK_U32 head_size = MPP_MIN(HEAD_SYNTAX_MAX_SIZE, p_strm->nalu_len);
         RK_U32 add_size = head_size + sizeof(H264dNaluHead_t);
+        RK_U8 *p_head = NULL;
 
         if ((p_strm->head_offset + add_size) >= p_strm->head_max_size) {
             FUN_CHECK(ret = realloc_buffer(&p_strm->head_buf, &p_strm->head_max_size, add_size));
         }
         p_des = &p_strm->head_buf[p_strm->head_offset];
+        p_head = p_des + sizeof(H264dNaluHead_t);
+        memcpy(p_head, p_strm->nalu_buf, head_size);
+        /* extract rbsp in place, nothing moves if there is no 00 00 03 */
+        head_size = mpp_rbsp_extract(p_head, p_head, head_size);
         ((H264dNaluHead_t *)p_des)->is_frame_end  = 0;
         ((H264dNaluHead_t *)p_des)->nalu_type = p_strm->nalu_type;
         ((H264dNaluHead_t *)p_des)->sodb_len = head_size;
-        memcpy(p_des + sizeof(H264dNaluHead_t), p_strm->nalu_buf, head_size);
-        p_strm->head_offset += add_size;
+        p_strm->head_offset += head_size + sizeof(H264dNaluHead_t);
     }    //!< fill sodb buffer
     if ((p_strm->nalu_type == H264_NALU_TYPE_SLICE)
         || (p_strm->nalu_type == H264_NALU_TYPE_IDR)) {
@@ -553,6 +597,12 @@ MPP_RET parse_prepare(H264dInputCtx_t *p_Inp, H264dCurCtx_t *p_Cur)
     }
 
     while (pkt_impl->length > 0) {
+        if (p_strm->startcode_found && (p_strm->prefixdata & 0xff)
+            && p_strm->nalu_len >= NALU_TYPE_EXT_LENGTH) {
+            FUN_CHECK(ret = copy_nalu_payload(p_Inp, p_strm, pkt_impl));
+            if (!pkt_impl->length)
+                break;
+        }
         p_strm->curdata = &p_Inp->in_buf[p_strm->nalu_offset++];
         pkt_impl->length--;
         p_strm->prefixdata = (p_strm->prefixdata << 8) | (*p_strm->curdata);
@@ -628,6 +678,12 @@ MPP_RET parse_prepare_fast(H264dInputCtx_t *p_Inp, H264dCurCtx_t *p_Cur)
     p_Inp->task_valid = 0;
 
     while (pkt_impl->length > 0) {
+        if (p_strm->startcode_found && (p_strm->prefixdata & 0xff)
+            && p_strm->nalu_len >= NALU_TYPE_NORMAL_LENGTH) {
+            FUN_CHECK(ret = copy_nalu_payload(p_Inp, p_strm, pkt_impl));
+            if (!pkt_impl->length)
+                break;
+        }
         p_strm->curdata = &p_Inp->in_buf[p_strm->nalu_offset++];
         pkt_impl->length--;
         p_strm->prefixdata = (p_strm->prefixdata << 8) | (*p_strm->curdata);
@@ -541,6 +541,21 @@ __FAILED:
     return ret;
 }
 
+/*!
+***********************************************************************
+* \brief
+*    size frame slots from dpb, frames in flight and frames for display
+***********************************************************************
+*/
+static void update_frame_slots(H264dVideoCtx_t *p_Vid)
+{
+    ParserCfg *cfg = &p_Vid->p_Inp->init;
+    RK_S32 count = p_Vid->dpb_size[0] + p_Vid->dpb_size[1] + 1;
+
+    count += cfg->task_count + cfg->display_delay;
+    mpp_buf_slot_setup(p_Vid->p_Dec->frame_slots, MPP_MIN(count, MAX_MARK_SIZE));
+}
+
 /*!
 ***********************************************************************
 * \brief
@@ -567,6 +582,7 @@ MPP_RET activate_sps(H264dVideoCtx_t *p_Vid, H264_SPS_t *sps, H264_subSPS_t *sub
             update_last_video_pars(p_Vid, p_Vid->active_sps, 1);
             //!< init frame slots, store frame buffer size
             p_Vid->dpb_size[1] = p_Vid->p_Dpb_layer[1]->size;
+            update_frame_slots(p_Vid);
         }
         VAL_CHECK(ret, p_Vid->dpb_size[1] > 0);
     } else { //!< layer_id == 0
@@ -583,6 +599,7 @@ MPP_RET activate_sps(H264dVideoCtx_t *p_Vid, H264_SPS_t *sps, H264_subSPS_t *sub
             update_last_video_pars(p_Vid, p_Vid->active_sps, 0);
             //!< init frame slots, store frame buffer size
             p_Vid->dpb_size[0] = p_Vid->p_Dpb_layer[0]->size;
+            update_frame_slots(p_Vid);
         }
         VAL_CHECK(ret, p_Vid->dpb_size[0] > 0);
     }
@@ -31,6 +31,8 @@
 #include "mpp_mem.h"
 #include "mpp_bitread.h"
 #include "mpp_packet_impl.h"
+#include "mpp_startcode.h"
+#include "mpp_rbsp.h"
 
 #include "h265d_parser.h"
 #include "h265d_syntax.h"
@@ -58,8 +60,25 @@ static RK_S32 hevc_find_frame_end(SplitContext_t *sc, const RK_U8 *buf,
 
         sc->state64 = (sc->state64 << 8) | buf[i];
 
-        if (((sc->state64 >> 3 * 8) & 0xFFFFFF) != START_CODE)
+        if (((sc->state64 >> 3 * 8) & 0xFFFFFF) != START_CODE) {
+            RK_S32 next, j;
+
+            /* jump to the next start code prefix, the bytes before it can not end a frame */
+            if (i < 8)
+                continue;
+
+            next = i - 4 + mpp_find_startcode(buf + i - 4, buf_size - i + 4);
+            next = MPP_MIN(next, buf_size - 2);
+            if (next <= i + 1)
+                continue;
+
+            sc->state64 = 0;
+            for (j = next - 8; j < next; j++)
+                sc->state64 = (sc->state64 << 8) | buf[j];
+
+            i = next - 1;
             continue;
+        }
         nut = (sc->state64 >> (2 * 8 + 1)) & 0x3F;
         layer_id  =  (((sc->state64 >> 2 * 8) & 0x01) << 5) + (((sc->state64 >> 1 * 8) & 0xF8) >> 3);
         //mpp_log("nut = %d layer_id = %d\n",nut,layer_id);
@@ -504,6 +523,10 @@ static RK_S32 set_sps(HEVCContext *s, const HEVCSPS *sps)
     s->sps = sps;
     s->vps = (HEVCVPS*) s->vps_list[s->sps->vps_id];
 
+    /* dpb size of the highest sub layer, grow frame slots on demand */
+    mpp_buf_slot_setup(s->slots, sps->temporal_layer[sps->max_sub_layers - 1].max_dec_pic_buffering +
+                       s->slots_extra);
+
     if (s->vps->vps_timing_info_present_flag) {
         num = s->vps->vps_num_units_in_tick;
         den = s->vps->vps_time_scale;
@@ -1242,14 +1265,16 @@ fail:
     return ret;
 }
 
-static RK_S32 parser_nal_unit(HEVCContext *s, const RK_U8 *nal, int length)
+static RK_S32 parser_nal_unit(HEVCContext *s, const RK_U8 *nal, int length,
+                              RK_S32 is_rbsp)
 {
 
     HEVCLocalContext *lc = s->HEVClc;
     BitReadCtx_t *gb    = &lc->gb;
     RK_S32 ret;
     mpp_set_bitread_ctx(gb, (RK_U8*)nal, length);
-    mpp_set_pre_detection(gb);
+    if (!is_rbsp)
+        mpp_set_pre_detection(gb);
     ret = hls_nal_unit(s);
     if (ret < 0) {
         mpp_err("Invalid NAL unit %d, skipping.\n",
@@ -1395,79 +1420,59 @@ fail:
 }
 
 
-typedef union {
-    RK_U32  u32;
-    RK_U16  u16[2];
-    RK_U8   u8 [4];
-    float   f32;
-} mpp_alias32;
-
-#define MPP_FAST_UNALIGNED 1
-
-
-#ifndef MPP_RN32A
-#define MPP_RN32A(p) (((const mpp_alias32*)(p))->u32)
-#endif
 RK_S32 mpp_hevc_extract_rbsp(HEVCContext *s, const RK_U8 *src, int length,
                              HEVCNAL *nal)
 {
-    RK_S32 i;
-
     s->skipped_bytes = 0;
 
-#define STARTCODE_TEST                                              \
-    if (i + 2 < length && src[i + 1] == 0 && src[i + 2] < 3) {      \
-            /* startcode, so we must be past the end */             \
-        length = i;                                                 \
-        break;                                                      \
-    }
+    /* the nal ends at the next 00 00 00, 00 00 01 or 00 00 02 */
+    length = mpp_find_prefix(src, length, 0, 2);
 
-#if MPP_FAST_UNALIGNED
-#define FIND_FIRST_ZERO                                             \
-    if (i > 0 && !src[i])                                           \
-        i--;                                                        \
-    while (src[i])                                                  \
-        i++
+    /* view into the input stream, hevc_pin_nals makes it safe to keep */
+    nal->data = src;
+    nal->size = length;
+    nal->is_view = 1;
+    nal->is_rbsp = 0;
 
-    for (i = 0; i + 1 < length; i += 5) {
-        if (!((~MPP_RN32A(src + i) &
-               (MPP_RN32A(src + i) - 0x01000101U)) &
-              0x80008080U))
-            continue;
+    return length;
+}
+
+/*
+ * The input stream may be released between prepare and parse. Slice nals
+ * are already pointed to the assembled stream by h265d_syntax_fill_slice.
+ * The others are extracted into rbsp_buffer which also drops the emulation
+ * prevention bytes.
+ */
+static MPP_RET hevc_pin_nals(HEVCContext *s)
+{
+    RK_S32 i;
 
-        FIND_FIRST_ZERO;
+    for (i = 0; i < s->nb_nals; i++) {
+        HEVCNAL *nal = &s->nals[i];
+        RK_S32 min_size = nal->size + MPP_INPUT_BUFFER_PADDING_SIZE;
 
-        STARTCODE_TEST;
-        i -= 3;
-    }
-#else
-    for (i = 0; i + 1 < length; i += 2) {
-        if (src[i])
+        if (!nal->is_view)
             continue;
-        if (i > 0 && src[i - 1] == 0)
-            i--;
-        STARTCODE_TEST;
-    }
-#endif
 
-    if (length + MPP_INPUT_BUFFER_PADDING_SIZE > nal->rbsp_buffer_size) {
-        RK_S32 min_size = length + MPP_INPUT_BUFFER_PADDING_SIZE;
-        mpp_free(nal->rbsp_buffer);
-        nal->rbsp_buffer = NULL;
-        min_size = MPP_MAX(17 * min_size / 16 + 32, min_size);
-        nal->rbsp_buffer = mpp_malloc(RK_U8, min_size);
-        if (nal->rbsp_buffer == NULL) {
-            min_size = 0;
+        if (min_size > nal->rbsp_buffer_size) {
+            min_size = MPP_MAX(17 * min_size / 16 + 32, min_size);
+            mpp_free(nal->rbsp_buffer);
+            nal->rbsp_buffer = mpp_malloc(RK_U8, min_size);
+            if (NULL == nal->rbsp_buffer) {
+                nal->rbsp_buffer_size = 0;
+                return MPP_ERR_NOMEM;
+            }
+            nal->rbsp_buffer_size = min_size;
         }
-        nal->rbsp_buffer_size = min_size;
-    }
 
-    memcpy(nal->rbsp_buffer, src, length);
-    nal->data = nal->rbsp_buffer;
-    nal->size = length;
+        nal->size = mpp_rbsp_extract(nal->rbsp_buffer, nal->data, nal->size);
+        memset(nal->rbsp_buffer + nal->size, 0, MPP_INPUT_BUFFER_PADDING_SIZE);
+        nal->data = nal->rbsp_buffer;
+        nal->is_view = 0;
+        nal->is_rbsp = 1;
+    }
 
-    memset(nal->rbsp_buffer + length, 0, MPP_INPUT_BUFFER_PADDING_SIZE);
-    return length;
+    return MPP_OK;
 }
 
 static RK_S32 split_nal_units(HEVCContext *s, RK_U8 *buf, RK_U32 length)
@@ -1594,7 +1599,8 @@ static RK_S32 parser_nal_units(HEVCContext *s)
     RK_S32 i, ret = 0, slice_cnt = 0;
 
     for (i = 0; i < s->nb_nals; i++) {
-        ret = parser_nal_unit(s, s->nals[i].data, s->nals[i].size);
+        ret = parser_nal_unit(s, s->nals[i].data, s->nals[i].size,
+                              s->nals[i].is_rbsp);
         if (ret < 0) {
             mpp_err("Error parsing NAL unit #%d,error ret = 0xd.\n", i, ret);
             goto fail;
@@ -1687,7 +1693,7 @@ static RK_S32 hevc_parser_extradata(HEVCContext *s)
                 if (size < length) {
                     return MPP_NOK;
                 }
-                parser_nal_unit(s, ptr, length);
+                parser_nal_unit(s, ptr, length, 0);
                 ptr += length;
                 size -= length;
             }
@@ -1782,9 +1788,16 @@ MPP_RET h265d_prepare(void *ctx, MppPacket pkt, HalDecTask *task)
 
     if (MPP_OK == ret) {
         if (MPP_OK == h265d_syntax_fill_slice(s->h265dctx, task->input)) {
+            h265d_dxva2_picture_context_t *ctx_pic =
+                (h265d_dxva2_picture_context_t *)s->hal_pic_private;
+
             task->valid = 1;
-            task->input_packet = s->input_packet;
+            task->input_packet = (ctx_pic->bitstream) ?
+                                 s->direct_packet : s->input_packet;
         }
+        ret = hevc_pin_nals(s);
+        if (ret)
+            task->valid = 0;
     }
     return ret;
 
@@ -1889,6 +1902,8 @@ MPP_RET h265d_deinit(void *ctx)
         mpp_free(buf);
         mpp_packet_deinit(&s->input_packet);
     }
+    if (s->direct_packet)
+        mpp_packet_deinit(&s->direct_packet);
 
     if (s) {
         mpp_free(s);
@@ -1976,6 +1991,7 @@ MPP_RET h265d_init(void *ctx, ParserCfg *parser_cfg)
     s->picture_struct = 0;
 
     s->slots = parser_cfg->frame_slots;
+    s->slots_extra = parser_cfg->task_count + parser_cfg->display_delay;
 
     s->packet_slots = parser_cfg->packet_slots;
 
@@ -1996,7 +2012,11 @@ MPP_RET h265d_init(void *ctx, ParserCfg *parser_cfg)
     if (MPP_OK != mpp_packet_init(&s->input_packet, (void*)buf, size)) {
         return MPP_ERR_NOMEM;
     }
-    mpp_buf_slot_setup(s->slots, 25);
+    if (MPP_OK != mpp_packet_init(&s->direct_packet, NULL, 0)) {
+        return MPP_ERR_NOMEM;
+    }
+    // grown to dpb size on sps activation
+    mpp_buf_slot_setup(s->slots, s->slots_extra + 1);
 #ifdef dump
     fp = fopen("/data/dump1.bin", "wb+");
 #endif
@@ -2074,7 +2094,7 @@ const ParserApi api_h265d_parser = {
     .name = "h265d_parse",
     .coding = MPP_VIDEO_CodingHEVC,
     .ctx_size = sizeof(H265dContext_t),
-    .flag = 0,
+    .flag = PARSER_FLAG_DIRECT_PKT_BUF,
     .init = h265d_init,
     .deinit = h265d_deinit,
     .prepare = h265d_prepare,
@@ -464,6 +464,8 @@ typedef struct HEVCNAL {
     RK_S32 rbsp_buffer_size;
     RK_S32 size;
     const RK_U8 *data;
+    RK_U8 is_view;  ///< data points into the input stream
+    RK_U8 is_rbsp;  ///< emulation prevention bytes are removed from data
 } HEVCNAL;
 
 typedef struct HEVCLocalContext {
@@ -584,11 +586,15 @@ typedef struct HEVCContext {
     MppFrameContentLightMetadata content_light;
 
     MppBufSlots slots;
+    /* frame slots besides dpb for tasks in flight and frames for display */
+    RK_S32      slots_extra;
 
     MppBufSlots packet_slots;
     HalDecTask *task;
 
     MppPacket input_packet;
+    /* packet on packet slot hardware buffer for direct stream assembly */
+    MppPacket direct_packet;
     void *hal_pic_private;
 
     RK_S64 pts;
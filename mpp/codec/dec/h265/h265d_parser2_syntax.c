@@ -324,21 +324,28 @@ RK_S32 h265d_syntax_fill_slice(void *ctx, RK_S32 input_index)
     RK_U8 *ptr = NULL;
     RK_U8 *current = NULL;
     RK_U32 size = 0, length = 0;
-    // mpp_err("input_index = %d",input_index);
+
+    size = (RK_U32)mpp_packet_get_size(h->input_packet);
+    for (i = 0; i < h->nb_nals; i++) {
+        length += h->nals[i].size;
+    }
+    length = MPP_ALIGN(length, 16) + 64;
+
+    /*
+     * When mpp_dec provides packet slot with hardware buffer assemble the
+     * stream into it directly. The buffer should be no smaller than internal
+     * packet which is used for copy mode. Otherwise fallback to copy mode.
+     */
     if (-1 != input_index) {
         mpp_buf_slot_get_prop(h->packet_slots, input_index, SLOT_BUFFER, &streambuf);
-        current = ptr = (RK_U8 *)mpp_buffer_get_ptr(streambuf);
-        if (current == NULL) {
-            return MPP_ERR_NULL_PTR;
-        }
-    } else {
+        if (streambuf && mpp_buffer_get_size(streambuf) >= MPP_MAX(length, size))
+            current = ptr = (RK_U8 *)mpp_buffer_get_ptr(streambuf);
+    }
+
+    if (NULL == ptr) {
         RK_S32 buff_size = 0;
+
         current = (RK_U8 *)mpp_packet_get_data(h->input_packet);
-        size = (RK_U32)mpp_packet_get_size(h->input_packet);
-        for (i = 0; i < h->nb_nals; i++) {
-            length += h->nals[i].size;
-        }
-        length = MPP_ALIGN(length, 16) + 64;
         if (length > size) {
             mpp_free(current);
             buff_size = MPP_ALIGN(length + 10 * 1024, 1024);
@@ -371,6 +378,9 @@ RK_S32 h265d_syntax_fill_slice(void *ctx, RK_S32 input_index)
         current += start_code_size;
         position += start_code_size;
         memcpy(current, h->nals[i].data, h->nals[i].size);
+        /* parse the slice from the assembled stream, the input may be gone */
+        h->nals[i].data = current;
+        h->nals[i].is_view = 0;
         // mpp_log("h->nals[%d].size = %d", i, h->nals[i].size);
         fill_slice_short(&ctx_pic->slice_short[count], position, h->nals[i].size);
         init_slice_cut_param(&ctx_pic->slice_cut_param[count]);
@@ -380,11 +390,13 @@ RK_S32 h265d_syntax_fill_slice(void *ctx, RK_S32 input_index)
     }
     ctx_pic->slice_count    = count;
     ctx_pic->bitstream_size = position;
-    if (-1 != input_index) {
+    if (ptr) {
+        /* mpp_dec will find the data is in hardware buffer and skip copy */
         ctx_pic->bitstream      = (RK_U8*)ptr;
 
-        mpp_buf_slot_set_flag(h->packet_slots, input_index, SLOT_CODEC_READY);
-        mpp_buf_slot_set_flag(h->packet_slots, input_index, SLOT_HAL_INPUT);
+        mpp_packet_set_data(h->direct_packet, ptr);
+        mpp_packet_set_size(h->direct_packet, mpp_buffer_get_size(streambuf));
+        mpp_packet_set_length(h->direct_packet, position);
     } else {
         ctx_pic->bitstream = NULL;
         mpp_packet_set_length(h->input_packet, position);
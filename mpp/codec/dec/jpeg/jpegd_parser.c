@@ -21,6 +21,7 @@
 #include "mpp_mem.h"
 #include "mpp_bitread.h"
 #include "mpp_packet_impl.h"
+#include "mpp_startcode.h"
 
 #include "jpegd_api.h"
 #include "jpegd_parser.h"
@@ -32,28 +33,26 @@ RK_U32 jpegd_debug = 0x0;
    state. Return -1 if no start code found */
 static RK_S32 jpegd_find_marker(const RK_U8 **pbuf_ptr, const RK_U8 *buf_end)
 {
-    const RK_U8 *buf_ptr;
-    unsigned int v, v2;
+    const RK_U8 *buf_ptr = *pbuf_ptr;
+    RK_S32 size = (RK_S32)(buf_end - buf_ptr);
+    RK_S32 skipped;
     int val;
-    int skipped = 0;
-
-    buf_ptr = *pbuf_ptr;
-    while (buf_end - buf_ptr > 1) {
-        v  = *buf_ptr++;
-        v2 = *buf_ptr;
-        if ((v == 0xff) && (v2 >= 0xc0) && (v2 <= 0xfe) && buf_ptr < buf_end) {
-            val = *buf_ptr++;
-            goto found;
-        } else if ((v == 0x89) && (v2 == 0x50)) {
-            // many usb camera go here, log if set jpegd debug
-            jpegd_dbg_marker("input img maybe png format,check it\n");
-        }
-        skipped++;
+
+    if (size > 1 && buf_ptr[0] == 0x89 && buf_ptr[1] == 0x50) {
+        // many usb camera go here, log if set jpegd debug
+        jpegd_dbg_marker("input img maybe png format,check it\n");
+    }
+
+    skipped = mpp_find_marker(buf_ptr, size, 0xc0, 0xfe);
+    if (skipped < size) {
+        val = buf_ptr[skipped + 1];
+        buf_ptr += skipped + 2;
+    } else {
+        skipped = MPP_MAX(size - 1, 0);
+        buf_ptr = buf_end;
+        val = -1;
     }
-    buf_ptr = buf_end;
-    val = -1;
 
-found:
     jpegd_dbg_marker("find_marker skipped %d bytes\n", skipped);
     *pbuf_ptr = buf_ptr;
     return val;
@@ -20,6 +20,7 @@
 
 #include "mpp_env.h"
 #include "mpp_packet_impl.h"
+#include "mpp_startcode.h"
 
 #include "m2vd_parser.h"
 #include "m2vd_codec.h"
@@ -143,7 +144,9 @@ static MPP_RET m2vd_parser_init_ctx(M2VDParserContext *ctx, ParserCfg *cfg)
     ctx->packet_slots = cfg->packet_slots;
     ctx->frame_slots = cfg->frame_slots;
 
-    mpp_buf_slot_setup(ctx->frame_slots, 16);
+    /* reference frames, current frame, frames in flight and frames for display */
+    mpp_buf_slot_setup(ctx->frame_slots, MPP_ARRAY_ELEMS(ctx->Framehead) +
+                       cfg->task_count + cfg->display_delay);
 
     ctx->initFlag = 0;
 
@@ -426,6 +429,20 @@ MPP_RET mpp_m2vd_parser_split(M2VDParserContext *ctx, MppPacket dst, MppPacket s
 
     if (p->vop_header_found) {
         while (src_pos < src_len) {
+            if (p->state & 0xff) {
+                /* no prefix can straddle the copied data, copy up to the next one */
+                RK_U32 n = mpp_find_startcode(src_buf + src_pos, src_len - src_pos);
+                RK_U32 i;
+
+                if (n) {
+                    memcpy(dst_buf + dst_len, src_buf + src_pos, n);
+                    for (i = (n > 4) ? n - 4 : 0; i < n; i++)
+                        p->state = (p->state << 8) | src_buf[src_pos + i];
+                    dst_len += n;
+                    src_pos += n;
+                    continue;
+                }
+            }
             p->state = (p->state << 8) | src_buf[src_pos];
             dst_buf[dst_len++] = src_buf[src_pos++];
 
@@ -546,18 +563,31 @@ MPP_RET m2vd_parser_prepare(void *ctx, MppPacket pkt, HalDecTask *task)
 ***********************************************************************
 */
 
+static void m2vd_skip_bytes(BitReadCtx_t *bx, RK_S32 bytes)
+{
+    bytes = MPP_MIN(bytes, (RK_S32)bx->bytes_left_);
+    bx->data_ += bytes;
+    bx->bytes_left_ -= bytes;
+    bx->used_bits += bytes * 8;
+}
+
 static RK_U32 m2vd_search_header(BitReadCtx_t *bx)
 {
+    RK_S32 left;
+    RK_S32 pos;
+
+    /* byte aligned after this, scan the rest of the stream for 00 00 01 */
     mpp_align_get_bits(bx);
-    while (m2vd_show_bits(bx, 24) != 0x01) {
-        mpp_skip_bits(bx, 8);
-        if (m2vd_get_leftbits(bx) < 32) {
-            if (M2VD_DBG_SEC_HEADER & m2vd_debug) {
-                mpp_log("[m2v]: seach_header: str.leftbit()[%d] < 32", m2vd_get_leftbits(bx));
-            }
-            return NO_MORE_STREAM;
+    left = bx->bytes_left_;
+    pos = mpp_find_startcode(bx->data_, left);
+    if (pos == left || (pos && left - pos < 4)) {
+        m2vd_skip_bytes(bx, MPP_MAX(left - 3, 1));
+        if (M2VD_DBG_SEC_HEADER & m2vd_debug) {
+            mpp_log("[m2v]: seach_header: str.leftbit()[%d] < 32", m2vd_get_leftbits(bx));
         }
+        return NO_MORE_STREAM;
     }
+    m2vd_skip_bytes(bx, pos);
     return m2vd_show_bits(bx, 32);
 }
 
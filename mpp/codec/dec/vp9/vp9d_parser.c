@@ -359,7 +359,9 @@ MPP_RET vp9d_parser_init(Vp9CodecContext *vp9_ctx, ParserCfg *init)
 
     s->packet_slots = init->packet_slots;
     s->slots = init->frame_slots;
-    mpp_buf_slot_setup(s->slots, 25);
+    /* reference frames, current frames, frames in flight and frames for display */
+    mpp_buf_slot_setup(s->slots, MPP_ARRAY_ELEMS(s->refs) + MPP_ARRAY_ELEMS(s->frames) +
+                       init->task_count + init->display_delay);
 
     mpp_env_get_u32("vp9d_debug", &vp9d_debug, 0);
     vp9d_debug = 1;
@@ -936,6 +936,96 @@ RK_S32 h264e_slice_write_pskip(H264eSlice *slice, void *p, RK_U32 size)
     return bitCnt;
 }
 
+#define WORD_HAS_ZERO(v)    (((v) - 0x0101010101010101ULL) & ~(v) & 0x8080808080808080ULL)
+/* exact zero byte flag at bit 7 of each byte */
+#define WORD_ZERO_FLAG(v)   (~((((v) & 0x7f7f7f7f7f7f7f7fULL) + 0x7f7f7f7f7f7f7f7fULL) | (v)) & \
+                             0x8080808080808080ULL)
+
+static RK_U64 load_be64(const RK_U8 *p)
+{
+    return ((RK_U64)p[0] << 56) | ((RK_U64)p[1] << 48) |
+           ((RK_U64)p[2] << 40) | ((RK_U64)p[3] << 32) |
+           ((RK_U64)p[4] << 24) | ((RK_U64)p[5] << 16) |
+           ((RK_U64)p[6] << 8)  | ((RK_U64)p[7]);
+}
+
+static void store_be64(RK_U8 *p, RK_U64 v)
+{
+    p[0] = (RK_U8)(v >> 56);
+    p[1] = (RK_U8)(v >> 48);
+    p[2] = (RK_U8)(v >> 40);
+    p[3] = (RK_U8)(v >> 32);
+    p[4] = (RK_U8)(v >> 24);
+    p[5] = (RK_U8)(v >> 16);
+    p[6] = (RK_U8)(v >> 8);
+    p[7] = (RK_U8)(v);
+}
+
+/*
+ * Shift source to destination in 64bit words and return the word count.
+ * Stop at the word which may need emulation prevention handling and let the
+ * byte loop take over.
+ *
+ * Without zero byte in the source there is no 00 00 03 to remove and the
+ * only way to get two zero bytes in a row on output is 16 zero bits in the
+ * source. So a word is safe when the source has no zero byte and the output
+ * has no adjacent zero bytes.
+ */
+static RK_S32 slice_move_words(RK_U8 *pdst, const RK_U8 *psrc, RK_S32 words,
+                               RK_S32 src_bit_r, RK_S32 dst_bit_r,
+                               RK_U16 dst_mask, RK_U16 *last)
+{
+    RK_S32 shift = src_bit_r - dst_bit_r;
+    RK_U64 prev = 1;
+    RK_U16 tmp16b;
+    RK_U16 tmp16c;
+    RK_S32 n;
+
+    for (n = 0; n < words; n++, psrc += 8) {
+        RK_U64 v = load_be64(psrc);
+        RK_U64 out;
+        RK_U64 zero;
+
+        if (WORD_HAS_ZERO(v))
+            break;
+
+        /* output is the source bit stream read at the shifted position */
+        if (shift > 0)
+            out = (v << shift) | (psrc[8] >> (8 - shift));
+        else if (shift < 0)
+            out = (v >> -shift) | (n ? (RK_U64)psrc[-1] << (64 + shift) : 0);
+        else
+            out = v;
+
+        if (!n) {
+            /* first byte merges the last output byte as the byte loop does */
+            tmp16b = (RK_U16)((((RK_U16)psrc[0] << 8) | psrc[1]) << src_bit_r);
+            tmp16c = dst_bit_r ? (tmp16b >> dst_bit_r | ((*last << 8) & dst_mask)) : tmp16b;
+            out = (out & 0x00ffffffffffffffULL) | ((RK_U64)(tmp16c >> 8) << 56);
+        }
+
+        zero = WORD_ZERO_FLAG(out);
+        if ((zero & (zero << 8)) || (!(prev & 0xff) && !(out >> 56)))
+            break;
+
+        store_be64(pdst + n * 8, out);
+        prev = out;
+    }
+
+    if (n) {
+        /* keep the last 16bit step of the byte loop for the next byte */
+        tmp16b = (RK_U16)((((RK_U16)psrc[-2] << 8) | psrc[-1]) << src_bit_r);
+        tmp16c = (RK_U16)((((RK_U16)psrc[-1] << 8) | psrc[0]) << src_bit_r);
+        if (dst_bit_r)
+            tmp16c = tmp16c >> dst_bit_r | (((tmp16b >> dst_bit_r) << 8) & dst_mask);
+
+        pdst[n * 8] = tmp16c & 0xFF;
+        *last = tmp16c;
+    }
+
+    return n;
+}
+
 RK_S32 h264e_slice_move(RK_U8 *dst, RK_U8 *src, RK_S32 dst_bit, RK_S32 src_bit, RK_S32 src_size)
 {
     RK_S32 dst_byte = dst_bit / 8;
@@ -969,6 +1059,7 @@ RK_S32 h264e_slice_move(RK_U8 *dst, RK_U8 *src, RK_S32 dst_bit, RK_S32 src_bit,
     RK_U32 src_zero_cnt = 0;
     RK_U32 dst_zero_cnt = 0;
     RK_U32 dst_len = 0;
+    RK_U32 word_mode = !(h264e_debug & H264E_DBG_SLICE);
 
     last_tmp = (RK_U16)pdst[0];
     dst_mask = 0xFFFF << (8 - dst_bit_r);
@@ -978,6 +1069,22 @@ RK_S32 h264e_slice_move(RK_U8 *dst, RK_U8 *src, RK_S32 dst_bit, RK_S32 src_bit,
                     src_bit_r, dst_bit_r, loop, dst_mask, last_tmp);
 
     for (i = 0; i < loop; i++) {
+        if (word_mode && !dst_zero_cnt && i + 8 < loop) {
+            RK_S32 words = slice_move_words(pdst, psrc, (loop - 1 - i) / 8,
+                                            src_bit_r, dst_bit_r, dst_mask,
+                                            &last_tmp);
+
+            if (words) {
+                psrc += words * 8;
+                pdst += words * 8;
+                dst_len += words * 8;
+                i += words * 8 - 1;
+                dst_zero_cnt = (pdst[-1] == 0);
+                src_zero_cnt = 0;
+                continue;
+            }
+        }
+
         if (psrc[0] == 0) {
             src_zero_cnt++;
         } else {
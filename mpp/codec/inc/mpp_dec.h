@@ -23,12 +23,22 @@
 
 typedef void* MppDec;
 
+/* frame slots kept for frames waiting for display besides the dpb */
+#define MPP_DEC_DEFAULT_DISPLAY_DELAY   (4)
+#define MPP_DEC_MAX_DISPLAY_DELAY       (16)
+
+/* fast mode hal keeps three register sets for the tasks on hardware */
+#define MPP_DEC_MAX_PIPELINE_DEPTH      (3)
+
 typedef struct {
     MppCodingType       coding;
     RK_U32              fast_mode;
     RK_U32              need_split;
     RK_U32              internal_pts;
     RK_U32              immedaite_out;
+    RK_U32              display_delay;
+    /* 0 - decided by fast_mode, N - N tasks on hardware at once */
+    RK_U32              pipeline_depth;
     void                *mpp;
 } MppDecCfg;
 
@@ -83,13 +83,16 @@ typedef struct MppDecImpl_t {
     // work mode flags
     RK_U32              parser_need_split;
     RK_U32              parser_fast_mode;
+    RK_U32              pipeline_depth;
     RK_U32              parser_internal_pts;
+    RK_U32              parser_direct_pkt_buf;
     RK_U32              disable_error;
     RK_U32              use_preset_time_order;
     RK_U32              enable_deinterlace;
 
     // dec parser thread runtime resource context
     MppPacket           mpp_pkt_in;
+    size_t              pkt_buf_size;
     void                *mpp;
     void                *vproc;
 
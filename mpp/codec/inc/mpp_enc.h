@@ -151,8 +151,23 @@
 
 typedef void* MppEnc;
 
+/*
+ * Pipelined encoding keeps one frame on hardware while the next one is being
+ * prepared. Both frames need their own input and output task.
+ */
+#define MPP_ENC_MAX_PIPELINE_DEPTH      (2)
+
+/*
+ * Low delay output returns the finished slices of a frame on hardware in
+ * partition packets. They need spare output tasks besides the frame's own.
+ * The tasks are only allocated when low delay output is set before init.
+ */
+#define MPP_ENC_PARTITION_TASK_CNT      (4)
+
 typedef struct MppEncInitCfg_t {
     MppCodingType       coding;
+    RK_U32              pipeline_depth;
+    RK_U32              partition_task_cnt;
     void                *mpp;
 } MppEncInitCfg;
 
@@ -27,6 +27,7 @@ extern "C" {
 
 MPP_RET mpp_parser_init(Parser *prs, ParserCfg *cfg);
 MPP_RET mpp_parser_deinit(Parser prs);
+RK_U32  mpp_parser_get_flag(Parser prs);
 
 MPP_RET mpp_parser_prepare(Parser prs, MppPacket pkt, HalDecTask *task);
 MPP_RET mpp_parser_parse(Parser prs, HalDecTask *task);
@@ -39,6 +39,8 @@ typedef struct DecParserInitCfg_t {
     RK_U32          need_split;
     RK_U32          immediate_out;
     RK_U32          internal_pts;
+    // frame slot count is dpb size + task_count + display_delay
+    RK_U32          display_delay;
 } ParserCfg;
 
 
@@ -49,7 +51,7 @@ typedef struct DecParserInitCfg_t {
  * name     - decoder name
  * coding   - decoder coding type
  * ctx_size - decoder context size, mpp_dec will use this to malloc memory
- * flag     - reserve
+ * flag     - parser capability flags, see PARSER_FLAG_XXX
  *
  * init     - decoder initialization function
  * deinit   - decoder de-initialization function
@@ -58,6 +60,16 @@ typedef struct DecParserInitCfg_t {
  * flush    - decoder output all frames
  * control  - decoder configure function
  */
+/*
+ * PARSER_FLAG_DIRECT_PKT_BUF
+ * Parser prepare can assemble the stream into the hardware buffer of packet
+ * slot task->input directly. mpp_dec will get the packet slot and its buffer
+ * before prepare. When task->input_packet data is the slot buffer after
+ * prepare the copy to hardware buffer is skipped. When the slot buffer is not
+ * available or too small parser should fallback to its internal packet.
+ */
+#define PARSER_FLAG_DIRECT_PKT_BUF      (0x00000001)
+
 typedef struct ParserApi_t {
     char            *name;
     MppCodingType   coding;
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2016 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __RC_HISTORY_H__
+#define __RC_HISTORY_H__
+
+#include "mpp_frame.h"
+#include "mpp_rc_defs.h"
+
+/*
+ * Cpu complexity pre-pass before rate control on the frame history
+ *
+ * No frame after the current one is read. The luma of the input frame is
+ * reduced to 8x8 block means. Gradient of the thumbnail is the intra cost
+ * estimation and the difference to the previous thumbnail is the inter cost
+ * estimation. The result is reported in EncRcTaskInfo before rc_frm_start:
+ *
+ * hist_ratio       - frame cost against the mean of last depth frames in 1/16
+ * hist_scene_cut   - inter cost against intra cost, 128 for equal, max 256
+ *
+ * Both are zero when the frame can not be analyzed.
+ */
+#define RC_HIST_SCENE_CUT_UNIT  128
+#define RC_HIST_SCENE_CUT_MAX   (RC_HIST_SCENE_CUT_UNIT * 2)
+/* previous frame does not make the frame cheaper than intra coding */
+#define RC_HIST_SCENE_CUT_THD   RC_HIST_SCENE_CUT_UNIT
+
+typedef void* RcHistory;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET rc_history_init(RcHistory *ctx, RK_S32 depth);
+MPP_RET rc_history_deinit(RcHistory ctx);
+MPP_RET rc_history_proc(RcHistory ctx, MppFrame frame, EncRcTaskInfo *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RC_HISTORY_H__ */
@@ -243,6 +243,12 @@ static RK_U32 reset_parser_thread(Mpp *mpp, DecTask *task)
             mpp_buf_slot_clr_flag(packet_slots, task_dec->input,  SLOT_HAL_INPUT);
             task->status.dec_pkt_copy_rdy = 0;
             task_dec->input = -1;
+        } else if (task_dec->input >= 0) {
+            /* release the packet slot which is got but not used by hardware */
+            mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_CODEC_READY);
+            mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_HAL_INPUT);
+            mpp_buf_slot_clr_flag(packet_slots, task_dec->input, SLOT_HAL_INPUT);
+            task_dec->input = -1;
         }
 
         task->status.task_parsed_rdy = 0;
@@ -331,11 +337,11 @@ static void mpp_dec_put_frame(Mpp *mpp, RK_S32 index, HalDecTaskFlag flags)
     if (!change) {
         if (dec->use_preset_time_order) {
             MppPacket pkt = NULL;
-            mpp_list *ts = mpp->mTimeStamps;
+            MppPtrQueue *ts = mpp->mTimeStamps;
 
             AutoMutex autoLock(ts->mutex());
             if (ts->list_size()) {
-                ts->del_at_head(&pkt, sizeof(pkt));
+                ts->pop(&pkt);
                 mpp_frame_set_dts(frame, mpp_packet_get_dts(pkt));
                 mpp_frame_set_pts(frame, mpp_packet_get_pts(pkt));
                 mpp_packet_deinit(&pkt);
@@ -388,7 +394,7 @@ static void mpp_dec_put_frame(Mpp *mpp, RK_S32 index, HalDecTaskFlag flags)
         dec_vproc_signal(dec->vproc);
     } else {
         // direct output -> copy a new MppFrame and output
-        mpp_list *list = mpp->mFrames;
+        MppPtrQueue *list = mpp->mFrames;
         MppFrame out = NULL;
 
         mpp_frame_init(&out);
@@ -398,7 +404,7 @@ static void mpp_dec_put_frame(Mpp *mpp, RK_S32 index, HalDecTaskFlag flags)
             mpp_log("output frame pts %lld\n", mpp_frame_get_pts(out));
 
         list->lock();
-        list->add_at_tail(&out, sizeof(out));
+        list->push(out);
         mpp->mFramePutCount++;
         list->signal();
         list->unlock();
@@ -482,6 +488,37 @@ static void reset_hal_thread(Mpp *mpp)
     dec->thread_hal->unlock(THREAD_OUTPUT);
 }
 
+/*
+ * Get packet slot and its hardware buffer before parser prepare.
+ * Then parser can assemble the stream into the hardware buffer directly.
+ * When there is no slot or buffer available parser will fallback to copy mode.
+ */
+static void dec_get_pkt_buf(Mpp *mpp, DecTask *task)
+{
+    MppDecImpl *dec = (MppDecImpl *)mpp->mDec;
+    MppBufSlots packet_slots = dec->packet_slots;
+    HalDecTask *task_dec = &task->info.dec;
+    MppBuffer buf = NULL;
+
+    if (task_dec->input < 0) {
+        if (mpp_slots_get_unused_count(packet_slots) <= 0)
+            return ;
+
+        mpp_buf_slot_get_unused(packet_slots, &task_dec->input);
+        if (task_dec->input < 0)
+            return ;
+    }
+
+    mpp_buf_slot_get_prop(packet_slots, task_dec->input, SLOT_BUFFER, &buf);
+    if (NULL == buf) {
+        mpp_buffer_get(mpp->mPacketGroup, &buf, dec->pkt_buf_size);
+        if (buf) {
+            mpp_buf_slot_set_prop(packet_slots, task_dec->input, SLOT_BUFFER, buf);
+            mpp_buffer_put(buf);
+        }
+    }
+}
+
 static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
 {
     MppDecImpl *dec = (MppDecImpl *)mpp->mDec;
@@ -511,7 +548,7 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
      * 2. get packet for parser preparing
      */
     if (!dec->mpp_pkt_in && !task->status.curr_task_rdy) {
-        mpp_list *packets = mpp->mPackets;
+        MppPtrQueue *packets = mpp->mPackets;
         AutoMutex autolock(packets->mutex());
 
         if (!packets->list_size()) {
@@ -520,20 +557,20 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
         }
 
         task->wait.dec_pkt_in = 0;
-        packets->del_at_head(&dec->mpp_pkt_in, sizeof(dec->mpp_pkt_in));
+        packets->pop(&dec->mpp_pkt_in);
         mpp->mPacketGetCount++;
         dec->dec_in_pkt_count++;
 
         if (dec->use_preset_time_order) {
             MppPacket pkt_in = NULL;
-            mpp_list *ts = mpp->mTimeStamps;
+            MppPtrQueue *ts = mpp->mTimeStamps;
 
             AutoMutex autoLock(ts->mutex());
             mpp_packet_new(&pkt_in);
             if (pkt_in) {
                 mpp_packet_set_pts(pkt_in, mpp_packet_get_pts(dec->mpp_pkt_in));
                 mpp_packet_set_dts(pkt_in, mpp_packet_get_dts(dec->mpp_pkt_in));
-                ts->add_at_tail(&pkt_in, sizeof(pkt_in));
+                ts->push(pkt_in);
             }
         }
     }
@@ -568,6 +605,9 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
             mpp_log("input packet pts %lld\n",
                     mpp_packet_get_pts(dec->mpp_pkt_in));
 
+        if (dec->parser_direct_pkt_buf)
+            dec_get_pkt_buf(mpp, task);
+
         mpp_clock_start(dec->clocks[DEC_PRS_PREPARE]);
         mpp_parser_prepare(dec->parser, dec->mpp_pkt_in, task_dec);
         mpp_clock_pause(dec->clocks[DEC_PRS_PREPARE]);
@@ -611,17 +651,24 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
     stream_size = mpp_packet_get_size(task_dec->input_packet);
 
     mpp_buf_slot_get_prop(packet_slots, task->hal_pkt_idx_in, SLOT_BUFFER, &hal_buf_in);
+    /*
+     * parser falls back to its internal packet when the stream does not fit
+     * the slot buffer got before prepare, replace it with a larger one
+     */
+    if (hal_buf_in && mpp_buffer_get_size(hal_buf_in) < stream_size)
+        hal_buf_in = NULL;
+
     if (NULL == hal_buf_in) {
         mpp_buffer_get(mpp->mPacketGroup, &hal_buf_in, stream_size);
         if (hal_buf_in) {
             mpp_buf_slot_set_prop(packet_slots, task->hal_pkt_idx_in, SLOT_BUFFER, hal_buf_in);
             mpp_buffer_put(hal_buf_in);
         }
-    } else {
-        MppBufferImpl *buf = (MppBufferImpl *)hal_buf_in;
-        mpp_assert(buf->info.size >= stream_size);
     }
 
+    if (stream_size > dec->pkt_buf_size)
+        dec->pkt_buf_size = stream_size;
+
     task->hal_pkt_buf_in = hal_buf_in;
     task->wait.dec_pkt_buf = (NULL == hal_buf_in);
     if (task->wait.dec_pkt_buf)
@@ -635,28 +682,35 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
         void *src = mpp_packet_get_data(task_dec->input_packet);
         size_t length = mpp_packet_get_length(task_dec->input_packet);
 
-        memcpy(dst, src, length);
+        /* parser may have assembled the stream in hardware buffer already */
+        if (dst != src)
+            memcpy(dst, src, length);
         mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_CODEC_READY);
         mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_HAL_INPUT);
         task->status.dec_pkt_copy_rdy = 1;
     }
 
-    /* 7.1 if not fast mode wait previous task done here */
-    if (!dec->parser_fast_mode) {
-        // wait previous task done
-        if (!task->status.prev_task_rdy) {
-            HalTaskHnd task_prev = NULL;
-            hal_task_get_hnd(tasks, TASK_PROC_DONE, &task_prev);
-            if (task_prev) {
-                task->status.prev_task_rdy  = 1;
-                task->wait.prev_task = 0;
-                hal_task_hnd_set_status(task_prev, TASK_IDLE);
-                task_prev = NULL;
-            } else {
-                task->wait.prev_task = 1;
-                return MPP_NOK;
-            }
+    /*
+     * 7.1 wait until less than pipeline depth tasks are on hardware
+     * The references of the next frame are on hardware already and hardware
+     * runs tasks in submit order. Depth 1 waits previous task done here.
+     */
+    if (!task->status.prev_task_rdy) {
+        HalTaskHnd task_prev = NULL;
+        RK_U32 count = 0;
+
+        // non-fast mode hal thread leaves the done task to parser
+        while (MPP_OK == hal_task_get_hnd(tasks, TASK_PROC_DONE, &task_prev)) {
+            hal_task_hnd_set_status(task_prev, TASK_IDLE);
+            task_prev = NULL;
         }
+
+        hal_task_get_count(tasks, TASK_PROCESSING, &count);
+        task->wait.prev_task = (count >= dec->pipeline_depth);
+        if (task->wait.prev_task)
+            return MPP_NOK;
+
+        task->status.prev_task_rdy = 1;
     }
 
     // for vp9 only wait all task is processed
@@ -1004,10 +1058,7 @@ void *mpp_dec_hal_thread(void *data)
             hal_task_hnd_set_status(task, (dec->parser_fast_mode) ?
                                     (TASK_IDLE) : (TASK_PROC_DONE));
 
-            if (dec->parser_fast_mode)
-                notify_flag |= MPP_DEC_NOTIFY_TASK_HND_VALID;
-            else
-                notify_flag |= MPP_DEC_NOTIFY_TASK_PREV_DONE;
+            notify_flag |= MPP_DEC_NOTIFY_TASK_PREV_DONE;
 
             task = NULL;
 
@@ -1254,6 +1305,31 @@ static const char *timing_str[DEC_TIMING_BUTT] = {
     "hw wait   ",
 };
 
+static RK_U32 mpp_dec_check_pipeline(MppCodingType coding, RK_U32 depth)
+{
+    if (depth > MPP_DEC_MAX_PIPELINE_DEPTH) {
+        mpp_log("pipeline depth %d is clipped to %d\n", depth,
+                MPP_DEC_MAX_PIPELINE_DEPTH);
+        depth = MPP_DEC_MAX_PIPELINE_DEPTH;
+    }
+
+    switch (coding) {
+    case MPP_VIDEO_CodingAVC :
+    case MPP_VIDEO_CodingHEVC :
+    case MPP_VIDEO_CodingVP9 : {
+    } break;
+    default : {
+        if (depth > 1) {
+            mpp_log("coding %x does not support pipeline depth %d\n",
+                    coding, depth);
+            depth = 1;
+        }
+    } break;
+    }
+
+    return depth;
+}
+
 MPP_RET mpp_dec_init(MppDec *dec, MppDecCfg *cfg)
 {
     RK_S32 i;
@@ -1264,6 +1340,9 @@ MPP_RET mpp_dec_init(MppDec *dec, MppDecCfg *cfg)
     Parser parser = NULL;
     MppHal hal = NULL;
     RK_S32 hal_task_count = 0;
+    RK_U32 fast_mode = 0;
+    RK_U32 pipeline_depth = 0;
+    RK_U32 display_delay = 0;
     MppDecImpl *p = NULL;
     IOInterruptCB cb = {NULL, NULL};
 
@@ -1284,7 +1363,28 @@ MPP_RET mpp_dec_init(MppDec *dec, MppDecCfg *cfg)
     }
 
     coding = cfg->coding;
-    hal_task_count = (cfg->fast_mode) ? (3) : (2);
+    fast_mode = cfg->fast_mode;
+    pipeline_depth = cfg->pipeline_depth;
+    mpp_env_get_u32("mpp_dec_pipeline_depth", &pipeline_depth, pipeline_depth);
+    if (!pipeline_depth)
+        pipeline_depth = (fast_mode) ? (2) : (1);
+
+    /*
+     * Each task on hardware needs its own register set which only the fast
+     * mode hal has. One more task is kept for the parser to prepare.
+     */
+    pipeline_depth = mpp_dec_check_pipeline(coding, pipeline_depth);
+    if (pipeline_depth > 1)
+        fast_mode = 1;
+    hal_task_count = pipeline_depth + 1;
+
+    display_delay = cfg->display_delay;
+    mpp_env_get_u32("mpp_dec_display_delay", &display_delay, display_delay);
+    if (display_delay > MPP_DEC_MAX_DISPLAY_DELAY) {
+        mpp_log("display delay %d is clipped to %d\n", display_delay,
+                MPP_DEC_MAX_DISPLAY_DELAY);
+        display_delay = MPP_DEC_MAX_DISPLAY_DELAY;
+    }
 
     do {
         ret = mpp_buf_slot_init(&frame_slots);
@@ -1308,6 +1408,7 @@ MPP_RET mpp_dec_init(MppDec *dec, MppDecCfg *cfg)
             cfg->need_split,
             cfg->immedaite_out,
             cfg->internal_pts,
+            display_delay,
         };
 
         ret = mpp_parser_init(&parser, &parser_cfg);
@@ -1327,7 +1428,7 @@ MPP_RET mpp_dec_init(MppDec *dec, MppDecCfg *cfg)
             NULL,
             NULL,
             parser_cfg.task_count,
-            cfg->fast_mode,
+            fast_mode,
             cb,
         };
 
@@ -1346,8 +1447,13 @@ MPP_RET mpp_dec_init(MppDec *dec, MppDecCfg *cfg)
 
         p->mpp                  = cfg->mpp;
         p->parser_need_split    = cfg->need_split;
-        p->parser_fast_mode     = cfg->fast_mode;
+        p->parser_fast_mode     = fast_mode;
+        p->pipeline_depth       = MPP_MIN(pipeline_depth,
+                                          (RK_U32)parser_cfg.task_count - 1);
         p->parser_internal_pts  = cfg->internal_pts;
+        p->parser_direct_pkt_buf = (mpp_parser_get_flag(parser) &
+                                    PARSER_FLAG_DIRECT_PKT_BUF) ? 1 : 0;
+        p->pkt_buf_size         = SZ_512K;
         p->enable_deinterlace   = 1;
 
         p->statistics_en        = (mpp_dec_debug & MPP_DEC_DBG_TIMING) ? 1 : 0;
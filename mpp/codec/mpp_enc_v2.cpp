@@ -38,6 +38,7 @@
 #include "mpp_device.h"
 
 #include "rc.h"
+#include "rc_history.h"
 #include "hal_info.h"
 
 RK_U32 mpp_enc_debug = 0;
@@ -59,6 +60,74 @@ typedef struct RcApiStatus_t {
     RK_U32              rc_api_user_cfg : 1;
 } RcApiStatus;
 
+typedef union EncTaskWait_u {
+    RK_U32          val;
+    struct {
+        RK_U32      enc_frm_in      : 1;   // 0x0001 MPP_ENC_NOTIFY_FRAME_ENQUEUE
+        RK_U32      reserv0002      : 1;   // 0x0002
+        RK_U32      reserv0004      : 1;   // 0x0004
+        RK_U32      enc_pkt_out     : 1;   // 0x0008 MPP_ENC_NOTIFY_PACKET_ENQUEUE
+
+        RK_U32      reserv0010      : 1;   // 0x0010
+        RK_U32      reserv0020      : 1;   // 0x0020
+        RK_U32      reserv0040      : 1;   // 0x0040
+        RK_U32      reserv0080      : 1;   // 0x0080
+
+        RK_U32      reserv0100      : 1;   // 0x0100
+        RK_U32      reserv0200      : 1;   // 0x0200
+        RK_U32      reserv0400      : 1;   // 0x0400
+        RK_U32      reserv0800      : 1;   // 0x0800
+
+        RK_U32      reserv1000      : 1;   // 0x1000
+        RK_U32      reserv2000      : 1;   // 0x2000
+        RK_U32      reserv4000      : 1;   // 0x4000
+        RK_U32      reserv8000      : 1;   // 0x8000
+    };
+} EncTaskWait;
+
+/* encoder internal work flow */
+typedef union EncTaskStatus_u {
+    RK_U32          val;
+    struct {
+        RK_U32      task_in_rdy         : 1;
+        RK_U32      task_out_rdy        : 1;
+
+        RK_U32      rc_check_frm_drop   : 1;    // rc  stage
+        RK_U32      enc_backup          : 1;    // enc stage
+        RK_U32      enc_restore         : 1;    // reenc flow start point
+        RK_U32      enc_proc_dpb        : 1;    // enc stage
+        RK_U32      rc_frm_start        : 1;    // rc  stage
+        RK_U32      check_type_reenc    : 1;    // flow checkpoint if reenc -> enc_restore
+        RK_U32      enc_proc_hal        : 1;    // enc stage
+        RK_U32      hal_get_task        : 1;    // hal stage
+        RK_U32      rc_hal_start        : 1;    // rc  stage
+        RK_U32      hal_gen_reg         : 1;    // hal stage
+        RK_U32      hal_start           : 1;    // hal stage
+        RK_U32      hal_wait            : 1;    // hal stage NOTE: special in low delay mode
+        RK_U32      rc_hal_end          : 1;    // rc  stage
+        RK_U32      hal_ret_task        : 1;    // hal stage
+        RK_U32      enc_update_hal      : 1;    // enc stage
+        RK_U32      rc_frm_end          : 1;    // rc  stage
+        RK_U32      check_rc_reenc      : 1;    // flow checkpoint if reenc -> enc_restore
+    };
+} EncTaskStatus;
+
+typedef struct EncTask_t {
+    RK_S32          seq_idx;
+    EncTaskStatus   status;
+    EncTaskWait     wait;
+    EncFrmStatus    frm;
+    HalTaskInfo     info;
+} EncTask;
+
+typedef struct EncPipeTask_t {
+    RK_U32          valid;
+    EncTask         task;
+    EncRcTask       rc_task;
+    MppTask         task_in;
+    MppTask         task_out;
+} EncPipeTask;
+
 typedef struct MppEncImpl_t {
     MppCodingType       coding;
     EncImpl             impl;
@@ -81,6 +150,13 @@ typedef struct MppEncImpl_t {
     RcApiBrief          rc_brief;
     RcCtx               rc_ctx;
     EncRcTask           rc_task;
+    RcHistory           history;
+
+    /* two stage pipeline: frame started on hardware but not collected */
+    RK_U32              pipeline_depth;
+    EncPipeTask         pipe_task;
+    /* low delay output: spare output tasks for partition packets */
+    RK_U32              partition_task_cnt;
 
     MppThread           *thread_enc;
     void                *mpp;
@@ -128,66 +204,6 @@ typedef struct MppEncImpl_t {
     MppEncCfgSet        cfg;
 } MppEncImpl;
 
-typedef union EncTaskWait_u {
-    RK_U32          val;
-    struct {
-        RK_U32      enc_frm_in      : 1;   // 0x0001 MPP_ENC_NOTIFY_FRAME_ENQUEUE
-        RK_U32      reserv0002      : 1;   // 0x0002
-        RK_U32      reserv0004      : 1;   // 0x0004
-        RK_U32      enc_pkt_out     : 1;   // 0x0008 MPP_ENC_NOTIFY_PACKET_ENQUEUE
-
-        RK_U32      reserv0010      : 1;   // 0x0010
-        RK_U32      reserv0020      : 1;   // 0x0020
-        RK_U32      reserv0040      : 1;   // 0x0040
-        RK_U32      reserv0080      : 1;   // 0x0080
-
-        RK_U32      reserv0100      : 1;   // 0x0100
-        RK_U32      reserv0200      : 1;   // 0x0200
-        RK_U32      reserv0400      : 1;   // 0x0400
-        RK_U32      reserv0800      : 1;   // 0x0800
-
-        RK_U32      reserv1000      : 1;   // 0x1000
-        RK_U32      reserv2000      : 1;   // 0x2000
-        RK_U32      reserv4000      : 1;   // 0x4000
-        RK_U32      reserv8000      : 1;   // 0x8000
-    };
-} EncTaskWait;
-
-/* encoder internal work flow */
-typedef union EncTaskStatus_u {
-    RK_U32          val;
-    struct {
-        RK_U32      task_in_rdy         : 1;
-        RK_U32      task_out_rdy        : 1;
-
-        RK_U32      rc_check_frm_drop   : 1;    // rc  stage
-        RK_U32      enc_backup          : 1;    // enc stage
-        RK_U32      enc_restore         : 1;    // reenc flow start point
-        RK_U32      enc_proc_dpb        : 1;    // enc stage
-        RK_U32      rc_frm_start        : 1;    // rc  stage
-        RK_U32      check_type_reenc    : 1;    // flow checkpoint if reenc -> enc_restore
-        RK_U32      enc_proc_hal        : 1;    // enc stage
-        RK_U32      hal_get_task        : 1;    // hal stage
-        RK_U32      rc_hal_start        : 1;    // rc  stage
-        RK_U32      hal_gen_reg         : 1;    // hal stage
-        RK_U32      hal_start           : 1;    // hal stage
-        RK_U32      hal_wait            : 1;    // hal stage NOTE: special in low delay mode
-        RK_U32      rc_hal_end          : 1;    // rc  stage
-        RK_U32      hal_ret_task        : 1;    // hal stage
-        RK_U32      enc_update_hal      : 1;    // enc stage
-        RK_U32      rc_frm_end          : 1;    // rc  stage
-        RK_U32      check_rc_reenc      : 1;    // flow checkpoint if reenc -> enc_restore
-    };
-} EncTaskStatus;
-
-typedef struct EncTask_t {
-    RK_S32          seq_idx;
-    EncTaskStatus   status;
-    EncTaskWait     wait;
-    EncFrmStatus    frm;
-    HalTaskInfo     info;
-} EncTask;
-
 static RK_U8 uuid_version[16] = {
     0x3d, 0x07, 0x6d, 0x45, 0x73, 0x0f, 0x41, 0xa8,
     0xb1, 0xc4, 0x25, 0xd7, 0x97, 0x6b, 0xf1, 0xac,
@@ -589,6 +605,12 @@ MPP_RET mpp_enc_proc_cfg(MppEncImpl *enc, MpiCmd cmd, void *param)
             ret = MPP_NOK;
         }
     } break;
+    case MPP_ENC_SET_SCHED_CFG : {
+        MppEncSchedCfg *src = (MppEncSchedCfg *)param;
+
+        enc_dbg_ctrl("sched period %d weight %d\n", src->period, src->weight);
+        ret = mpp_enc_hal_sched_set(enc->enc_hal, src);
+    } break;
     case MPP_ENC_SET_SEI_CFG : {
         if (param) {
             MppEncSeiMode mode = *((MppEncSeiMode *)param);
@@ -630,6 +652,22 @@ MPP_RET mpp_enc_proc_cfg(MppEncImpl *enc, MpiCmd cmd, void *param)
         if (mpp_enc_refs_update_hdr(enc->refs))
             enc->hdr_status.val = 0;
     } break;
+    case MPP_ENC_SET_CFG : {
+        MppEncCfgImpl *impl = (MppEncCfgImpl *)param;
+        MppEncSplitOutCfg *src = &impl->cfg.split_out;
+
+        if (src->change & MPP_ENC_SPLIT_OUT_CFG_CHANGE_MODE) {
+            if ((src->out_mode & MPP_ENC_SPLIT_OUT_LOWDELAY) &&
+                !enc->partition_task_cnt)
+                mpp_log("low delay output without spare task, set split:out before init\n");
+
+            enc->cfg.split_out.out_mode = src->out_mode;
+            enc_dbg_ctrl("split out mode %x\n", src->out_mode);
+        }
+        src->change = 0;
+
+        ret = enc_impl_proc_cfg(enc->impl, cmd, param);
+    } break;
     case MPP_ENC_SET_OSD_PLT_CFG : {
         MppEncOSDPltCfg *src = (MppEncOSDPltCfg *)param;
         MppEncOSDPltCfg *dst = &enc->cfg.plt_cfg;
@@ -664,6 +702,20 @@ MPP_RET mpp_enc_proc_cfg(MppEncImpl *enc, MpiCmd cmd, void *param)
     } break;
     }
 
+    /* the rest of the config is kept, reencode is just turned off */
+    if (enc->pipeline_depth > 1 && enc->cfg.rc.max_reenc_times) {
+        mpp_log("reencode %d times is disabled in pipeline mode\n",
+                enc->cfg.rc.max_reenc_times);
+        enc->cfg.rc.max_reenc_times = 0;
+    }
+    /* partitions already returned can not be encoded again */
+    if ((enc->cfg.split_out.out_mode & MPP_ENC_SPLIT_OUT_LOWDELAY) &&
+        enc->cfg.rc.max_reenc_times) {
+        mpp_log("reencode %d times is disabled in low delay output\n",
+                enc->cfg.rc.max_reenc_times);
+        enc->cfg.rc.max_reenc_times = 0;
+    }
+
     if (check_resend_hdr(cmd, param, &enc->cfg)) {
         enc->frm_cfg.force_flag |= ENC_FORCE_IDR;
         enc->hdr_status.val = 0;
@@ -878,16 +930,17 @@ static void set_rc_cfg(RcCfg *cfg, MppEncCfgSet *cfg_set)
     }
 }
 
-static MPP_RET mpp_enc_normal(Mpp *mpp, EncTask *task)
+/* software part of one frame from dpb to register generation */
+static MPP_RET mpp_enc_normal_prepare(Mpp *mpp, EncTask *task)
 {
     MppEncImpl *enc = (MppEncImpl *)mpp->mEnc;
     EncImpl impl = enc->impl;
     MppEncHal hal = enc->enc_hal;
-    EncRcTask *rc_task = &enc->rc_task;
+    HalEncTask *hal_task = &task->info.enc;
+    EncRcTask *rc_task = hal_task->rc_task;
     MppEncHeaderStatus *hdr_status = &enc->hdr_status;
     EncCpbStatus *cpb = &rc_task->cpb;
     EncFrmStatus *frm = &rc_task->frm;
-    HalEncTask *hal_task = &task->info.enc;
     MppFrame frame = hal_task->frame;
     MppPacket packet = hal_task->packet;
     MPP_RET ret = MPP_OK;
@@ -908,6 +961,9 @@ static MPP_RET mpp_enc_normal(Mpp *mpp, EncTask *task)
     enc_dbg_frm_status("temporal_id  %d vs %d\n", frm->temporal_id, cpb->curr.temporal_id);
     enc_dbg_frm_status("frm %d done  ***********************************\n", cpb->curr.seq_idx);
 
+    if (enc->history)
+        rc_history_proc(enc->history, frame, &rc_task->info);
+
     enc_dbg_detail("task %d rc frame start\n", frm->seq_idx);
     ENC_RUN_FUNC2(rc_frm_start, enc->rc_ctx, rc_task, mpp, ret);
 
@@ -973,8 +1029,19 @@ static MPP_RET mpp_enc_normal(Mpp *mpp, EncTask *task)
     enc_dbg_detail("task %d hal generate reg\n", frm->seq_idx);
     ENC_RUN_FUNC2(mpp_enc_hal_gen_regs, hal, hal_task, mpp, ret);
 
-    enc_dbg_detail("task %d hal start\n", frm->seq_idx);
-    ENC_RUN_FUNC2(mpp_enc_hal_start, hal, hal_task, mpp, ret);
+TASK_DONE:
+    return ret;
+}
+
+/* wait hardware and collect the result of a started frame */
+static MPP_RET mpp_enc_normal_wait(Mpp *mpp, EncTask *task)
+{
+    MppEncImpl *enc = (MppEncImpl *)mpp->mEnc;
+    MppEncHal hal = enc->enc_hal;
+    HalEncTask *hal_task = &task->info.enc;
+    EncRcTask *rc_task = hal_task->rc_task;
+    EncFrmStatus *frm = &rc_task->frm;
+    MPP_RET ret = MPP_OK;
 
     enc_dbg_detail("task %d hal wait\n", frm->seq_idx);
     ENC_RUN_FUNC2(mpp_enc_hal_wait,  hal, hal_task, mpp, ret);
@@ -985,6 +1052,24 @@ static MPP_RET mpp_enc_normal(Mpp *mpp, EncTask *task)
     enc_dbg_detail("task %d hal ret task\n", frm->seq_idx);
     ENC_RUN_FUNC2(mpp_enc_hal_ret_task, hal, hal_task, mpp, ret);
 
+TASK_DONE:
+    return ret;
+}
+
+static MPP_RET mpp_enc_normal(Mpp *mpp, EncTask *task)
+{
+    MppEncImpl *enc = (MppEncImpl *)mpp->mEnc;
+    EncRcTask *rc_task = task->info.enc.rc_task;
+    EncFrmStatus *frm = &rc_task->frm;
+    MPP_RET ret = MPP_OK;
+
+    ENC_RUN_FUNC2(mpp_enc_normal_prepare, mpp, task, mpp, ret);
+
+    enc_dbg_detail("task %d hal start\n", frm->seq_idx);
+    ENC_RUN_FUNC2(mpp_enc_hal_start, enc->enc_hal, &task->info.enc, mpp, ret);
+
+    ENC_RUN_FUNC2(mpp_enc_normal_wait, mpp, task, mpp, ret);
+
     enc_dbg_detail("task %d rc frame check reenc\n", frm->seq_idx);
     ENC_RUN_FUNC2(rc_frm_check_reenc, enc->rc_ctx, rc_task, mpp, ret);
 
@@ -1098,6 +1183,188 @@ TASK_DONE:
     return ret;
 }
 
+static void update_enc_frame_count(MppEncImpl *enc)
+{
+    enc->time_end = mpp_time();
+    enc->frame_count++;
+
+    if (enc->dev && enc->time_base && enc->time_end &&
+        ((enc->time_end - enc->time_base) >= (RK_S64)(1000 * 1000)))
+        update_hal_info_fps(enc);
+}
+
+/*
+ * Low delay output
+ *
+ * Called by hal wait on each slice done on hardware. The stream done so far
+ * is returned in a partition packet on a spare output task. When there is no
+ * idle output task it goes with the next slice. The rest of the frame goes
+ * out with the frame's own output task and eoi flag.
+ */
+static void mpp_enc_slice_out(void *ctx, HalEncTask *task, RK_U32 length)
+{
+    Mpp *mpp = (Mpp *)ctx;
+    MppPort output = mpp_task_queue_get_port(mpp->mOutputTaskQueue, MPP_PORT_INPUT);
+    MppPacket packet = NULL;
+    MppTask task_out = NULL;
+    RK_U8 *base = (RK_U8 *)mpp_packet_get_pos(task->packet);
+    RK_U32 end;
+
+    task->slice_length += length;
+    end = task->length + task->slice_length;
+
+    if (end <= task->out_length || mpp_port_poll(output, MPP_POLL_NON_BLOCK))
+        return;
+
+    if (mpp_port_dequeue(output, &task_out) || NULL == task_out)
+        return;
+
+    mpp_packet_init_with_buffer(&packet, task->output);
+    mpp_packet_set_pos(packet, base + task->out_length);
+    mpp_packet_set_length(packet, end - task->out_length);
+    mpp_packet_set_pts(packet, mpp_packet_get_pts(task->packet));
+    mpp_packet_set_dts(packet, mpp_packet_get_dts(task->packet));
+    mpp_packet_set_flag(packet, mpp_packet_get_flag(packet) |
+                        MPP_PACKET_FLAG_PARTITION);
+
+    enc_dbg_detail("partition out %d - %d\n", task->out_length, end);
+    task->out_length = end;
+
+    mpp_task_meta_set_packet(task_out, KEY_OUTPUT_PACKET, packet);
+    mpp_port_enqueue(output, task_out);
+}
+
+static void setup_output_packet(MppPacket packet, HalEncTask *hal_task,
+                                EncFrmStatus *frm, RK_U32 low_delay)
+{
+    MppMeta meta = mpp_packet_get_meta(packet);
+    RK_U32 offset = hal_task->header_length + hal_task->sei_length;
+    RK_U32 out_length = MPP_MIN(hal_task->out_length, hal_task->length);
+
+    mpp_packet_set_length(packet, hal_task->length);
+
+    /* header and sei are written before hardware stream */
+    mpp_packet_reset_segment(packet);
+    if (offset <= hal_task->length) {
+        mpp_packet_add_segment(packet, MPP_PKT_SEG_HEADER, 0,
+                               hal_task->header_length);
+        mpp_packet_add_segment(packet, MPP_PKT_SEG_SEI, hal_task->header_length,
+                               hal_task->sei_length);
+        mpp_packet_add_segment(packet, MPP_PKT_SEG_STREAM, offset,
+                               hal_task->length - offset);
+    }
+
+    /* the rest of the frame after returned partitions */
+    if (low_delay) {
+        if (out_length) {
+            mpp_packet_reset_segment(packet);
+            mpp_packet_set_pos(packet, (RK_U8 *)mpp_packet_get_pos(packet) + out_length);
+            mpp_packet_set_length(packet, hal_task->length - out_length);
+        }
+        mpp_packet_set_flag(packet, mpp_packet_get_flag(packet) |
+                            MPP_PACKET_FLAG_PARTITION | MPP_PACKET_FLAG_EOI);
+    }
+
+    if (hal_task->mv_info)
+        mpp_meta_set_buffer(meta, KEY_MOTION_INFO, hal_task->mv_info);
+
+    mpp_meta_set_s32(meta, KEY_OUTPUT_INTRA, frm->is_intra);
+    mpp_meta_set_s32(meta, KEY_OUTPUT_REENC, frm->reencode_times);
+}
+
+/*
+ * First return output packet.
+ * Then enqueue task back to input port.
+ * Final user will release the mpp_frame they had input.
+ */
+static void return_enc_task(MppPort input, MppPort output, MppTask task_in,
+                            MppTask task_out, MppFrame frame, MppPacket packet,
+                            RK_S32 seq_idx)
+{
+    if (NULL == packet)
+        mpp_packet_new(&packet);
+
+    if (frame && mpp_frame_get_eos(frame))
+        mpp_packet_set_eos(packet);
+    else
+        mpp_packet_clr_eos(packet);
+
+    enc_dbg_detail("task %d enqueue packet pts %lld\n", seq_idx, mpp_packet_get_pts(packet));
+
+    mpp_task_meta_set_packet(task_out, KEY_OUTPUT_PACKET, packet);
+    mpp_port_enqueue(output, task_out);
+
+    enc_dbg_detail("task %d enqueue frame pts %lld\n", seq_idx, mpp_frame_get_pts(frame));
+
+    mpp_task_meta_set_frame(task_in, KEY_INPUT_FRAME, frame);
+    mpp_port_enqueue(input, task_in);
+}
+
+/*
+ * Two stage pipeline
+ *
+ * When pipeline_depth is 2 a frame started on hardware is parked in pipe_task.
+ * The thread dequeues the next frame and runs its software part: dpb, rate
+ * control start, header, hal task and register generation. Then the parked
+ * frame is waited, its rc_frm_end done and its packet returned. At last the
+ * next frame is started on hardware and parked. So the cpu work of frame
+ * N + 1 overlaps the hardware run of frame N while only one frame is on the
+ * device.
+ *
+ * Rate control of frame N + 1 starts before rc_frm_end of frame N. The rc
+ * model gets the result of frame N one frame later and keeps the per frame
+ * state it needs at rc end in the rc task. The hal must not touch the state
+ * of a started frame when generating registers for the next one, which is
+ * reported by MppEncHalCfg.pipeline on hal init.
+ *
+ * Reencode needs the hardware result before the next frame starts, so it is
+ * turned off in pipeline mode. User control, reset and thread stop collect the
+ * parked frame first.
+ */
+static void mpp_enc_pipe_stash(MppEncImpl *enc, EncTask *task,
+                               MppTask task_in, MppTask task_out)
+{
+    EncPipeTask *pipe = &enc->pipe_task;
+
+    mpp_assert(!pipe->valid);
+
+    pipe->task = *task;
+    pipe->rc_task = *task->info.enc.rc_task;
+    pipe->task.info.enc.rc_task = &pipe->rc_task;
+    pipe->task_in = task_in;
+    pipe->task_out = task_out;
+    pipe->valid = 1;
+}
+
+static void mpp_enc_pipe_finish(Mpp *mpp, MppPort input, MppPort output)
+{
+    MppEncImpl *enc = (MppEncImpl *)mpp->mEnc;
+    EncPipeTask *pipe = &enc->pipe_task;
+    EncTask *task = &pipe->task;
+    HalEncTask *hal_task = &task->info.enc;
+    EncRcTask *rc_task = &pipe->rc_task;
+    EncFrmStatus *frm = &rc_task->frm;
+    MPP_RET ret = MPP_OK;
+
+    if (!pipe->valid)
+        return;
+
+    ENC_RUN_FUNC2(mpp_enc_normal_wait, mpp, task, mpp, ret);
+
+    enc_dbg_detail("task %d rc frame end\n", frm->seq_idx);
+    ENC_RUN_FUNC2(rc_frm_end, enc->rc_ctx, rc_task, mpp, ret);
+
+    update_enc_frame_count(enc);
+
+TASK_DONE:
+    setup_output_packet(hal_task->packet, hal_task, frm,
+                        hal_task->slice_out_ctx != NULL);
+    return_enc_task(input, output, pipe->task_in, pipe->task_out,
+                    hal_task->frame, hal_task->packet, frm->seq_idx);
+
+    pipe->valid = 0;
+}
+
 void *mpp_enc_thread(void *data)
 {
     Mpp *mpp = (Mpp*)data;
@@ -1127,6 +1394,12 @@ void *mpp_enc_thread(void *data)
     enc->time_base = mpp_time();
 
     while (1) {
+        // 0. do not hold parked frame while waiting for next frame
+        if (enc->pipe_task.valid &&
+            (mpp_port_poll(input, MPP_POLL_NON_BLOCK) ||
+             mpp_port_poll(output, MPP_POLL_NON_BLOCK)))
+            mpp_enc_pipe_finish(mpp, input, output);
+
         {
             AutoMutex autolock(thd_enc->mutex());
             if (MPP_THREAD_RUNNING != thd_enc->get_status())
@@ -1140,6 +1413,7 @@ void *mpp_enc_thread(void *data)
         if (enc->cmd_send != enc->cmd_recv) {
             enc_dbg_detail("ctrl proc %d cmd %08x\n", enc->cmd_recv, enc->cmd);
             sem_wait(&enc->cmd_start);
+            mpp_enc_pipe_finish(mpp, input, output);
             ret = mpp_enc_proc_cfg(enc, enc->cmd, enc->param);
             if (ret)
                 *enc->cmd_ret = ret;
@@ -1156,6 +1430,7 @@ void *mpp_enc_thread(void *data)
         // 2. process reset
         if (enc->reset_flag) {
             enc_dbg_detail("thread reset start\n");
+            mpp_enc_pipe_finish(mpp, input, output);
             {
                 AutoMutex autolock(thd_enc->mutex());
                 enc->status_flag = 0;
@@ -1276,6 +1551,11 @@ void *mpp_enc_thread(void *data)
         reset_enc_rc_task(rc_task);
         hal_task->rc_task = rc_task;
         hal_task->frm_cfg = frm_cfg;
+        /* hal may turn slice_out off while ctx marks the low delay frame */
+        if (cfg->split_out.out_mode & MPP_ENC_SPLIT_OUT_LOWDELAY) {
+            hal_task->slice_out = mpp_enc_slice_out;
+            hal_task->slice_out_ctx = mpp;
+        }
         frm->seq_idx = task.seq_idx++;
         rc_task->frame = frame;
 
@@ -1369,6 +1649,20 @@ void *mpp_enc_thread(void *data)
         mpp_enc_refs_stash(enc->refs);
         task.status.enc_backup = 1;
 
+        if (enc->pipeline_depth > 1) {
+            ENC_RUN_FUNC2(mpp_enc_normal_prepare, mpp, &task, mpp, ret);
+
+            // collect previous frame before this frame goes to hardware
+            mpp_enc_pipe_finish(mpp, input, output);
+
+            enc_dbg_detail("task %d hal start\n", frm->seq_idx);
+            ENC_RUN_FUNC2(mpp_enc_hal_start, enc->enc_hal, hal_task, mpp, ret);
+            mpp_enc_pipe_stash(enc, &task, task_in, task_out);
+
+            frm_cfg->force_flag = 0;
+            goto TASK_NEXT;
+        }
+
         ENC_RUN_FUNC2(mpp_enc_normal, mpp, &task, mpp, ret);
 
         // reencode process
@@ -1377,6 +1671,7 @@ void *mpp_enc_thread(void *data)
             hal_task->hw_length = 0;
 
             enc_dbg_detail("task %d reenc %d times %d\n", frm->seq_idx, frm->reencode, frm->reencode_times);
+            frm->reencode_times++;
 
             if (frm->drop) {
                 mpp_enc_reenc_drop(mpp, &task);
@@ -1393,54 +1688,23 @@ void *mpp_enc_thread(void *data)
         enc_dbg_detail("task %d rc frame end\n", frm->seq_idx);
         ENC_RUN_FUNC2(rc_frm_end, enc->rc_ctx, rc_task, mpp, ret);
 
-        enc->time_end = mpp_time();
-        enc->frame_count++;
-
-        if (enc->dev && enc->time_base && enc->time_end &&
-            ((enc->time_end - enc->time_base) >= (RK_S64)(1000 * 1000)))
-            update_hal_info_fps(enc);
+        update_enc_frame_count(enc);
 
         frm->reencode = 0;
-        frm->reencode_times = 0;
         frm_cfg->force_flag = 0;
 
     TASK_DONE:
         /* setup output packet and meta data */
-        mpp_packet_set_length(packet, hal_task->length);
-
-        {
-            MppMeta meta = mpp_packet_get_meta(packet);
-
-            if (hal_task->mv_info)
-                mpp_meta_set_buffer(meta, KEY_MOTION_INFO, hal_task->mv_info);
-
-            mpp_meta_set_s32(meta, KEY_OUTPUT_INTRA, frm->is_intra);
-        }
+        setup_output_packet(packet, hal_task, frm,
+                            hal_task->slice_out_ctx != NULL);
 
     TASK_RETURN:
-        /*
-         * First return output packet.
-         * Then enqueue task back to input port.
-         * Final user will release the mpp_frame they had input.
-         */
-        if (NULL == packet)
-            mpp_packet_new(&packet);
-
-        if (frame && mpp_frame_get_eos(frame))
-            mpp_packet_set_eos(packet);
-        else
-            mpp_packet_clr_eos(packet);
-
-        enc_dbg_detail("task %d enqueue packet pts %lld\n", frm->seq_idx, mpp_packet_get_pts(packet));
-
-        mpp_task_meta_set_packet(task_out, KEY_OUTPUT_PACKET, packet);
-        mpp_port_enqueue(output, task_out);
-
-        enc_dbg_detail("task %d enqueue frame pts %lld\n", frm->seq_idx, mpp_frame_get_pts(frame));
-
-        mpp_task_meta_set_frame(task_in, KEY_INPUT_FRAME, frame);
-        mpp_port_enqueue(input, task_in);
+        /* the parked frame goes out first to keep output order */
+        mpp_enc_pipe_finish(mpp, input, output);
+        return_enc_task(input, output, task_in, task_out, frame, packet,
+                        frm->seq_idx);
 
+    TASK_NEXT:
         task_in = NULL;
         task_out = NULL;
         packet = NULL;
@@ -1451,6 +1715,8 @@ void *mpp_enc_thread(void *data)
         hdr_status->val = hdr_status->ready;
     }
 
+    mpp_enc_pipe_finish(mpp, input, output);
+
     // clear remain task in output port
     release_task_in_port(input);
     release_task_in_port(mpp->mOutputPort);
@@ -1467,8 +1733,10 @@ MPP_RET mpp_enc_init_v2(MppEnc *enc, MppEncInitCfg *cfg)
     MppEncHal enc_hal = NULL;
     MppEncHalCfg enc_hal_cfg;
     EncImplCfg ctrl_cfg;
+    RK_U32 history = 0;
 
     mpp_env_get_u32("mpp_enc_debug", &mpp_enc_debug, 0);
+    mpp_env_get_u32("mpp_enc_rc_history", &history, 0);
 
     if (NULL == enc) {
         mpp_err_f("failed to malloc context\n");
@@ -1495,6 +1763,7 @@ MPP_RET mpp_enc_init_v2(MppEnc *enc, MppEncInitCfg *cfg)
     enc_hal_cfg.cfg = &p->cfg;
     enc_hal_cfg.type = VPU_CLIENT_BUTT;
     enc_hal_cfg.dev = NULL;
+    enc_hal_cfg.pipeline = 0;
 
     ctrl_cfg.coding = coding;
     ctrl_cfg.type = VPU_CLIENT_BUTT;
@@ -1523,12 +1792,32 @@ MPP_RET mpp_enc_init_v2(MppEnc *enc, MppEncInitCfg *cfg)
         goto ERR_RET;
     }
 
+    /* optional cpu pre-pass comparing the frame with its history */
+    if (history && rc_history_init(&p->history, history))
+        mpp_err_f("could not init rc history, run without it\n");
+
     p->coding   = coding;
     p->impl     = impl;
     p->enc_hal  = enc_hal;
     p->dev      = enc_hal_cfg.dev;
     p->mpp      = cfg->mpp;
     p->sei_mode = MPP_ENC_SEI_MODE_ONE_SEQ;
+    p->pipeline_depth = cfg->pipeline_depth;
+    p->partition_task_cnt = cfg->partition_task_cnt;
+    if (p->pipeline_depth > MPP_ENC_MAX_PIPELINE_DEPTH) {
+        mpp_log("pipeline depth %d is clipped to %d\n", p->pipeline_depth,
+                MPP_ENC_MAX_PIPELINE_DEPTH);
+        p->pipeline_depth = MPP_ENC_MAX_PIPELINE_DEPTH;
+    }
+    if (p->pipeline_depth > 1 && !enc_hal_cfg.pipeline) {
+        mpp_err_f("hal of coding %x does not support pipeline depth %d\n",
+                  coding, p->pipeline_depth);
+        ret = MPP_NOK;
+        goto ERR_RET;
+    }
+    /* reencode is rejected in pipeline mode */
+    if (p->pipeline_depth > 1)
+        p->cfg.rc.max_reenc_times = 0;
     p->version_info = get_mpp_version();
     p->version_length = strlen(p->version_info);
     p->rc_cfg_size = SZ_1K;
@@ -1575,6 +1864,11 @@ MPP_RET mpp_enc_deinit_v2(MppEnc ctx)
         enc->hal_info = NULL;
     }
 
+    if (enc->history) {
+        rc_history_deinit(enc->history);
+        enc->history = NULL;
+    }
+
     if (enc->impl) {
         enc_impl_deinit(enc->impl);
         enc->impl = NULL;
@@ -1758,6 +2052,14 @@ MPP_RET mpp_enc_control_v2(MppEnc ctx, MpiCmd cmd, void *param)
         enc_dbg_ctrl("get osd plt cfg\n");
         memcpy(param, &enc->cfg.plt_cfg, sizeof(enc->cfg.plt_cfg));
     } break;
+    case MPP_ENC_GET_SCHED_CFG : {
+        enc_dbg_ctrl("get sched cfg\n");
+        ret = mpp_enc_hal_sched_get(enc->enc_hal, (MppEncSchedCfg *)param);
+    } break;
+    case MPP_ENC_GET_SCHED_STAT : {
+        enc_dbg_ctrl("get sched stat\n");
+        ret = mpp_enc_hal_sched_stat(enc->enc_hal, (MppEncSchedStat *)param);
+    } break;
     default : {
         // Cmd which is not get configure will handle by enc_impl
         enc->cmd = cmd;
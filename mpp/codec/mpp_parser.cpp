@@ -133,6 +133,17 @@ MPP_RET mpp_parser_deinit(Parser prs)
     return MPP_OK;
 }
 
+RK_U32 mpp_parser_get_flag(Parser prs)
+{
+    if (NULL == prs) {
+        mpp_err_f("found NULL input\n");
+        return 0;
+    }
+
+    ParserImpl *p = (ParserImpl *)prs;
+    return p->api->flag;
+}
+
 MPP_RET mpp_parser_prepare(Parser prs, MppPacket pkt, HalDecTask *task)
 {
     if (NULL == prs || NULL == pkt) {
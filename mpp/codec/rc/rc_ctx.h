@@ -19,6 +19,18 @@
 #include "mpp_rc_api.h"
 #include "rc_base.h"
 
+/*
+ * qp to frame bits model of one frame type: log2(bits) = a + b * qp
+ * Least square sums with exponential forgetting of older frames.
+ */
+typedef struct RcQpBitsModel_t {
+    float           sum_w;
+    float           sum_qp;
+    float           sum_log;
+    float           sum_qp2;
+    float           sum_qp_log;
+} RcQpBitsModel;
+
 typedef struct RcModelV2Ctx_t {
     RcCfg           usr_cfg;
     EncRcTaskInfo   hal_cfg;
@@ -90,6 +102,11 @@ typedef struct RcModelV2Ctx_t {
     RK_S32          prev_md_prop;
 
     RK_S32          reenc_cnt;
+    /* re-encode prediction model indexed by ENC_FRAME_TYPE and statistic */
+    RcQpBitsModel   qp_bits[4];
+    RK_U32          reenc_frm_cnt;
+    RK_U32          reenc_pass_cnt;
+    RK_U32          reenc_pred_cnt;
     RK_U32          drop_cnt;
     RK_S32          on_drop;
     RK_S32          on_pskip;
@@ -108,7 +125,7 @@ MPP_RET bits_model_init(RcModelV2Ctx *ctx);
 MPP_RET bits_model_deinit(RcModelV2Ctx *ctx);
 
 MPP_RET bits_model_alloc(RcModelV2Ctx *ctx, EncRcTaskInfo *cfg, RK_S64 total_bits);
-MPP_RET bits_model_update(RcModelV2Ctx *ctx, RK_S32 real_bit, RK_U32 madi);
+MPP_RET bits_model_update(RcModelV2Ctx *ctx, EncRcTaskInfo *cfg);
 
 MPP_RET calc_next_i_ratio(RcModelV2Ctx *ctx);
 MPP_RET check_re_enc(RcModelV2Ctx *ctx, EncRcTaskInfo *cfg);
@@ -0,0 +1,289 @@
+/*
+ * Copyright 2016 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "rc_history"
+
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+#include "mpp_buffer.h"
+
+#include "rc_debug.h"
+#include "rc_base.h"
+#include "rc_history.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define HIST_BLK_SIZE       8
+
+typedef struct RcHistoryImpl_t {
+    RK_S32          depth;
+    RK_S32          blk_w;
+    RK_S32          blk_h;
+    /* 8x8 block mean of current and previous frame */
+    RK_U8           *thumb[2];
+    /* row sum scratch of one block row */
+    RK_U16          *sum;
+    RK_S32          curr;
+    RK_S32          has_prev;
+    /* frame cost per block history in 1/16 */
+    MppDataV2       *cost;
+    RK_S32          cost_valid;
+} RcHistoryImpl;
+
+/* add sum of each 8 pixels in src to sum[] */
+static void hist_row_sum(const RK_U8 *src, RK_S32 blk_cnt, RK_U16 *sum)
+{
+    RK_S32 i = 0;
+
+#if defined(__SSE2__)
+    __m128i zero = _mm_setzero_si128();
+
+    for (; i + 2 <= blk_cnt; i += 2, src += 16) {
+        __m128i sad = _mm_sad_epu8(_mm_loadu_si128((const __m128i *)src), zero);
+
+        sum[i] += _mm_cvtsi128_si32(sad);
+        sum[i + 1] += _mm_extract_epi16(sad, 4);
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 2 <= blk_cnt; i += 2, src += 16) {
+        uint64x2_t s = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(vld1q_u8(src))));
+
+        sum[i] += (RK_U16)vgetq_lane_u64(s, 0);
+        sum[i + 1] += (RK_U16)vgetq_lane_u64(s, 1);
+    }
+#endif
+
+    for (; i < blk_cnt; i++, src += 8) {
+        RK_U64 v;
+
+        memcpy(&v, src, sizeof(v));
+        v = (v & 0x00ff00ff00ff00ffULL) + ((v >> 8) & 0x00ff00ff00ff00ffULL);
+        sum[i] += (RK_U16)((v * 0x0001000100010001ULL) >> 48);
+    }
+}
+
+/* sum of absolute difference of two byte arrays */
+static RK_U32 hist_sad(const RK_U8 *a, const RK_U8 *b, RK_S32 size)
+{
+    RK_U32 sad = 0;
+    RK_S32 i = 0;
+
+#if defined(__SSE2__)
+    __m128i acc = _mm_setzero_si128();
+
+    for (; i + 16 <= size; i += 16)
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128((const __m128i *)(a + i)),
+                                              _mm_loadu_si128((const __m128i *)(b + i))));
+
+    sad = _mm_cvtsi128_si32(acc) + _mm_extract_epi16(acc, 4) +
+          ((RK_U32)_mm_extract_epi16(acc, 5) << 16);
+#elif defined(__ARM_NEON)
+    uint32x4_t acc = vdupq_n_u32(0);
+
+    for (; i + 16 <= size; i += 16)
+        acc = vpadalq_u16(acc, vpaddlq_u8(vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i))));
+
+    sad = vgetq_lane_u32(acc, 0) + vgetq_lane_u32(acc, 1) +
+          vgetq_lane_u32(acc, 2) + vgetq_lane_u32(acc, 3);
+#endif
+
+    for (; i < size; i++)
+        sad += MPP_ABS(a[i] - b[i]);
+
+    return sad;
+}
+
+static MPP_RET hist_setup(RcHistoryImpl *p, RK_S32 blk_w, RK_S32 blk_h)
+{
+    if (p->blk_w == blk_w && p->blk_h == blk_h)
+        return MPP_OK;
+
+    MPP_FREE(p->thumb[0]);
+    MPP_FREE(p->thumb[1]);
+    MPP_FREE(p->sum);
+
+    p->thumb[0] = mpp_malloc(RK_U8, blk_w * blk_h);
+    p->thumb[1] = mpp_malloc(RK_U8, blk_w * blk_h);
+    p->sum = mpp_malloc(RK_U16, blk_w);
+    if (NULL == p->thumb[0] || NULL == p->thumb[1] || NULL == p->sum) {
+        mpp_err_f("failed to malloc thumbnail %dx%d\n", blk_w, blk_h);
+        MPP_FREE(p->thumb[0]);
+        MPP_FREE(p->thumb[1]);
+        MPP_FREE(p->sum);
+        p->blk_w = 0;
+        p->blk_h = 0;
+        return MPP_ERR_MALLOC;
+    }
+
+    p->blk_w = blk_w;
+    p->blk_h = blk_h;
+    p->has_prev = 0;
+    p->cost_valid = 0;
+
+    return MPP_OK;
+}
+
+MPP_RET rc_history_init(RcHistory *ctx, RK_S32 depth)
+{
+    RcHistoryImpl *p = NULL;
+
+    if (NULL == ctx || depth <= 0) {
+        mpp_err_f("invalid ctx %p depth %d\n", ctx, depth);
+        return MPP_ERR_VALUE;
+    }
+
+    *ctx = NULL;
+
+    p = mpp_calloc(RcHistoryImpl, 1);
+    if (NULL == p) {
+        mpp_err_f("failed to malloc context\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    p->depth = depth;
+    if (mpp_data_init_v2(&p->cost, depth, 0)) {
+        MPP_FREE(p);
+        return MPP_ERR_MALLOC;
+    }
+
+    *ctx = p;
+    return MPP_OK;
+}
+
+MPP_RET rc_history_deinit(RcHistory ctx)
+{
+    RcHistoryImpl *p = (RcHistoryImpl *)ctx;
+
+    if (NULL == p)
+        return MPP_OK;
+
+    if (p->cost)
+        mpp_data_deinit_v2(p->cost);
+
+    MPP_FREE(p->thumb[0]);
+    MPP_FREE(p->thumb[1]);
+    MPP_FREE(p->sum);
+    MPP_FREE(p);
+
+    return MPP_OK;
+}
+
+MPP_RET rc_history_proc(RcHistory ctx, MppFrame frame, EncRcTaskInfo *info)
+{
+    RcHistoryImpl *p = (RcHistoryImpl *)ctx;
+    MppFrameFormat fmt;
+    MppBuffer buf;
+    RK_U8 *src;
+    RK_U8 *curr;
+    RK_U8 *prev;
+    RK_U16 *sum;
+    RK_S32 stride;
+    RK_S32 blk_w;
+    RK_S32 blk_h;
+    RK_S32 cost_mean;
+    RK_U32 intra = 0;
+    RK_U32 inter = 0;
+    RK_S32 cost;
+    RK_S32 x, y;
+
+    if (NULL == p || NULL == frame || NULL == info)
+        return MPP_ERR_NULL_PTR;
+
+    info->hist_ratio = 0;
+    info->hist_scene_cut = 0;
+
+    fmt = mpp_frame_get_fmt(frame);
+    buf = mpp_frame_get_buffer(frame);
+
+    /* only 8bit luma plane is analyzed */
+    if (!buf || MPP_FRAME_FMT_IS_FBC(fmt) || !MPP_FRAME_FMT_IS_YUV(fmt))
+        return MPP_OK;
+
+    fmt &= MPP_FRAME_FMT_MASK;
+    if (fmt == MPP_FMT_YUV420SP_10BIT || fmt == MPP_FMT_YUV422SP_10BIT ||
+        (fmt >= MPP_FMT_YUV422_YUYV && fmt <= MPP_FMT_YUV422_VYUY))
+        return MPP_OK;
+
+    src = (RK_U8 *)mpp_buffer_get_ptr(buf);
+    stride = mpp_frame_get_hor_stride(frame);
+    blk_w = mpp_frame_get_width(frame) / HIST_BLK_SIZE;
+    blk_h = mpp_frame_get_height(frame) / HIST_BLK_SIZE;
+    if (NULL == src || blk_w < 2 || blk_h < 2)
+        return MPP_OK;
+
+    if (hist_setup(p, blk_w, blk_h))
+        return MPP_OK;
+
+    curr = p->thumb[p->curr];
+    prev = p->thumb[!p->curr];
+    sum = p->sum;
+
+    /* block mean from every other row of the block */
+    for (y = 0; y < blk_h; y++) {
+        const RK_U8 *row = src + y * HIST_BLK_SIZE * stride;
+
+        memset(sum, 0, sizeof(*sum) * blk_w);
+        for (x = 0; x < HIST_BLK_SIZE; x += 2)
+            hist_row_sum(row + x * stride, blk_w, sum);
+
+        for (x = 0; x < blk_w; x++)
+            curr[y * blk_w + x] = (RK_U8)(sum[x] >> 5);
+    }
+
+    for (y = 0; y < blk_h; y++) {
+        RK_U8 *row = curr + y * blk_w;
+
+        intra += hist_sad(row, row + 1, blk_w - 1);
+        if (y + 1 < blk_h)
+            intra += hist_sad(row, row + blk_w, blk_w);
+    }
+
+    /* a block can always be coded as intra so inter cost is bounded by it */
+    if (p->has_prev) {
+        inter = hist_sad(curr, prev, blk_w * blk_h);
+        info->hist_scene_cut = MPP_MIN(RC_HIST_SCENE_CUT_MAX,
+                                       (RK_S64)inter * RC_HIST_SCENE_CUT_UNIT / (intra + 1));
+        cost = MPP_MIN(inter, intra);
+    } else {
+        cost = intra;
+    }
+
+    /* bias one per block to keep flat scene stable */
+    cost = (RK_S32)(((RK_S64)cost + blk_w * blk_h) * 16 / (blk_w * blk_h));
+    if (!p->cost_valid) {
+        mpp_data_reset_v2(p->cost, cost);
+        p->cost_valid = 1;
+    }
+
+    cost_mean = mpp_data_mean_v2(p->cost);
+    info->hist_ratio = cost * 16 / MPP_MAX(cost_mean, 1);
+    mpp_data_update_v2(p->cost, cost);
+
+    rc_dbg_rc("history intra %u inter %u cost %d mean %d ratio %d scene %d\n",
+              intra, inter, cost, cost_mean, info->hist_ratio, info->hist_scene_cut);
+
+    p->curr = !p->curr;
+    p->has_prev = 1;
+
+    return MPP_OK;
+}
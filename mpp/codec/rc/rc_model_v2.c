@@ -26,6 +26,7 @@
 #include "rc_debug.h"
 #include "rc_ctx.h"
 #include "rc_model_v2.h"
+#include "rc_history.h"
 
 #define I_WINDOW_LEN 2
 #define P_WINDOW1_LEN 5
@@ -250,7 +251,7 @@ void bits_frm_init(RcModelV2Ctx *ctx)
 
 RK_S32 moving_judge_update(RcModelV2Ctx *ctx, EncRcTaskInfo *cfg)
 {
-    switch (ctx->frame_type) {
+    switch (cfg->frame_type) {
     case INTRA_FRAME: {
         mpp_data_update_v2(ctx->pre_i_bit, cfg->bit_real);
         mpp_data_update_v2(ctx->pre_i_mean_qp, cfg->quality_real);
@@ -280,9 +281,11 @@ void bit_statics_update(RcModelV2Ctx *ctx, RK_U32 real_bit)
     ctx->avg_gbits  = (gop_len - 1) * (RK_S64)mean_pbits + mean_ibits;
 }
 
-MPP_RET bits_model_update(RcModelV2Ctx *ctx, RK_S32 real_bit, RK_U32 madi)
+MPP_RET bits_model_update(RcModelV2Ctx *ctx, EncRcTaskInfo *cfg)
 {
     RcCfg *usr_cfg = &ctx->usr_cfg;
+    RK_S32 real_bit = cfg->bit_real;
+    RK_U32 madi = cfg->madi;
     RK_S32 water_level = 0;
 
     rc_dbg_func("enter %p\n", ctx);
@@ -299,7 +302,7 @@ MPP_RET bits_model_update(RcModelV2Ctx *ctx, RK_S32 real_bit, RK_U32 madi)
         water_level = 0;
     }
     ctx->stat_watl = water_level;
-    switch (ctx->frame_type) {
+    switch (cfg->frame_type) {
     case INTRA_FRAME: {
         mpp_data_update_v2(ctx->i_bit, real_bit);
         ctx->i_sumbits = mpp_data_sum_v2(ctx->i_bit);
@@ -1025,6 +1028,101 @@ MPP_RET check_re_enc(RcModelV2Ctx *ctx, EncRcTaskInfo *cfg)
     return ret;
 }
 
+#define QP_BITS_DECAY           (0.875f)
+#define QP_BITS_MAX             (0x7fffffff)
+#define REENC_PRED_QP_STEP      (4)
+
+static void qp_bits_model_update(RcQpBitsModel *m, RK_S32 qp, RK_S32 bits)
+{
+    float log_bits;
+
+    if (qp <= 0 || bits <= 0)
+        return;
+
+    log_bits = log2f((float)bits);
+
+    m->sum_w      = m->sum_w * QP_BITS_DECAY + 1;
+    m->sum_qp     = m->sum_qp * QP_BITS_DECAY + qp;
+    m->sum_log    = m->sum_log * QP_BITS_DECAY + log_bits;
+    m->sum_qp2    = m->sum_qp2 * QP_BITS_DECAY + qp * qp;
+    m->sum_qp_log = m->sum_qp_log * QP_BITS_DECAY + qp * log_bits;
+}
+
+/* return 0 when there is not enough history to predict */
+static RK_S32 qp_bits_model_predict(RcQpBitsModel *m, RK_S32 qp)
+{
+    float mean_qp;
+    float mean_log;
+    float var;
+    float slope;
+    float log_bits;
+
+    if (m->sum_w < 2)
+        return 0;
+
+    mean_qp = m->sum_qp / m->sum_w;
+    mean_log = m->sum_log / m->sum_w;
+    var = m->sum_qp2 / m->sum_w - mean_qp * mean_qp;
+
+    /* frame bits halve every 6 qp when the qp history is too flat to fit */
+    slope = -1.0f / 6;
+    if (var > 0.5f) {
+        slope = (m->sum_qp_log / m->sum_w - mean_qp * mean_log) / var;
+        slope = MPP_MIN(slope, -1.0f / 12);
+        slope = MPP_MAX(slope, -1.0f / 3);
+    }
+
+    log_bits = mean_log + slope * (qp - mean_qp);
+    if (log_bits >= 30)
+        return QP_BITS_MAX;
+
+    return (RK_S32)exp2f(log_bits);
+}
+
+/*
+ * Raise the start qp of the first pass when the qp to bits model says the
+ * frame would trigger check_re_enc. It saves the second hardware pass.
+ */
+static void check_re_enc_predict(RcModelV2Ctx *ctx, EncRcTaskInfo *cfg)
+{
+    RcCfg *usr_cfg = &ctx->usr_cfg;
+    RcQpBitsModel *model = &ctx->qp_bits[ctx->frame_type];
+    RK_S32 qp = cfg->quality_target;
+    RK_S32 qp_max = MPP_MIN(cfg->quality_max, qp + REENC_PRED_QP_STEP);
+    EncRcTaskInfo pred;
+
+    if (ctx->reenc_cnt || usr_cfg->max_reencode_times <= 0)
+        return;
+
+    /* drop mode handles oversized p frame by dropping */
+    if (usr_cfg->drop_mode && ctx->frame_type == INTER_P_FRAME)
+        return;
+
+    memcpy(&pred, cfg, sizeof(pred));
+
+    for (; qp < qp_max; qp++) {
+        RK_S64 bits = qp_bits_model_predict(model, qp);
+
+        if (!bits)
+            return;
+
+        /* the model is for average frame so apply the frame history ratio */
+        if (cfg->hist_ratio)
+            bits = bits * cfg->hist_ratio / 16;
+
+        pred.bit_real = (RK_S32)MPP_MIN(bits, QP_BITS_MAX);
+        if (!check_re_enc(ctx, &pred))
+            break;
+    }
+
+    if (qp != cfg->quality_target) {
+        rc_dbg_rc("reenc predict bits %d target %d qp %d -> %d\n",
+                  pred.bit_real, cfg->bit_target, cfg->quality_target, qp);
+        ctx->reenc_pred_cnt++;
+        ctx->start_qp = qp;
+        cfg->quality_target = qp;
+    }
+}
 
 MPP_RET rc_model_v2_init(void *ctx, RcCfg *cfg)
 {
@@ -1033,6 +1131,7 @@ MPP_RET rc_model_v2_init(void *ctx, RcCfg *cfg)
     rc_dbg_func("enter %p\n", ctx);
 
     memcpy(&p->usr_cfg, cfg, sizeof(RcCfg));
+    memset(p->qp_bits, 0, sizeof(p->qp_bits));
     bits_model_init(p);
 
     rc_dbg_func("leave %p\n", ctx);
@@ -1044,6 +1143,8 @@ MPP_RET rc_model_v2_deinit(void *ctx)
     RcModelV2Ctx *p = (RcModelV2Ctx *)ctx;
 
     rc_dbg_func("enter %p\n", ctx);
+    rc_dbg_rc("reenc frame %d pass %d predicted %d\n",
+              p->reenc_frm_cnt, p->reenc_pass_cnt, p->reenc_pred_cnt);
     bits_model_param_deinit(p);
 
     rc_dbg_func("leave %p\n", ctx);
@@ -1098,6 +1199,9 @@ MPP_RET rc_model_v2_start(void *ctx, EncRcTask *task)
         p->frame_type = INTER_VI_FRAME;
     }
 
+    info->frame_type = p->frame_type;
+    info->scale_qp = p->cur_scale_qp;
+
     p->next_ratio = 0;
     if (p->last_frame_type == INTRA_FRAME) {
         calc_next_i_ratio(p);
@@ -1110,6 +1214,21 @@ MPP_RET rc_model_v2_start(void *ctx, EncRcTask *task)
         bits_model_alloc(p, info, p->gop_total_bits);
     }
 
+    /* frame history found a complex frame so give it the bits before encoding */
+    if (!p->first_frm_flg && !frm->is_intra && info->hist_ratio > 16) {
+        RK_S32 max_ratio = MPP_MAX(usr_cfg->max_i_bit_prop * 16, 32);
+        RK_S32 ratio = info->hist_ratio;
+
+        if (info->hist_scene_cut >= RC_HIST_SCENE_CUT_THD)
+            ratio = MPP_MAX(ratio, (RK_S32)p->i_scale);
+
+        ratio = mpp_clip(ratio, 16, max_ratio);
+        rc_dbg_rc("history ratio %d scene %d bit_target %d -> %d\n",
+                  info->hist_ratio, info->hist_scene_cut, info->bit_target,
+                  (RK_S32)((RK_S64)info->bit_target * ratio / 16));
+        info->bit_target = (RK_S32)((RK_S64)info->bit_target * ratio / 16);
+    }
+
     /* quality determination */
     if (p->first_frm_flg)
         info->quality_target = -1;
@@ -1276,6 +1395,10 @@ MPP_RET rc_model_v2_hal_start(void *ctx, EncRcTask *task)
 
     p->start_qp = mpp_clip(p->start_qp, info->quality_min, info->quality_max);
     info->quality_target = p->start_qp;
+    info->scale_qp = p->cur_scale_qp;
+
+    if (!p->first_frm_flg)
+        check_re_enc_predict(p, info);
 
     rc_dbg_rc("bitrate [%d : %d : %d] -> [%d : %d : %d]\n",
               bit_min, bit_target, bit_max,
@@ -1342,7 +1465,10 @@ MPP_RET rc_model_v2_check_reenc(void *ctx, EncRcTask *task)
                 p->re_calc_ratio(p, cfg);
 
             if (p->next_ratio != 0 && cfg->quality_target < cfg->quality_max) {
+                if (!p->reenc_cnt)
+                    p->reenc_frm_cnt++;
                 p->reenc_cnt++;
+                p->reenc_pass_cnt++;
                 frm->reencode = 1;
             }
             p->drop_cnt = 0;
@@ -1350,6 +1476,12 @@ MPP_RET rc_model_v2_check_reenc(void *ctx, EncRcTask *task)
         }
     }
 
+    /* the pass which is going to be discarded is still a sample */
+    if (frm->reencode)
+        qp_bits_model_update(&p->qp_bits[p->frame_type],
+                             cfg->quality_real ? cfg->quality_real : cfg->quality_target,
+                             cfg->bit_real);
+
     return MPP_OK;
 }
 
@@ -1369,15 +1501,19 @@ MPP_RET rc_model_v2_end(void *ctx, EncRcTask *task)
     p->last_inst_bps = p->ins_bps;
     p->first_frm_flg = 0;
 
-    bits_model_update(p, cfg->bit_real, cfg->madi);
+    /* frame_type and scale_qp of this frame, ctx may hold the next frame */
+    bits_model_update(p, cfg);
+    qp_bits_model_update(&p->qp_bits[cfg->frame_type],
+                         cfg->quality_real ? cfg->quality_real : cfg->quality_target,
+                         cfg->bit_real);
     if (usr_cfg->mode == RC_AVBR) {
         moving_judge_update(p, cfg);
         bit_statics_update(p, cfg->bit_real);
     }
 
-    p->last_frame_type = p->frame_type;
+    p->last_frame_type = cfg->frame_type;
     p->pre_mean_qp = cfg->quality_real;
-    p->scale_qp = p->cur_scale_qp;
+    p->scale_qp = cfg->scale_qp;
     p->prev_md_prop = 0;
     p->pre_target_bits = cfg->bit_target;
     p->pre_real_bits = cfg->bit_real;
@@ -347,15 +347,20 @@ MPP_RET bits_model_smt_init(RcModelV2SmtCtx *ctx)
     return MPP_OK;
 }
 
-MPP_RET bits_model_update_smt(RcModelV2SmtCtx *ctx, RK_S32 real_bit)
+MPP_RET bits_model_update_smt(RcModelV2SmtCtx *ctx, EncRcTaskInfo *cfg)
 {
+    RK_S32 real_bit = cfg->bit_real;
+    /* targets of this frame, ctx may hold the targets of the next frame */
+    RK_S32 bits_target_low_rate = cfg->bit_min;
+    RK_S32 bits_target_high_rate = cfg->bit_max;
+
     rc_dbg_func("enter %p\n", ctx);
     // smt
     RK_S32 gop_len = ctx->usr_cfg.igop;
     RcFpsCfg *fps = &ctx->usr_cfg.fps;
 
-    ctx->pre_diff_bit_low_rate = ctx->bits_target_low_rate - real_bit;
-    ctx->pre_diff_bit_high_rate = ctx->bits_target_high_rate - real_bit;
+    ctx->pre_diff_bit_low_rate = bits_target_low_rate - real_bit;
+    ctx->pre_diff_bit_high_rate = bits_target_high_rate - real_bit;
     ctx->bits_one_gop[ctx->frame_cnt_in_gop % 1000] = real_bit;
     ctx->frame_cnt_in_gop++;
 
@@ -374,20 +379,20 @@ MPP_RET bits_model_update_smt(RcModelV2SmtCtx *ctx, RK_S32 real_bit)
         ctx->delta_bits_per_frame = ctx->bps_target_high_rate / (fps->fps_out_num) - ctx->bits_one_gop_sum / gop_len_save;
     }
 
-    if (ctx->frame_type == INTRA_FRAME) {
+    if (cfg->frame_type == INTRA_FRAME) {
         ctx->acc_intra_count++;
         ctx->acc_intra_bits_in_fps += real_bit;
         mpp_data_update(ctx->intra, real_bit);
         mpp_data_update(ctx->gop_bits, real_bit);
-        mpp_pid_update(&ctx->pid_intra_low_rate, real_bit - ctx->bits_target_low_rate);
-        mpp_pid_update(&ctx->pid_intra_high_rate, real_bit - ctx->bits_target_high_rate);
+        mpp_pid_update(&ctx->pid_intra_low_rate, real_bit - bits_target_low_rate);
+        mpp_pid_update(&ctx->pid_intra_high_rate, real_bit - bits_target_high_rate);
     } else {
         ctx->acc_inter_count++;
         ctx->acc_inter_bits_in_fps += real_bit;
         mpp_data_update(ctx->inter, real_bit);
         mpp_data_update(ctx->gop_bits, real_bit);
-        mpp_pid_update(&ctx->pid_inter_low_rate, real_bit - ctx->bits_target_low_rate);
-        mpp_pid_update(&ctx->pid_inter_high_rate, real_bit - ctx->bits_target_high_rate);
+        mpp_pid_update(&ctx->pid_inter_low_rate, real_bit - bits_target_low_rate);
+        mpp_pid_update(&ctx->pid_inter_high_rate, real_bit - bits_target_high_rate);
     }
 
     ctx->acc_total_count++;
@@ -668,6 +673,7 @@ MPP_RET rc_model_v2_smt_start(void *ctx, EncRcTask *task)
     } else {
         p->frame_type = INTER_P_FRAME;
     }
+    info->frame_type = p->frame_type;
 
     switch (p->gop_mode) {
     case MPP_GOP_ALL_INTER : {
@@ -979,6 +985,8 @@ MPP_RET rc_model_v2_smt_start(void *ctx, EncRcTask *task)
     }
 
     info->bit_target = p->bits_target_use;
+    info->bit_min = p->bits_target_low_rate;
+    info->bit_max = p->bits_target_high_rate;
     info->quality_target = p->qp_out;
     info->quality_max = p->usr_cfg.max_quality;
     info->quality_min = p->usr_cfg.min_quality;
@@ -1029,6 +1037,9 @@ MPP_RET rc_model_v2_smt_end(void *ctx, EncRcTask *task)
     RK_S32 madi = cfg->madi;
     RK_S32 cu64_num = (MPP_ALIGN(width, 64) / 64 * MPP_ALIGN(height, 64) / 64) ;
     RK_U64 sse_dat = cfg->madp * cu64_num;
+    /* frame type and qp of this frame, ctx may hold the next frame */
+    RK_S32 frame_type = cfg->frame_type;
+    RK_S32 qp_out = cfg->quality_target;
     RK_U32 qp_sum;
     double avg_qp = 0.0;
     RK_S32 avg_sse = 1;
@@ -1043,17 +1054,17 @@ MPP_RET rc_model_v2_smt_end(void *ctx, EncRcTask *task)
     avg_qp = qp_sum;
     avg_sse = (RK_S32)sqrt((double)(sse_dat));
     p->qp_preavg = (RK_S32)(avg_qp + 0.5);
-    if (p->frame_type == INTER_P_FRAME) {
+    if (frame_type == INTER_P_FRAME) {
         if (madi >= MAD_THDI) {
-            avg_qp = p->qp_out;
+            avg_qp = qp_out;
         }
     }
 
-    if (p->frame_type == INTER_P_FRAME || p->gop_mode == MPP_GOP_ALL_INTRA) {
+    if (frame_type == INTER_P_FRAME || p->gop_mode == MPP_GOP_ALL_INTRA) {
         mpp_data_update(p->qp_p, avg_qp);
         mpp_data_update(p->sse_p, avg_sse);
     } else {
-        p->intra_preqp = p->qp_out;
+        p->intra_preqp = qp_out;
         p->intra_presse = avg_sse;
         p->intra_premadi = madi;
         p->intra_prerealbit = bit_real;
@@ -1061,12 +1072,12 @@ MPP_RET rc_model_v2_smt_end(void *ctx, EncRcTask *task)
 
     p->st_madi = cfg->madi;
     rc_dbg_rc("bits_mode_update real_bit %d", bit_real);
-    bits_model_update_smt(p, bit_real);
+    bits_model_update_smt(p, cfg);
     p->pre_target_bits = cfg->bit_target;
     p->pre_real_bits = bit_real;
-    p->qp_prev_out = p->qp_out;
+    p->qp_prev_out = qp_out;
     p->last_inst_bps = p->ins_bps;
-    p->last_frame_type = p->frame_type;
+    p->last_frame_type = frame_type;
 
     rc_dbg_func("leave %p\n", ctx);
     return MPP_OK;
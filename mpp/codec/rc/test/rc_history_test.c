@@ -0,0 +1,141 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "rc_history_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_buffer.h"
+#include "rc_history.h"
+
+#define HIST_TEST_WIDTH       320
+#define HIST_TEST_HEIGHT      240
+
+/* fill luma with a pattern and leave chroma flat */
+static void hist_test_fill(MppBuffer buf, RK_S32 pattern)
+{
+    RK_U8 *ptr = (RK_U8 *)mpp_buffer_get_ptr(buf);
+    RK_S32 x, y;
+
+    for (y = 0; y < HIST_TEST_HEIGHT; y++) {
+        for (x = 0; x < HIST_TEST_WIDTH; x++) {
+            RK_U8 *pix = ptr + y * HIST_TEST_WIDTH + x;
+
+            switch (pattern) {
+            case 0 : {
+                *pix = 128;
+            } break;
+            case 1 : {
+                *pix = (RK_U8)(((x >> 3) + (y >> 3)) * 16);
+            } break;
+            default : {
+                *pix = (RK_U8)(((x * 7) ^ (y * 13)) * pattern);
+            } break;
+            }
+        }
+    }
+
+    memset(ptr + HIST_TEST_WIDTH * HIST_TEST_HEIGHT, 128,
+           HIST_TEST_WIDTH * HIST_TEST_HEIGHT / 2);
+}
+
+int main()
+{
+    MPP_RET ret = MPP_NOK;
+    RcHistory hist = NULL;
+    MppBufferGroup group = NULL;
+    MppBuffer buf = NULL;
+    MppFrame frame = NULL;
+    EncRcTaskInfo info;
+    RK_S32 i;
+
+    mpp_log("rc history test start\n");
+
+    mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_NORMAL);
+    mpp_buffer_get(group, &buf, HIST_TEST_WIDTH * HIST_TEST_HEIGHT * 3 / 2);
+    mpp_frame_init(&frame);
+    if (!group || !buf || !frame) {
+        mpp_err("failed to prepare test frame\n");
+        goto DONE;
+    }
+
+    mpp_frame_set_width(frame, HIST_TEST_WIDTH);
+    mpp_frame_set_height(frame, HIST_TEST_HEIGHT);
+    mpp_frame_set_hor_stride(frame, HIST_TEST_WIDTH);
+    mpp_frame_set_ver_stride(frame, HIST_TEST_HEIGHT);
+    mpp_frame_set_fmt(frame, MPP_FMT_YUV420SP);
+    mpp_frame_set_buffer(frame, buf);
+
+    if (rc_history_init(&hist, 4)) {
+        mpp_err("rc_history_init failed\n");
+        goto DONE;
+    }
+
+    /* flat frame then a static textured scene */
+    hist_test_fill(buf, 0);
+    memset(&info, 0, sizeof(info));
+    rc_history_proc(hist, frame, &info);
+
+    hist_test_fill(buf, 1);
+    for (i = 0; i < 4; i++) {
+        memset(&info, 0, sizeof(info));
+        rc_history_proc(hist, frame, &info);
+        mpp_log("static frame %d ratio %d scene %d\n", i,
+                info.hist_ratio, info.hist_scene_cut);
+    }
+
+    if (!info.hist_ratio || info.hist_scene_cut >= RC_HIST_SCENE_CUT_THD) {
+        mpp_err("static scene should be cheap to predict\n");
+        goto DONE;
+    }
+
+    /* switch to a different texture */
+    hist_test_fill(buf, 3);
+    memset(&info, 0, sizeof(info));
+    rc_history_proc(hist, frame, &info);
+    mpp_log("scene cut frame ratio %d scene %d\n",
+            info.hist_ratio, info.hist_scene_cut);
+
+    if (info.hist_ratio <= 16 || info.hist_scene_cut < RC_HIST_SCENE_CUT_THD) {
+        mpp_err("scene cut is not detected\n");
+        goto DONE;
+    }
+
+    /* formats which can not be analyzed are reported as zero */
+    mpp_frame_set_fmt(frame, (MppFrameFormat)(MPP_FMT_YUV420SP | MPP_FRAME_FBC_AFBC_V1));
+    memset(&info, 0, sizeof(info));
+    rc_history_proc(hist, frame, &info);
+    if (info.hist_ratio || info.hist_scene_cut) {
+        mpp_err("fbc frame should be skipped\n");
+        goto DONE;
+    }
+
+    ret = MPP_OK;
+DONE:
+    if (hist)
+        rc_history_deinit(hist);
+    if (frame)
+        mpp_frame_deinit(&frame);
+    if (buf)
+        mpp_buffer_put(buf);
+    if (group)
+        mpp_buffer_group_put(group);
+
+    mpp_log("rc history test %s\n", ret ? "failed" : "success");
+
+    return ret;
+}
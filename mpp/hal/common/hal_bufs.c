@@ -34,7 +34,7 @@
 #define hal_bufs_enter()                hal_bufs_dbg_func("enter\n");
 #define hal_bufs_leave()                hal_bufs_dbg_func("leave\n");
 
-#define MAX_HAL_BUFS_CNT                40
+#define MAX_HAL_BUFS_CNT                64
 #define MAX_HAL_BUFS_SIZE_CNT           8
 
 typedef struct HalBufsImpl_t {
@@ -45,7 +45,7 @@ typedef struct HalBufsImpl_t {
     RK_S32          size_sum;
     RK_S32          elem_size;
 
-    RK_U32          valid;
+    RK_U64          valid;
     size_t          sizes[MAX_HAL_BUFS_SIZE_CNT];
     RK_U8           *bufs;
 } HalBufsImpl;
@@ -67,7 +67,7 @@ static MPP_RET hal_bufs_clear(HalBufsImpl *impl)
         RK_S32 i;
 
         for (i = 0; i < impl->max_cnt; i++) {
-            RK_U32 mask = 1 << i;
+            RK_U64 mask = (RK_U64)1 << i;
 
             if (impl->valid & mask) {
                 HalBuf *buf = hal_bufs_pos(impl, i);
@@ -96,6 +96,34 @@ static MPP_RET hal_bufs_clear(HalBufsImpl *impl)
     return ret;
 }
 
+/* extend the buffer set array and keep the buffers already allocated */
+static MPP_RET hal_bufs_grow(HalBufsImpl *impl, RK_S32 max_cnt)
+{
+    RK_S32 elem_size = impl->elem_size;
+    RK_U8 *bufs = mpp_calloc_size(RK_U8, elem_size * max_cnt);
+    RK_S32 i;
+
+    if (NULL == bufs) {
+        mpp_err_f("failed to malloc size %d for impl\n", elem_size * max_cnt);
+        return MPP_ERR_MALLOC;
+    }
+
+    memcpy(bufs, impl->bufs, elem_size * impl->max_cnt);
+    MPP_FREE(impl->bufs);
+    impl->bufs = bufs;
+
+    for (i = 0; i < max_cnt; i++) {
+        HalBuf *buf = hal_bufs_pos(impl, i);
+
+        buf->cnt = impl->size_cnt;
+        buf->buf = (MppBuffer)(buf + 1);
+    }
+
+    impl->max_cnt = max_cnt;
+
+    return MPP_OK;
+}
+
 MPP_RET hal_bufs_init(HalBufs *bufs)
 {
     MPP_RET ret = MPP_OK;
@@ -171,6 +199,16 @@ MPP_RET hal_bufs_setup(HalBufs bufs, RK_S32 max_cnt, RK_S32 size_cnt, size_t siz
 
     hal_bufs_enter();
 
+    /* same buffer sizes with more buffer sets, grow on demand */
+    if (impl->bufs && size_cnt == impl->size_cnt && max_cnt >= impl->max_cnt &&
+        !memcmp(sizes, impl->sizes, sizeof(sizes[0]) * size_cnt)) {
+        if (max_cnt > impl->max_cnt)
+            ret = hal_bufs_grow(impl, max_cnt);
+
+        hal_bufs_leave();
+        return ret;
+    }
+
     hal_bufs_clear(impl);
 
     if (impl->group)
@@ -227,7 +265,7 @@ HalBuf *hal_bufs_get_buf(HalBufs bufs, RK_S32 buf_idx)
     hal_bufs_enter();
 
     HalBuf *hal_buf = hal_bufs_pos(impl, buf_idx);
-    RK_U32 mask = 1 << buf_idx;
+    RK_U64 mask = (RK_U64)1 << buf_idx;
 
     if (!(impl->valid & mask)) {
         MppBufferGroup group = impl->group;
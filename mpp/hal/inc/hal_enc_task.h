@@ -33,7 +33,12 @@ typedef struct HalEncTaskFlag_t {
     RK_U32          err;
 } HalEncTaskFlag;
 
-typedef struct HalEncTask_t {
+typedef struct HalEncTask_t HalEncTask;
+
+/* low delay output of one slice done on hardware with its stream length */
+typedef void (*HalEncSliceOut)(void *ctx, HalEncTask *task, RK_U32 length);
+
+struct HalEncTask_t {
     RK_U32          valid;
 
     // rate control data channel
@@ -80,6 +85,18 @@ typedef struct HalEncTask_t {
     RK_S32          temporal_id;
 
     HalEncTaskFlag  flags;
-} HalEncTask;
+
+    /*
+     * Low delay output
+     *
+     * When slice_out is set hal wait calls it on each slice done on hardware
+     * except the last one. slice_length is the hardware stream reported so
+     * far and out_length is the packet length already returned to user.
+     */
+    HalEncSliceOut  slice_out;
+    void            *slice_out_ctx;
+    RK_U32          slice_length;
+    RK_U32          out_length;
+};
 
 #endif /* __HAL_ENC_TASK__ */
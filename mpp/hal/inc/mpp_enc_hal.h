@@ -29,6 +29,12 @@ typedef struct MppEncHalCfg_t {
     // output from enc_impl
     MppClientType   type;
     MppDev          dev;
+
+    /*
+     * output from hal: registers of next frame can be generated while the
+     * started frame is still on hardware
+     */
+    RK_U32          pipeline;
 } MppEncHalCfg;
 
 typedef struct MppEncHalApi_t {
@@ -70,6 +76,11 @@ MPP_RET mpp_enc_hal_wait(MppEncHal ctx, HalEncTask *task);
 
 MPP_RET mpp_enc_hal_ret_task(MppEncHal ctx, HalEncTask *task);
 
+// scheduling between encoders sharing one device
+MPP_RET mpp_enc_hal_sched_set(MppEncHal ctx, MppEncSchedCfg *cfg);
+MPP_RET mpp_enc_hal_sched_get(MppEncHal ctx, MppEncSchedCfg *cfg);
+MPP_RET mpp_enc_hal_sched_stat(MppEncHal ctx, MppEncSchedStat *stat);
+
 #ifdef __cplusplus
 }
 #endif
@@ -16,9 +16,13 @@
 
 #define  MODULE_TAG "mpp_enc_hal"
 
+#include <string.h>
+
+#include "mpp_env.h"
 #include "mpp_mem.h"
 #include "mpp_log.h"
 #include "mpp_common.h"
+#include "mpp_dev_sched.h"
 
 #include "mpp.h"
 #include "mpp_enc_hal.h"
@@ -29,6 +33,14 @@
 #include "hal_jpege_api_v2.h"
 #include "hal_vp8e_api_v2.h"
 
+static RK_U32 mpp_enc_hal_debug = 0;
+
+#define MPP_ENC_HAL_DBG_SCHED           (0x00000001)
+
+#define mpp_enc_hal_dbg(flag, fmt, ...) _mpp_dbg(mpp_enc_hal_debug, flag, fmt, ## __VA_ARGS__)
+
+#define enc_hal_dbg_sched(fmt, ...)     mpp_enc_hal_dbg(MPP_ENC_HAL_DBG_SCHED, fmt, ## __VA_ARGS__)
+
 static const MppEncHalApi *hw_enc_apis[] = {
 #if HAVE_H264E
     &hal_api_h264e_v2,
@@ -52,8 +64,53 @@ typedef struct MppEncHalImpl_t {
 
     HalTaskGroup        tasks;
     RK_S32              task_count;
+
+    /* optional hardware scheduling between encoder instances */
+    MppEncCfgSet        *cfg;
+    MppDevSched         sched;
+    MppDevSchedChan     sched_chan;
+    MppEncSchedCfg      sched_cfg;
 } MppEncHalImpl;
 
+static void mpp_enc_hal_sched_init(MppEncHalImpl *p, MppEncHalCfg *cfg)
+{
+    RK_U32 depth = 0;
+
+    mpp_env_get_u32("mpp_enc_sched", &depth, 0);
+    if (!depth || cfg->type >= VPU_CLIENT_BUTT)
+        return;
+
+    if (mpp_dev_sched_get(&p->sched, cfg->type, depth))
+        return;
+
+    if (mpp_dev_sched_chan_add(p->sched, &p->sched_chan)) {
+        mpp_dev_sched_put(p->sched);
+        p->sched = NULL;
+        return;
+    }
+
+    p->cfg = cfg->cfg;
+}
+
+static void mpp_enc_hal_sched_deinit(MppEncHalImpl *p)
+{
+    MppDevSchedStat stat;
+
+    if (NULL == p->sched)
+        return;
+
+    mpp_dev_sched_stat(p->sched_chan, &stat);
+    if (stat.count)
+        enc_hal_dbg_sched("sched %p frames %lld miss %lld wait avg %lld max %lld run avg %lld max %lld us\n",
+                          p, stat.count, stat.miss, stat.wait_sum / stat.count, stat.wait_max,
+                          stat.run_sum / stat.count, stat.run_max);
+
+    mpp_dev_sched_chan_del(p->sched_chan);
+    mpp_dev_sched_put(p->sched);
+    p->sched_chan = NULL;
+    p->sched = NULL;
+}
+
 MPP_RET mpp_enc_hal_init(MppEncHal *ctx, MppEncHalCfg *cfg)
 {
     if (NULL == ctx || NULL == cfg) {
@@ -62,6 +119,8 @@ MPP_RET mpp_enc_hal_init(MppEncHal *ctx, MppEncHalCfg *cfg)
     }
     *ctx = NULL;
 
+    mpp_env_get_u32("mpp_enc_hal_debug", &mpp_enc_hal_debug, 0);
+
     MppEncHalImpl *p = mpp_calloc(MppEncHalImpl, 1);
     if (NULL == p) {
         mpp_err_f("malloc failed\n");
@@ -87,6 +146,8 @@ MPP_RET mpp_enc_hal_init(MppEncHal *ctx, MppEncHalCfg *cfg)
                 break;
             }
 
+            mpp_enc_hal_sched_init(p, cfg);
+
             *ctx = p;
             return MPP_OK;
         }
@@ -107,6 +168,7 @@ MPP_RET mpp_enc_hal_deinit(MppEncHal ctx)
     }
 
     MppEncHalImpl *p = (MppEncHalImpl*)ctx;
+    mpp_enc_hal_sched_deinit(p);
     p->api->deinit(p->ctx);
     mpp_free(p->ctx);
     if (p->tasks)
@@ -132,6 +194,112 @@ MPP_RET mpp_enc_hal_deinit(MppEncHal ctx)
 
 MPP_ENC_HAL_TASK_FUNC(get_task)
 MPP_ENC_HAL_TASK_FUNC(gen_regs)
-MPP_ENC_HAL_TASK_FUNC(start)
-MPP_ENC_HAL_TASK_FUNC(wait)
 MPP_ENC_HAL_TASK_FUNC(ret_task)
+
+MPP_RET mpp_enc_hal_start(void *hal, HalEncTask *task)
+{
+    if (NULL == hal || NULL == task) {
+        mpp_err_f("found NULL input ctx %p task %p\n", hal, task);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    MppEncHalImpl *p = (MppEncHalImpl*)hal;
+    if (!p->api || !p->api->start)
+        return MPP_OK;
+
+    if (p->sched) {
+        MppEncRcCfg *rc = &p->cfg->rc;
+        RK_S64 period = p->sched_cfg.period;
+
+        if (!period && rc->fps_out_num > 0)
+            period = (RK_S64)1000000 * MPP_MAX(rc->fps_out_denorm, 1) / rc->fps_out_num;
+
+        mpp_dev_sched_chan_set(p->sched_chan, period, p->sched_cfg.weight);
+        mpp_dev_sched_begin(p->sched_chan);
+    }
+
+    MPP_RET ret = p->api->start(p->ctx, task);
+    if (ret && p->sched)
+        mpp_dev_sched_end(p->sched_chan);
+
+    return ret;
+}
+
+MPP_RET mpp_enc_hal_wait(void *hal, HalEncTask *task)
+{
+    if (NULL == hal || NULL == task) {
+        mpp_err_f("found NULL input ctx %p task %p\n", hal, task);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    MppEncHalImpl *p = (MppEncHalImpl*)hal;
+    if (!p->api || !p->api->wait)
+        return MPP_OK;
+
+    MPP_RET ret = p->api->wait(p->ctx, task);
+
+    if (p->sched)
+        mpp_dev_sched_end(p->sched_chan);
+
+    return ret;
+}
+
+MPP_RET mpp_enc_hal_sched_set(MppEncHal ctx, MppEncSchedCfg *cfg)
+{
+    if (NULL == ctx || NULL == cfg) {
+        mpp_err_f("found NULL input ctx %p cfg %p\n", ctx, cfg);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    if (cfg->period < 0 || cfg->weight < 0) {
+        mpp_err_f("invalid period %d weight %d\n", cfg->period, cfg->weight);
+        return MPP_ERR_VALUE;
+    }
+
+    /* taken on next start, kept when scheduler is disabled */
+    MppEncHalImpl *p = (MppEncHalImpl*)ctx;
+    p->sched_cfg = *cfg;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_enc_hal_sched_get(MppEncHal ctx, MppEncSchedCfg *cfg)
+{
+    if (NULL == ctx || NULL == cfg) {
+        mpp_err_f("found NULL input ctx %p cfg %p\n", ctx, cfg);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    MppEncHalImpl *p = (MppEncHalImpl*)ctx;
+    *cfg = p->sched_cfg;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_enc_hal_sched_stat(MppEncHal ctx, MppEncSchedStat *stat)
+{
+    if (NULL == ctx || NULL == stat) {
+        mpp_err_f("found NULL input ctx %p stat %p\n", ctx, stat);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    MppEncHalImpl *p = (MppEncHalImpl*)ctx;
+    MppDevSchedStat s;
+
+    memset(stat, 0, sizeof(*stat));
+    if (NULL == p->sched)
+        return MPP_NOK;
+
+    MPP_RET ret = mpp_dev_sched_stat(p->sched_chan, &s);
+    if (ret)
+        return ret;
+
+    stat->count     = s.count;
+    stat->miss      = s.miss;
+    stat->wait_sum  = s.wait_sum;
+    stat->wait_max  = s.wait_max;
+    stat->run_sum   = s.run_sum;
+    stat->run_max   = s.run_max;
+
+    return MPP_OK;
+}
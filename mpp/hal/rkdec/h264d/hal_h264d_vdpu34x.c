@@ -677,8 +677,6 @@ MPP_RET vdpu34x_h264d_gen_regs(void *hal, HalTaskInfo *task)
     }
 
     if (p_hal->cmv_bufs == NULL || p_hal->mv_size < mv_size) {
-        size_t size = mv_size;
-
         if (p_hal->cmv_bufs) {
             hal_bufs_deinit(p_hal->cmv_bufs);
             p_hal->cmv_bufs = NULL;
@@ -690,8 +688,20 @@ MPP_RET vdpu34x_h264d_gen_regs(void *hal, HalTaskInfo *task)
             goto __RETURN;
         }
         p_hal->mv_size = mv_size;
-        p_hal->mv_count = mpp_buf_slot_get_count(p_hal->frame_slots);
-        hal_bufs_setup(p_hal->cmv_bufs, p_hal->mv_count, 1, &size);
+        p_hal->mv_count = 0;
+    }
+
+    /* frame slots grow on demand, keep colmv of the reference frames */
+    if (p_hal->mv_count < mpp_buf_slot_get_count(p_hal->frame_slots)) {
+        size_t size = p_hal->mv_size;
+        RK_S32 count = mpp_buf_slot_get_count(p_hal->frame_slots);
+
+        if (hal_bufs_setup(p_hal->cmv_bufs, count, 1, &size)) {
+            mpp_err_f("colmv bufs setup count %d fail\n", count);
+            task->dec.flags.parse_err = 1;
+            goto __RETURN;
+        }
+        p_hal->mv_count = count;
     }
 
     if (p_hal->fast_mode) {
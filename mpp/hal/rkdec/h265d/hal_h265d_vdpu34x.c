@@ -802,8 +802,6 @@ static MPP_RET hal_h265d_vdpu34x_gen_regs(void *hal,  HalTaskInfo *syn)
     height = (dxva_cxt->pp.PicHeightInMinCbsY << log2_min_cb_size);
     mv_size = (width * height >> 1);
     if (reg_cxt->cmv_bufs == NULL || reg_cxt->mv_size < mv_size) {
-        size_t size = mv_size;
-
         if (reg_cxt->cmv_bufs) {
             hal_bufs_deinit(reg_cxt->cmv_bufs);
             reg_cxt->cmv_bufs = NULL;
@@ -816,8 +814,20 @@ static MPP_RET hal_h265d_vdpu34x_gen_regs(void *hal,  HalTaskInfo *syn)
         }
 
         reg_cxt->mv_size = mv_size;
-        reg_cxt->mv_count = mpp_buf_slot_get_count(reg_cxt->slots);
-        hal_bufs_setup(reg_cxt->cmv_bufs, reg_cxt->mv_count, 1, &size);
+        reg_cxt->mv_count = 0;
+    }
+
+    /* frame slots grow on demand, keep colmv of the reference frames */
+    if (reg_cxt->mv_count < mpp_buf_slot_get_count(reg_cxt->slots)) {
+        size_t size = reg_cxt->mv_size;
+        RK_S32 count = mpp_buf_slot_get_count(reg_cxt->slots);
+
+        if (hal_bufs_setup(reg_cxt->cmv_bufs, count, 1, &size)) {
+            mpp_err_f("colmv bufs setup count %d fail\n", count);
+            syn->dec.flags.parse_err = 1;
+            return MPP_ERR_NOMEM;
+        }
+        reg_cxt->mv_count = count;
     }
 
     stride_y = ((MPP_ALIGN(width, 64)
@@ -315,8 +315,6 @@ static MPP_RET hal_vp9d_vdpu34x_gen_regs(void *hal, HalTaskInfo *task)
     }
 
     if (hw_ctx->cmv_bufs == NULL || hw_ctx->mv_size < mv_size) {
-        size_t size = mv_size;
-
         if (hw_ctx->cmv_bufs) {
             hal_bufs_deinit(hw_ctx->cmv_bufs);
             hw_ctx->cmv_bufs = NULL;
@@ -328,8 +326,20 @@ static MPP_RET hal_vp9d_vdpu34x_gen_regs(void *hal, HalTaskInfo *task)
             return MPP_NOK;
         }
         hw_ctx->mv_size = mv_size;
-        hw_ctx->mv_count = mpp_buf_slot_get_count(p_hal ->slots);
-        hal_bufs_setup(hw_ctx->cmv_bufs, hw_ctx->mv_count, 1, &size);
+        hw_ctx->mv_count = 0;
+    }
+
+    /* frame slots grow on demand, keep colmv of the reference frames */
+    if (hw_ctx->mv_count < mpp_buf_slot_get_count(p_hal->slots)) {
+        size_t size = hw_ctx->mv_size;
+        RK_S32 count = mpp_buf_slot_get_count(p_hal->slots);
+
+        if (hal_bufs_setup(hw_ctx->cmv_bufs, count, 1, &size)) {
+            mpp_err_f("colmv bufs setup count %d fail\n", count);
+            task->dec.flags.parse_err = 1;
+            return MPP_ERR_NOMEM;
+        }
+        hw_ctx->mv_count = count;
     }
 
     Vdpu34xVp9dRegSet *vp9_hw_regs = (Vdpu34xVp9dRegSet*)hw_ctx->hw_regs;
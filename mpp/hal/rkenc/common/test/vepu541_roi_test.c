@@ -0,0 +1,164 @@
+/*
+ * Copyright 2020 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "vepu541_roi_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+
+#include "vepu541_common.h"
+
+#define ROI_TEST_WIDTH      320
+#define ROI_TEST_HEIGHT     240
+#define ROI_TEST_BUF_CNT    2
+
+typedef struct RoiTestStep_t {
+    RK_U32              number;
+    /* same regions as the step before */
+    RK_U32              unchanged;
+    MppEncROIRegion     regions[3];
+} RoiTestStep;
+
+static RoiTestStep steps[] = {
+    /* initial draw */
+    {
+        2, 0, {
+            {   0,   0,  64,  32, 0,  -5, 0, 1, 0, },
+            { 128,  96,  64,  64, 1,  10, 1, 1, 0, },
+        },
+    },
+    /* move the second region to other rows */
+    {
+        2, 0, {
+            {   0,   0,  64,  32, 0,  -5, 0, 1, 0, },
+            { 128, 160,  64,  64, 1,  10, 1, 1, 0, },
+        },
+    },
+    /* nothing changed */
+    {
+        2, 1, {
+            {   0,   0,  64,  32, 0,  -5, 0, 1, 0, },
+            { 128, 160,  64,  64, 1,  10, 1, 1, 0, },
+        },
+    },
+    /* change config only */
+    {
+        2, 0, {
+            {   0,   0,  64,  32, 0,   3, 2, 1, 0, },
+            { 128, 160,  64,  64, 1,  10, 1, 1, 0, },
+        },
+    },
+    /* add a region at bottom right corner */
+    {
+        3, 0, {
+            {   0,   0,  64,  32, 0,   3, 2, 1, 0, },
+            { 128, 160,  64,  64, 1,  10, 1, 1, 0, },
+            { 256, 208,  64,  32, 0,  30, 0, 1, 1, },
+        },
+    },
+    /* remove the first region */
+    {
+        2, 0, {
+            { 128, 160,  64,  64, 1,  10, 1, 1, 0, },
+            { 256, 208,  64,  32, 0,  30, 0, 1, 1, },
+        },
+    },
+    /* region out of picture clears all */
+    {
+        1, 0, {
+            { 300,  16,  64,  32, 0,  -8, 0, 1, 0, },
+        },
+    },
+    /* draw again after clear */
+    {
+        1, 0, {
+            {  32,  48,  96,  48, 0,  -8, 0, 1, 0, },
+        },
+    },
+    /* no region */
+    {   0, 0, { { 0 } } },
+};
+
+static RK_S32 roi_test_run(RK_S32 buf_cnt)
+{
+    Vepu541RoiCache caches[ROI_TEST_BUF_CNT];
+    RK_U8 *bufs[ROI_TEST_BUF_CNT] = { NULL };
+    RK_U8 *ref = NULL;
+    RK_S32 size = vepu541_get_roi_buf_size(ROI_TEST_WIDTH, ROI_TEST_HEIGHT);
+    RK_S32 errors = 0;
+    RK_U32 i;
+
+    memset(caches, 0, sizeof(caches));
+
+    ref = mpp_calloc(RK_U8, size);
+    for (i = 0; i < (RK_U32)buf_cnt; i++)
+        bufs[i] = mpp_calloc(RK_U8, size);
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(steps); i++) {
+        RoiTestStep *step = &steps[i];
+        RK_S32 idx = i % buf_cnt;
+        Vepu541RoiCache *cache = &caches[idx];
+        MppEncROICfg roi;
+
+        roi.number = step->number;
+        roi.regions = step->regions;
+
+        vepu541_update_roi(cache, bufs[idx], &roi, ROI_TEST_WIDTH, ROI_TEST_HEIGHT);
+
+        /* reference is a full redraw into a separate buffer */
+        memset(ref, 0, size);
+        vepu541_set_roi(ref, &roi, ROI_TEST_WIDTH, ROI_TEST_HEIGHT);
+
+        if (memcmp(bufs[idx], ref, size)) {
+            mpp_err("buf cnt %d step %d mismatch with full redraw\n", buf_cnt, i);
+            errors++;
+        }
+
+        if (buf_cnt == 1 && step->unchanged && cache->dirty_y1) {
+            mpp_err("buf cnt %d step %d unchanged but rows %d - %d redrawn\n",
+                    buf_cnt, i, cache->dirty_y0, cache->dirty_y1);
+            errors++;
+        }
+
+        mpp_log("buf cnt %d step %d regions %d dirty rows %d - %d\n",
+                buf_cnt, i, step->number, cache->dirty_y0, cache->dirty_y1);
+    }
+
+    for (i = 0; i < (RK_U32)buf_cnt; i++)
+        MPP_FREE(bufs[i]);
+    MPP_FREE(ref);
+
+    return errors;
+}
+
+int main()
+{
+    RK_S32 errors = 0;
+    RK_S32 buf_cnt;
+
+    mpp_log("vepu541_roi_test start\n");
+
+    /* each buffer has its own cache as the hal double buffer */
+    for (buf_cnt = 1; buf_cnt <= ROI_TEST_BUF_CNT; buf_cnt++)
+        errors += roi_test_run(buf_cnt);
+
+    mpp_log("vepu541_roi_test %s\n", errors ? "failed" : "success");
+
+    return errors;
+}
@@ -309,46 +309,46 @@ RK_S32 vepu541_get_roi_buf_size(RK_S32 w, RK_S32 h)
     return buf_size + 32;
 }
 
-MPP_RET vepu541_set_roi(void *buf, MppEncROICfg *roi, RK_S32 w, RK_S32 h)
+/* fill count roi config with val by doubling the filled part */
+static void vepu541_roi_fill(Vepu541RoiCfg *dst, const Vepu541RoiCfg *val, RK_S32 count)
 {
-    MppEncROIRegion *region = roi->regions;
-    Vepu541RoiCfg *ptr = (Vepu541RoiCfg *)buf;
-    RK_S32 mb_w = MPP_ALIGN(w, 16) / 16;
-    RK_S32 mb_h = MPP_ALIGN(h, 16) / 16;
-    RK_S32 stride_h = MPP_ALIGN(mb_w, 4);
-    RK_S32 stride_v = MPP_ALIGN(mb_h, 4);
-    Vepu541RoiCfg cfg;
-    MPP_RET ret = MPP_NOK;
-    RK_S32 i;
+    RK_S32 done = 1;
 
-    if (NULL == buf || NULL == roi) {
-        mpp_err_f("invalid buf %p roi %p\n", buf, roi);
-        goto DONE;
+    if (count <= 0)
+        return;
+
+    dst[0] = *val;
+    while (done < count) {
+        RK_S32 size = MPP_MIN(done, count - done);
+
+        memcpy(dst + done, dst, size * sizeof(*dst));
+        done += size;
     }
+}
 
-    cfg.force_intra = 0;
-    cfg.reserved    = 0;
-    cfg.qp_area_idx = 0;
-    cfg.qp_area_en  = 1;
-    cfg.qp_adj      = 0;
-    cfg.qp_adj_mode = 0;
+static void vepu541_roi_region_rows(MppEncROIRegion *region, RK_S32 *y0, RK_S32 *y1)
+{
+    *y0 = (region->y + 15) / 16;
+    *y1 = *y0 + (region->h + 15) / 16;
+}
 
-    /* step 1. reset all the config */
-    for (i = 0; i < stride_h * stride_v; i++, ptr++)
-        memcpy(ptr, &cfg, sizeof(cfg));
+static MPP_RET vepu541_check_roi(MppEncROICfg *roi, RK_S32 w, RK_S32 h)
+{
+    MppEncROIRegion *region = roi->regions;
+    MPP_RET ret = MPP_OK;
+    RK_S32 i;
 
     if (w <= 0 || h <= 0) {
         mpp_err_f("invalid size [%d:%d]\n", w, h);
-        goto DONE;
+        return MPP_NOK;
     }
 
     if (roi->number > VEPU541_MAX_ROI_NUM) {
-        mpp_err_f("invalid region number %d\n", buf, roi->number);
-        goto DONE;
+        mpp_err_f("invalid region number %d\n", roi->number);
+        return MPP_NOK;
     }
 
     /* check region config */
-    ret = MPP_OK;
     for (i = 0; i < (RK_S32)roi->number; i++, region++) {
         if (region->x + region->w > w || region->y + region->h > h)
             ret = MPP_NOK;
@@ -369,26 +369,67 @@ MPP_RET vepu541_set_roi(void *buf, MppEncROICfg *roi, RK_S32 w, RK_S32 h)
                       region->intra, region->qp_area_idx);
             mpp_err_f("abs qp mode %d value %d\n",
                       region->abs_qp_en, region->quality);
-            goto DONE;
+            break;
         }
     }
 
-    region = roi->regions;
+    return ret;
+}
+
+/*
+ * Rewrite mb rows [y0, y1) with the default config then apply the regions
+ * from first to last so the later region wins on overlap.
+ */
+static void vepu541_roi_draw_rows(Vepu541RoiCfg *buf, RK_S32 w, RK_S32 h,
+                                  RK_S32 y0, RK_S32 y1,
+                                  MppEncROIRegion *region, RK_U32 number)
+{
+    RK_S32 mb_w = MPP_ALIGN(w, 16) / 16;
+    RK_S32 mb_h = MPP_ALIGN(h, 16) / 16;
+    RK_S32 stride_h = MPP_ALIGN(mb_w, 4);
+    RK_S32 stride_v = MPP_ALIGN(mb_h, 4);
+    Vepu541RoiCfg cfg;
+    RK_U32 i;
+
+    y0 = MPP_CLIP3(0, stride_v, y0);
+    y1 = MPP_CLIP3(y0, stride_v, y1);
+    if (y0 >= y1)
+        return;
+
+    cfg.force_intra = 0;
+    cfg.reserved    = 0;
+    cfg.qp_area_idx = 0;
+    cfg.qp_area_en  = 1;
+    cfg.qp_adj      = 0;
+    cfg.qp_adj_mode = 0;
+
+    /* step 1. reset the config of these rows */
+    vepu541_roi_fill(buf + y0 * stride_h, &cfg, (y1 - y0) * stride_h);
+
     /* step 2. setup region for top to bottom */
-    for (i = 0; i < (RK_S32)roi->number; i++, region++) {
+    for (i = 0; i < number; i++, region++) {
         RK_S32 roi_width  = (region->w + 15) / 16;
-        RK_S32 roi_height = (region->h + 15) / 16;
         RK_S32 pos_x_init = (region->x + 15) / 16;
-        RK_S32 pos_y_init = (region->y + 15) / 16;
         RK_S32 pos_x_end  = pos_x_init + roi_width;
-        RK_S32 pos_y_end  = pos_y_init + roi_height;
-        RK_S32 x, y;
+        RK_S32 pos_y_init;
+        RK_S32 pos_y_end;
+        Vepu541RoiCfg *ptr;
+        RK_S32 y;
+
+        vepu541_roi_region_rows(region, &pos_y_init, &pos_y_end);
 
         mpp_assert(pos_x_init >= 0 && pos_x_init < mb_w);
         mpp_assert(pos_x_end  >= 0 && pos_x_end <= mb_w);
         mpp_assert(pos_y_init >= 0 && pos_y_init < mb_h);
         mpp_assert(pos_y_end  >= 0 && pos_y_end <= mb_h);
 
+        pos_x_end  = MPP_MIN(pos_x_end, stride_h);
+        pos_y_init = MPP_MAX(pos_y_init, y0);
+        pos_y_end  = MPP_MIN(pos_y_end, y1);
+        roi_width  = pos_x_end - pos_x_init;
+        if (roi_width <= 0 || pos_y_init >= pos_y_end)
+            continue;
+
         cfg.force_intra = region->intra;
         cfg.reserved    = 0;
         cfg.qp_area_idx = region->qp_area_idx;
@@ -397,19 +438,102 @@ MPP_RET vepu541_set_roi(void *buf, MppEncROICfg *roi, RK_S32 w, RK_S32 h)
         cfg.qp_adj      = region->quality;
         cfg.qp_adj_mode = region->abs_qp_en;
 
-        ptr = (Vepu541RoiCfg *)buf;
-        ptr += pos_y_init * stride_h + pos_x_init;
-        for (y = 0; y < roi_height; y++) {
-            Vepu541RoiCfg *dst = ptr;
+        ptr = buf + pos_y_init * stride_h + pos_x_init;
+        vepu541_roi_fill(ptr, &cfg, roi_width);
+
+        for (y = pos_y_init + 1; y < pos_y_end; y++)
+            memcpy(ptr + (y - pos_y_init) * stride_h, ptr, roi_width * sizeof(*ptr));
+    }
+}
+
+MPP_RET vepu541_set_roi(void *buf, MppEncROICfg *roi, RK_S32 w, RK_S32 h)
+{
+    MPP_RET ret = MPP_NOK;
+
+    if (NULL == buf || NULL == roi) {
+        mpp_err_f("invalid buf %p roi %p\n", buf, roi);
+        return ret;
+    }
+
+    ret = vepu541_check_roi(roi, w, h);
+    vepu541_roi_draw_rows((Vepu541RoiCfg *)buf, w, h, 0, MPP_ALIGN(h, 64) / 16,
+                          roi->regions, ret ? 0 : roi->number);
+
+    return ret;
+}
+
+static RK_S32 vepu541_roi_row_covered(MppEncROIRegion *regions, RK_U32 number, RK_S32 y)
+{
+    RK_U32 i;
+
+    for (i = 0; i < number; i++) {
+        RK_S32 y0, y1;
+
+        vepu541_roi_region_rows(&regions[i], &y0, &y1);
+        if (y >= y0 && y < y1)
+            return 1;
+    }
+
+    return 0;
+}
+
+MPP_RET vepu541_update_roi(Vepu541RoiCache *cache, void *buf, MppEncROICfg *roi,
+                           RK_S32 w, RK_S32 h)
+{
+    Vepu541RoiCfg *ptr = (Vepu541RoiCfg *)buf;
+    RK_S32 stride_v = MPP_ALIGN(h, 64) / 16;
+    RK_U32 number;
+    MPP_RET ret = MPP_NOK;
+
+    if (NULL == cache || NULL == buf || NULL == roi) {
+        mpp_err_f("invalid cache %p buf %p roi %p\n", cache, buf, roi);
+        return ret;
+    }
+
+    cache->dirty_y0 = 0;
+    cache->dirty_y1 = 0;
+
+    if (cache->valid && cache->w == w && cache->h == h &&
+        cache->number == roi->number &&
+        (!roi->number || !memcmp(cache->regions, roi->regions,
+                                 roi->number * sizeof(*roi->regions))))
+        return MPP_OK;
 
-            for (x = 0; x < roi_width; x++, dst++)
-                memcpy(dst, &cfg, sizeof(cfg));
+    ret = vepu541_check_roi(roi, w, h);
+    number = ret ? 0 : roi->number;
 
-            ptr += stride_h;
+    if (!cache->valid || cache->w != w || cache->h != h) {
+        vepu541_roi_draw_rows(ptr, w, h, 0, stride_v, roi->regions, number);
+        cache->dirty_y1 = stride_v;
+    } else {
+        RK_S32 run = -1;
+        RK_S32 y;
+
+        /* only redraw the rows covered by the old or the new regions */
+        for (y = 0; y <= stride_v; y++) {
+            RK_S32 dirty = y < stride_v &&
+                           (vepu541_roi_row_covered(cache->regions, cache->number, y) ||
+                            vepu541_roi_row_covered(roi->regions, number, y));
+
+            if (dirty && run < 0) {
+                run = y;
+            } else if (!dirty && run >= 0) {
+                vepu541_roi_draw_rows(ptr, w, h, run, y, roi->regions, number);
+                if (cache->dirty_y1 == 0)
+                    cache->dirty_y0 = run;
+                cache->dirty_y1 = y;
+                run = -1;
+            }
         }
     }
 
-DONE:
+    cache->valid = 1;
+    cache->w = w;
+    cache->h = h;
+    cache->number = number;
+    if (number)
+        memcpy(cache->regions, roi->regions, number * sizeof(*roi->regions));
+
     return ret;
 }
 
@@ -810,3 +934,35 @@ MPP_RET vepu540_set_osd(Vepu541OsdCfg *cfg)
 
     return MPP_OK;
 }
+
+MPP_RET vepu541_wait(MppDev dev, HalEncTask *task)
+{
+    MppDevPollCfg cfg;
+    RK_U32 last = 0;
+    MPP_RET ret;
+    RK_S32 i;
+
+    if (NULL == task->slice_out)
+        return mpp_dev_ioctl(dev, MPP_DEV_CMD_POLL, NULL);
+
+    do {
+        cfg.poll_type = 0;
+        cfg.poll_ret = 0;
+        cfg.count_max = MPP_DEV_POLL_SLICE_MAX;
+        cfg.count_ret = 0;
+
+        ret = mpp_dev_ioctl(dev, MPP_DEV_CMD_POLL, &cfg);
+        if (ret)
+            break;
+
+        for (i = 0; i < cfg.count_ret && !last; i++) {
+            last = cfg.slice_info[i].last;
+            /* the last slice goes out with the whole frame */
+            if (!last)
+                task->slice_out(task->slice_out_ctx, task,
+                                cfg.slice_info[i].length);
+        }
+    } while (!last);
+
+    return ret;
+}
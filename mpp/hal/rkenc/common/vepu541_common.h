@@ -18,6 +18,7 @@
 
 #include "rk_venc_cmd.h"
 #include "mpp_device.h"
+#include "hal_enc_task.h"
 
 #define VEPU541_REG_BASE_HW_STATUS  0x0000001C
 #define VEPU541_REG_BASE_STATISTICS 0x00000210
@@ -99,6 +100,24 @@ typedef struct Vepu541RoiCfg_t {
     RK_U16 qp_adj_mode  : 1;
 } Vepu541RoiCfg;
 
+/*
+ * Vepu541RoiCache
+ *
+ * The roi config last drawn into a roi buffer. When it is unchanged the
+ * buffer is reused as is, otherwise only the mb rows covered by the old or
+ * the new regions are redrawn and reported in [dirty_y0, dirty_y1).
+ * Clear valid when the buffer is reallocated.
+ */
+typedef struct Vepu541RoiCache_t {
+    RK_S32          valid;
+    RK_S32          w;
+    RK_S32          h;
+    RK_U32          number;
+    MppEncROIRegion regions[VEPU541_MAX_ROI_NUM];
+    RK_S32          dirty_y0;
+    RK_S32          dirty_y1;
+} Vepu541RoiCache;
+
 typedef struct Vepu541OsdPos_t {
     /* X coordinate/16 of OSD region's left-top point. */
     RK_U32  osd_lt_x                : 8;
@@ -147,13 +166,24 @@ MPP_RET vepu541_set_fmt(VepuFmtCfg *cfg, MppFrameFormat format);
  *
  * vepu541_set_roi
  * Setup roi config buffeer for image with mb count mb_w * mb_h
+ *
+ * vepu541_update_roi
+ * Same as vepu541_set_roi but only redraw the changed part against cache
  */
 RK_S32  vepu541_get_roi_buf_size(RK_S32 w, RK_S32 h);
 MPP_RET vepu541_set_roi(void *buf, MppEncROICfg *roi, RK_S32 w, RK_S32 h);
+MPP_RET vepu541_update_roi(Vepu541RoiCache *cache, void *buf, MppEncROICfg *roi,
+                           RK_S32 w, RK_S32 h);
 
 MPP_RET vepu541_set_osd(Vepu541OsdCfg *cfg);
 MPP_RET vepu540_set_osd(Vepu541OsdCfg *cfg);
 
+/*
+ * Wait the started frame. For low delay output each slice done on hardware
+ * but the last one is passed to task->slice_out before the frame is done.
+ */
+MPP_RET vepu541_wait(MppDev dev, HalEncTask *task);
+
 #ifdef __cplusplus
 }
 #endif
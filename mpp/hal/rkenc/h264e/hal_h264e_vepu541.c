@@ -37,6 +37,8 @@
 #include "hal_h264e_vepu541_reg_l2.h"
 #include "vepu541_common.h"
 
+#define H264E_ROI_BUF_CNT       2
+
 typedef struct HalH264eVepu541Ctx_t {
     MppEncCfgSet            *cfg;
 
@@ -65,11 +67,13 @@ typedef struct HalH264eVepu541Ctx_t {
     /* syntax for output to enc_impl */
     EncRcTaskInfo           hal_rc_cfg;
 
-    /* roi */
+    /* roi, next frame is drawn into the other buffer while hardware runs */
     MppEncROICfg            *roi_data;
     MppBufferGroup          roi_grp;
-    MppBuffer               roi_buf;
+    MppBuffer               roi_bufs[H264E_ROI_BUF_CNT];
+    Vepu541RoiCache         roi_caches[H264E_ROI_BUF_CNT];
     RK_S32                  roi_buf_size;
+    RK_S32                  roi_idx;
 
     /* osd */
     Vepu541OsdCfg           osd_cfg;
@@ -104,6 +108,7 @@ static RK_U32 dump_l2_reg = 0;
 static MPP_RET hal_h264e_vepu541_deinit(void *hal)
 {
     HalH264eVepu541Ctx *p = (HalH264eVepu541Ctx *)hal;
+    RK_S32 i;
 
     hal_h264e_dbg_func("enter %p\n", p);
 
@@ -112,9 +117,11 @@ static MPP_RET hal_h264e_vepu541_deinit(void *hal)
         p->dev = NULL;
     }
 
-    if (p->roi_buf) {
-        mpp_buffer_put(p->roi_buf);
-        p->roi_buf = NULL;
+    for (i = 0; i < H264E_ROI_BUF_CNT; i++) {
+        if (p->roi_bufs[i]) {
+            mpp_buffer_put(p->roi_bufs[i]);
+            p->roi_bufs[i] = NULL;
+        }
     }
 
     if (p->roi_grp) {
@@ -149,6 +156,8 @@ static MPP_RET hal_h264e_vepu541_init(void *hal, MppEncHalCfg *cfg)
         goto DONE;
     }
     p->dev = cfg->dev;
+    /* registers are sent on start so gen_regs can run during hardware run */
+    cfg->pipeline = 1;
 
     {
         const char *soc_name = mpp_get_soc_name();
@@ -880,34 +889,42 @@ static void setup_vepu541_roi(Vepu541H264eRegSet *regs, HalH264eVepu541Ctx *ctx)
     /* roi setup */
     if (roi && roi->number && roi->regions) {
         RK_S32 roi_buf_size = vepu541_get_roi_buf_size(w, h);
+        RK_S32 idx = ctx->roi_idx;
+        RK_S32 i;
 
-        if (!ctx->roi_buf || roi_buf_size != ctx->roi_buf_size) {
-            if (NULL == ctx->roi_grp)
-                mpp_buffer_group_get_internal(&ctx->roi_grp, MPP_BUFFER_TYPE_ION);
-            else if (roi_buf_size != ctx->roi_buf_size) {
-                if (ctx->roi_buf) {
-                    mpp_buffer_put(ctx->roi_buf);
-                    ctx->roi_buf = NULL;
+        if (roi_buf_size != ctx->roi_buf_size) {
+            for (i = 0; i < H264E_ROI_BUF_CNT; i++) {
+                if (ctx->roi_bufs[i]) {
+                    mpp_buffer_put(ctx->roi_bufs[i]);
+                    ctx->roi_bufs[i] = NULL;
                 }
-                mpp_buffer_group_clear(ctx->roi_grp);
             }
 
-            mpp_assert(ctx->roi_grp);
-
-            if (NULL == ctx->roi_buf)
-                mpp_buffer_get(ctx->roi_grp, &ctx->roi_buf, roi_buf_size);
+            if (ctx->roi_grp)
+                mpp_buffer_group_clear(ctx->roi_grp);
 
             ctx->roi_buf_size = roi_buf_size;
         }
 
-        mpp_assert(ctx->roi_buf);
-        RK_S32 fd = mpp_buffer_get_fd(ctx->roi_buf);
-        void *buf = mpp_buffer_get_ptr(ctx->roi_buf);
+        if (NULL == ctx->roi_grp)
+            mpp_buffer_group_get_internal(&ctx->roi_grp, MPP_BUFFER_TYPE_ION);
+
+        mpp_assert(ctx->roi_grp);
+
+        if (NULL == ctx->roi_bufs[idx]) {
+            mpp_buffer_get(ctx->roi_grp, &ctx->roi_bufs[idx], roi_buf_size);
+            ctx->roi_caches[idx].valid = 0;
+        }
+
+        mpp_assert(ctx->roi_bufs[idx]);
+        RK_S32 fd = mpp_buffer_get_fd(ctx->roi_bufs[idx]);
+        void *buf = mpp_buffer_get_ptr(ctx->roi_bufs[idx]);
 
         regs->reg013.roi_enc = 1;
         regs->reg073.roi_addr = fd;
 
-        vepu541_set_roi(buf, roi, w, h);
+        vepu541_update_roi(&ctx->roi_caches[idx], buf, roi, w, h);
+        ctx->roi_idx = (idx + 1) % H264E_ROI_BUF_CNT;
     } else {
         regs->reg013.roi_enc = 0;
         regs->reg073.roi_addr = 0;
@@ -1531,7 +1548,7 @@ static MPP_RET hal_h264e_vepu541_wait(void *hal, HalEncTask *task)
 
     hal_h264e_dbg_func("enter %p\n", hal);
 
-    ret = mpp_dev_ioctl(ctx->dev, MPP_DEV_CMD_POLL, NULL);
+    ret = vepu541_wait(ctx->dev, task);
     if (ret) {
         mpp_err_f("poll cmd failed %d\n", ret);
         ret = MPP_ERR_VPUHW;
@@ -85,6 +85,7 @@ typedef struct H265eV541HalContext_t {
     Vepu541OsdCfg       osd_cfg;
     MppEncROICfg        *roi_data;
     void                *roi_buf;
+    Vepu541RoiCache     roi_cache;
     MppEncCfgSet        *cfg;
 
     RK_U32              enc_mode;
@@ -281,6 +282,7 @@ static MPP_RET h265e_rkv_allocate_buffers(H265eV541HalContext *ctx, H265eSyntax_
             }
         }
         ctx->roi_buf = mpp_malloc(RK_U8, vepu541_get_roi_buf_size(syn->pp.pic_width, syn->pp.pic_height));
+        ctx->roi_cache.valid = 0;
         ctx->frame_size = frame_size;
         ctx->max_buf_cnt = new_max_cnt;
     }
@@ -798,29 +800,27 @@ vepu541_h265_set_patch_info(MppDev dev, H265eSyntax_new *syn, Vepu541Fmt input_f
     return ret;
 }
 
-MPP_RET vepu541_h265_set_roi(void *dst_buf, void *src_buf, RK_S32 w, RK_S32 h)
+/* reorder 16x16 roi config of mb rows [y0, y1) from raster to ctu order */
+MPP_RET vepu541_h265_set_roi(void *dst_buf, void *src_buf, RK_S32 w, RK_S32 h,
+                             RK_S32 y0, RK_S32 y1)
 {
     Vepu541RoiCfg *src = (Vepu541RoiCfg *)src_buf;
     Vepu541RoiCfg *dst = (Vepu541RoiCfg *)dst_buf;
     RK_S32 mb_w = MPP_ALIGN(w, 64) / 64;
     RK_S32 mb_h = MPP_ALIGN(h, 64) / 64;
     RK_S32 ctu_line = mb_w;
-    RK_S32 i, j, cu16cnt;
+    RK_S32 cu16_num_line = ctu_line * 4;
+    RK_S32 i, j, cu16_y;
 
-    for (j = 0; j < mb_h; j++) {
-        for ( i = 0; i < mb_w; i++) {
+    for (j = y0 / 4; j < MPP_MIN(mb_h, (y1 + 3) / 4); j++) {
+        for (i = 0; i < mb_w; i++) {
             RK_S32 ctu_addr = j * ctu_line + i;
-            RK_S32 cu16_num_line = ctu_line * 4;
-            for ( cu16cnt = 0; cu16cnt < 16; cu16cnt++) {
-                RK_S32 cu16_x;
-                RK_S32 cu16_y;
-                RK_S32 cu16_addr_in_frame;
-                cu16_x = cu16cnt & 3;
-                cu16_y = cu16cnt / 4;
-                cu16_x += i * 4;
-                cu16_y += j * 4;
-                cu16_addr_in_frame = cu16_x + cu16_y * cu16_num_line;
-                dst[ctu_addr * 16 + cu16cnt] = src[cu16_addr_in_frame];
+
+            for (cu16_y = 0; cu16_y < 4; cu16_y++) {
+                RK_S32 cu16_addr_in_frame = i * 4 + (j * 4 + cu16_y) * cu16_num_line;
+
+                memcpy(&dst[ctu_addr * 16 + cu16_y * 4], &src[cu16_addr_in_frame],
+                       4 * sizeof(*src));
             }
         }
     }
@@ -832,6 +832,7 @@ vepu541_h265_set_roi_regs(H265eV541HalContext *ctx, H265eV541RegSet *regs)
 {
     MppEncROICfg *cfg = (MppEncROICfg*)ctx->roi_data;
     h265e_v541_buffers *bufs = (h265e_v541_buffers *)ctx->buffers;
+    Vepu541RoiCache *cache = &ctx->roi_cache;
     RK_U32 h =  ctx->cfg->prep.height;
     RK_U32 w = ctx->cfg->prep.width;
     RK_U8 *roi_base;
@@ -844,8 +845,10 @@ vepu541_h265_set_roi_regs(H265eV541HalContext *ctx, H265eV541RegSet *regs)
         regs->enc_pic.roi_en = 1;
         regs->roi_addr_hevc = mpp_buffer_get_fd(bufs->hw_roi_buf);
         roi_base = (RK_U8 *)mpp_buffer_get_ptr(bufs->hw_roi_buf);
-        vepu541_set_roi(ctx->roi_buf, cfg, w, h);
-        vepu541_h265_set_roi(roi_base, ctx->roi_buf, w, h);
+        vepu541_update_roi(cache, ctx->roi_buf, cfg, w, h);
+        if (cache->dirty_y0 < cache->dirty_y1)
+            vepu541_h265_set_roi(roi_base, ctx->roi_buf, w, h,
+                                 cache->dirty_y0, cache->dirty_y1);
     }
     return MPP_OK;
 }
@@ -1502,6 +1505,10 @@ MPP_RET hal_h265e_v540_start(void *hal, HalEncTask *enc_task)
         return MPP_NOK;
     }
 
+    /* tiles before the last one are polled here, frame goes out as a whole */
+    if (title_num > 1)
+        enc_task->slice_out = NULL;
+
     for (k = 0; k < title_num; k++) {    //v540 no support link list
         RK_U32 i;
         RK_U32 *regs = (RK_U32*)ctx->regs;
@@ -1781,7 +1788,7 @@ MPP_RET hal_h265e_v541_wait(void *hal, HalEncTask *task)
                       enc_task->flags.err);
         return MPP_NOK;
     }
-    ret = mpp_dev_ioctl(ctx->dev, MPP_DEV_CMD_POLL, NULL);
+    ret = vepu541_wait(ctx->dev, enc_task);
     if (ret)
         mpp_err_f("poll cmd failed %d status %d \n", ret, elem->hw_status);
 
@@ -18,6 +18,7 @@
 #define __MPP_H__
 
 #include "mpp_queue.h"
+#include "mpp_ptr_queue.h"
 #include "mpp_task_impl.h"
 
 #include "mpp_dec.h"
@@ -100,6 +101,8 @@ public:
     MPP_RET init(MppCtxType type, MppCodingType coding);
     MPP_RET put_packet(MppPacket packet);
     MPP_RET get_frame(MppFrame *frame);
+    MPP_RET put_packets(MppPacket *packets, RK_U32 count, RK_U32 *done);
+    MPP_RET get_frames(MppFrame *frames, RK_U32 max, RK_U32 *count);
 
     MPP_RET put_frame(MppFrame frame);
     MPP_RET get_packet(MppPacket *packet);
@@ -114,9 +117,9 @@ public:
     MPP_RET notify(RK_U32 flag);
     MPP_RET notify(MppBufferGroup group);
 
-    mpp_list        *mPackets;
-    mpp_list        *mFrames;
-    mpp_list        *mTimeStamps;
+    MppPtrQueue     *mPackets;
+    MppPtrQueue     *mFrames;
+    MppPtrQueue     *mTimeStamps;
     /* counters for debug */
     RK_U32          mPacketPutCount;
     RK_U32          mPacketGetCount;
@@ -148,6 +151,9 @@ public:
     MppPollType     mOutputTimeout;
 
     MppTask         mInputTask;
+    /* fifo of idle tasks got back by put_frame while waiting its own task */
+    MppTask         mInputTaskIdle[MPP_ENC_MAX_PIPELINE_DEPTH];
+    RK_U32          mInputTaskIdleCnt;
 
     MppDec          mDec;
     MppEnc          mEnc;
@@ -156,6 +162,9 @@ public:
 
 private:
     void clear();
+    MPP_RET wait_frame();
+    MppFrame pop_frame();
+    void kick_parser();
 
     MppCtxType      mType;
     MppCodingType   mCoding;
@@ -170,6 +179,12 @@ private:
     RK_U32          mParserNeedSplit;
     RK_U32          mParserInternalPts;     /* for MPEG2/MPEG4 */
     RK_U32          mImmediateOut;
+    RK_U32          mPipelineDepth;         /* also for encoder */
+    /* encoder split:out set before init, applied after init */
+    MppEncCfg       mEncCfg;
+    RK_U32          mDisplayDelay;
+    /* max packets queued in put_packet */
+    RK_S32          mInputQueueDepth;
     /* backup extra packet for seek */
     MppPacket       mExtraPacket;
 
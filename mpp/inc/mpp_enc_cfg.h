@@ -21,6 +21,20 @@
 #include "rk_venc_ref.h"
 #include "rc_data.h"
 
+typedef enum MppEncSplitOutCfgChange_e {
+    MPP_ENC_SPLIT_OUT_CFG_CHANGE_MODE       = (1 << 0),
+    MPP_ENC_SPLIT_OUT_CFG_CHANGE_ALL        = (0xFFFFFFFF),
+} MppEncSplitOutCfgChange;
+
+/*
+ * slice output mode from split:out key
+ * It is kept out of MppEncSliceSplit to keep the public struct unchanged.
+ */
+typedef struct MppEncSplitOutCfg_t {
+    RK_U32              change;
+    RK_U32              out_mode;   /* MppEncSplitOutMode */
+} MppEncSplitOutCfg;
+
 /*
  * MppEncCfgSet shows the relationship between different configuration
  * Due to the huge amount of configurable parameters we need to setup
@@ -37,6 +51,7 @@ typedef struct MppEncCfgSet_t {
     MppEncCodecCfg      codec;
 
     MppEncSliceSplit    split;
+    MppEncSplitOutCfg   split_out;
     MppEncRefCfg        ref_cfg;
     MppEncROICfg        roi;
     MppEncOSDPltCfg     plt_cfg;
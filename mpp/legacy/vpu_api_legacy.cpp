@@ -24,6 +24,7 @@
 #include "mpp_env.h"
 #include "mpp_time.h"
 #include "mpp_common.h"
+#include "mpp_eventfd.h"
 
 #include "vpu_api_legacy.h"
 #include "mpp_packet_impl.h"
@@ -859,8 +860,11 @@ RK_S32 VpuApiLegacy::decode_sendstream(VideoPacket_t *pkt)
     if (ret == MPP_OK) {
         pkt->size = 0;
     } else {
-        /* reduce cpu overhead here */
-        msleep(1);
+        RK_S32 fd = -1;
+
+        /* wait for free input slot instead of sleeping blindly */
+        if (MPP_OK == mpi->control(mpp_ctx, MPP_GET_INPUT_EVENTFD, &fd))
+            mpp_eventfd_poll(fd, 1);
     }
 
     mpp_packet_deinit(&mpkt);
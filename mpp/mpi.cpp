@@ -189,6 +189,56 @@ static MPP_RET mpi_decode_get_frame(MppCtx ctx, MppFrame *frame)
     return ret;
 }
 
+static MPP_RET mpi_decode_put_packets(MppCtx ctx, MppPacket *packets, RK_U32 count,
+                                      RK_U32 *done)
+{
+    MPP_RET ret = MPP_NOK;
+    MpiImpl *p = (MpiImpl *)ctx;
+
+    mpi_dbg_func("enter ctx %p packets %p count %d\n", ctx, packets, count);
+    do {
+        ret = check_mpp_ctx(p);
+        if (ret)
+            break;
+
+        if (NULL == packets && count) {
+            mpp_err_f("found NULL input packets\n");
+            ret = MPP_ERR_NULL_PTR;
+            break;
+        }
+
+        ret = p->ctx->put_packets(packets, count, done);
+    } while (0);
+
+    mpi_dbg_func("leave ret %d\n", ret);
+    return ret;
+}
+
+static MPP_RET mpi_decode_get_frames(MppCtx ctx, MppFrame *frames, RK_U32 max,
+                                     RK_U32 *count)
+{
+    MPP_RET ret = MPP_NOK;
+    MpiImpl *p = (MpiImpl *)ctx;
+
+    mpi_dbg_func("enter ctx %p frames %p max %d\n", ctx, frames, max);
+    do {
+        ret = check_mpp_ctx(p);
+        if (ret)
+            break;
+
+        if (NULL == frames || NULL == count) {
+            mpp_err_f("found NULL input frames %p count %p\n", frames, count);
+            ret = MPP_ERR_NULL_PTR;
+            break;
+        }
+
+        ret = p->ctx->get_frames(frames, max, count);
+    } while (0);
+
+    mpi_dbg_func("leave ret %d\n", ret);
+    return ret;
+}
+
 static MPP_RET mpi_encode(MppCtx ctx, MppFrame frame, MppPacket *packet)
 {
     MPP_RET ret = MPP_NOK;
@@ -421,6 +471,8 @@ static MppApi mpp_api = {
     mpi_enqueue,
     mpi_reset,
     mpi_control,
+    mpi_decode_put_packets,
+    mpi_decode_get_frames,
     {0},
 };
 
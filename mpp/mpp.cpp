@@ -17,6 +17,7 @@
 #define  MODULE_TAG "mpp"
 
 #include <errno.h>
+#include <string.h>
 
 #include "rk_mpi.h"
 
@@ -33,6 +34,7 @@
 #include "mpp_buffer_impl.h"
 #include "mpp_frame_impl.h"
 #include "mpp_packet_impl.h"
+#include "mpp_enc_cfg_impl.h"
 
 #define MPP_TEST_FRAME_SIZE     SZ_1M
 #define MPP_TEST_PACKET_SIZE    SZ_512K
@@ -76,6 +78,7 @@ Mpp::Mpp()
       mInputTimeout(MPP_POLL_BUTT),
       mOutputTimeout(MPP_POLL_BUTT),
       mInputTask(NULL),
+      mInputTaskIdleCnt(0),
       mDec(NULL),
       mEnc(NULL),
       mEncVersion(0),
@@ -88,11 +91,16 @@ Mpp::Mpp()
       mParserNeedSplit(0),
       mParserInternalPts(0),
       mImmediateOut(0),
+      mPipelineDepth(0),
+      mEncCfg(NULL),
+      mDisplayDelay(MPP_DEC_DEFAULT_DISPLAY_DELAY),
+      mInputQueueDepth(4),
       mExtraPacket(NULL),
       mDump(NULL)
 {
     mpp_env_get_u32("mpp_debug", &mpp_debug, 0);
     mpp_dump_init(&mDump);
+    memset(mInputTaskIdle, 0, sizeof(mInputTaskIdle));
 }
 
 MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
@@ -114,9 +122,10 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
 
     switch (mType) {
     case MPP_CTX_DEC : {
-        mPackets    = new mpp_list(list_wraper_packet);
-        mFrames     = new mpp_list(list_wraper_frame);
-        mTimeStamps = new mpp_list(list_wraper_packet);
+        mPackets    = new MppPtrQueue(list_wraper_packet);
+        mFrames     = new MppPtrQueue(list_wraper_frame);
+        mTimeStamps = new MppPtrQueue(list_wraper_packet);
+        mPackets->set_limit(mInputQueueDepth);
 
         if (mInputTimeout == MPP_POLL_BUTT)
             mInputTimeout = MPP_POLL_NON_BLOCK;
@@ -126,7 +135,9 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
 
         if (mCoding != MPP_VIDEO_CodingMJPEG) {
             mpp_buffer_group_get_internal(&mPacketGroup, MPP_BUFFER_TYPE_ION);
-            mpp_buffer_group_limit_config(mPacketGroup, 0, 3);
+            /* one packet buffer for each hal task of the deepest pipeline */
+            mpp_buffer_group_limit_config(mPacketGroup, 0,
+                                          MPP_DEC_MAX_PIPELINE_DEPTH + 1);
 
             mpp_task_queue_setup(mInputTaskQueue, 4);
             mpp_task_queue_setup(mOutputTaskQueue, 4);
@@ -144,6 +155,8 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
             mParserNeedSplit,
             mParserInternalPts,
             mImmediateOut,
+            mDisplayDelay,
+            mPipelineDepth,
             this,
         };
 
@@ -156,8 +169,8 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
         mInitDone = 1;
     } break;
     case MPP_CTX_ENC : {
-        mFrames     = new mpp_list(NULL);
-        mPackets    = new mpp_list(list_wraper_packet);
+        mFrames     = new MppPtrQueue(NULL);
+        mPackets    = new MppPtrQueue(list_wraper_packet);
 
         if (mInputTimeout == MPP_POLL_BUTT)
             mInputTimeout = MPP_POLL_BLOCK;
@@ -168,14 +181,36 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
         mpp_buffer_group_get_internal(&mPacketGroup, MPP_BUFFER_TYPE_ION);
         mpp_buffer_group_get_internal(&mFrameGroup, MPP_BUFFER_TYPE_ION);
 
-        mpp_task_queue_setup(mInputTaskQueue, 1);
-        mpp_task_queue_setup(mOutputTaskQueue, 1);
+        /* depth from MPP_ENC_SET_PIPELINE_DEPTH wins, env is only the default */
+        if (!mPipelineDepth)
+            mpp_env_get_u32("mpp_enc_pipeline_depth", &mPipelineDepth, 0);
+
+        /* low delay output returns partitions on spare output tasks */
+        RK_U32 split_out = 0;
+        RK_U32 partition_task_cnt = 0;
+
+        if (mEncCfg)
+            mpp_enc_cfg_get_u32(mEncCfg, "split:out", &split_out);
+        if (split_out & MPP_ENC_SPLIT_OUT_LOWDELAY)
+            partition_task_cnt = MPP_ENC_PARTITION_TASK_CNT;
+
+        /* pipelined encoder holds one more task on hardware */
+        if (mPipelineDepth > 1) {
+            mpp_task_queue_setup(mInputTaskQueue, MPP_ENC_MAX_PIPELINE_DEPTH);
+            mpp_task_queue_setup(mOutputTaskQueue, MPP_ENC_MAX_PIPELINE_DEPTH +
+                                 partition_task_cnt);
+        } else {
+            mpp_task_queue_setup(mInputTaskQueue, 1);
+            mpp_task_queue_setup(mOutputTaskQueue, 1 + partition_task_cnt);
+        }
 
         mInputPort  = mpp_task_queue_get_port(mInputTaskQueue,  MPP_PORT_INPUT);
         mOutputPort = mpp_task_queue_get_port(mOutputTaskQueue, MPP_PORT_OUTPUT);
 
         MppEncInitCfg cfg = {
             coding,
+            mPipelineDepth,
+            partition_task_cnt,
             this,
         };
 
@@ -185,6 +220,13 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
         ret = mpp_enc_start_v2(mEnc);
         if (ret)
             break;
+        if (mEncCfg) {
+            ret = mpp_enc_control_v2(mEnc, MPP_ENC_SET_CFG, mEncCfg);
+            mpp_enc_cfg_deinit(mEncCfg);
+            mEncCfg = NULL;
+            if (ret)
+                break;
+        }
         mInitDone = 1;
     } break;
     default : {
@@ -227,6 +269,11 @@ void Mpp::clear()
         }
     }
 
+    if (mEncCfg) {
+        mpp_enc_cfg_deinit(mEncCfg);
+        mEncCfg = NULL;
+    }
+
     if (mInputTaskQueue) {
         mpp_task_queue_deinit(mInputTaskQueue);
         mInputTaskQueue = NULL;
@@ -270,35 +317,123 @@ void Mpp::clear()
 
 MPP_RET Mpp::put_packet(MppPacket packet)
 {
+    return put_packets(&packet, 1, NULL);
+}
+
+MPP_RET Mpp::put_packets(MppPacket *packets, RK_U32 count, RK_U32 *done)
+{
+    MPP_RET ret = MPP_OK;
+    RK_U32 i;
+
+    if (done)
+        *done = 0;
+
     if (!mInitDone)
         return MPP_ERR_INIT;
 
     AutoMutex autoLock(mPackets->mutex());
     if (mExtraPacket) {
-        mPackets->add_at_tail(&mExtraPacket, sizeof(mExtraPacket));
+        mPackets->push(mExtraPacket);
         mExtraPacket = NULL;
         mPacketPutCount++;
     }
 
-    RK_U32 eos = mpp_packet_get_eos(packet);
-    if (mPackets->list_size() < 4 || eos) {
+    for (i = 0; i < count; i++) {
+        MppPacket packet = packets[i];
+        RK_U32 eos = mpp_packet_get_eos(packet);
         MppPacket pkt;
-        if (MPP_OK != mpp_packet_copy_init(&pkt, packet))
-            return MPP_NOK;
 
-        mPackets->add_at_tail(&pkt, sizeof(pkt));
+        if (mPackets->list_size() >= mPackets->get_limit() && !eos) {
+            ret = MPP_ERR_BUFFER_FULL;
+            break;
+        }
+
+        /*
+         * NOTE: packet with user lent memory is not copied here. The release
+         * callback will be called after parser has consumed the packet.
+         */
+        if (MPP_OK != mpp_packet_move_init(&pkt, packet)) {
+            ret = MPP_NOK;
+            break;
+        }
+
+        mPackets->push(pkt);
         mPacketPutCount++;
         // dump input packet
         mpp_ops_dec_put_pkt(mDump, packet);
 
         // when packet has been send clear the length
         mpp_packet_set_length(packet, 0);
+    }
 
+    if (done)
+        *done = i;
+
+    /* one wake up for the whole batch */
+    if (i)
         notify(MPP_INPUT_ENQUEUE);
+
+    return ret;
+}
+
+/* NOTE: caller should hold mFrames lock */
+MPP_RET Mpp::wait_frame()
+{
+    if (mFrames->list_size() || !mOutputTimeout)
         return MPP_OK;
+
+    if (mOutputTimeout < 0) {
+        /* block wait */
+        mFrames->wait();
+    } else {
+        RK_S32 ret = mFrames->wait(mOutputTimeout);
+        if (ret) {
+            if (ret == ETIMEDOUT)
+                return MPP_ERR_TIMEOUT;
+            else
+                return MPP_NOK;
+        }
     }
 
-    return MPP_ERR_BUFFER_FULL;
+    return MPP_OK;
+}
+
+void Mpp::kick_parser()
+{
+    // NOTE: Add signal here is not efficient
+    // This is for fix bug of stucking on decoder parser thread
+    // When decoder parser thread is block by info change and enter waiting.
+    // There is no way to wake up parser thread to continue decoding.
+    // The put_packet only signal sem on may be it better to use sem on info
+    // change too.
+    AutoMutex autoPacketLock(mPackets->mutex());
+    if (mPackets->list_size())
+        notify(MPP_INPUT_ENQUEUE);
+}
+
+/* NOTE: caller should hold mFrames lock */
+MppFrame Mpp::pop_frame()
+{
+    MppFrame first = NULL;
+
+    if (!mFrames->list_size())
+        return NULL;
+
+    mFrames->pop(&first);
+    mFrameGetCount++;
+
+    if (mMultiFrame) {
+        MppFrame prev = first;
+        MppFrame next = NULL;
+        while (mFrames->list_size()) {
+            mFrames->pop(&next);
+            mFrameGetCount++;
+            mpp_frame_set_next(prev, next);
+            prev = next;
+        }
+    }
+
+    return first;
 }
 
 MPP_RET Mpp::get_frame(MppFrame *frame)
@@ -308,54 +443,17 @@ MPP_RET Mpp::get_frame(MppFrame *frame)
 
     AutoMutex autoFrameLock(mFrames->mutex());
     MppFrame first = NULL;
+    /* NOTE: non-block user should wait on MPP_GET_OUTPUT_EVENTFD */
+    MPP_RET ret = wait_frame();
 
-    if (0 == mFrames->list_size()) {
-        if (mOutputTimeout) {
-            if (mOutputTimeout < 0) {
-                /* block wait */
-                mFrames->wait();
-            } else {
-                RK_S32 ret = mFrames->wait(mOutputTimeout);
-                if (ret) {
-                    if (ret == ETIMEDOUT)
-                        return MPP_ERR_TIMEOUT;
-                    else
-                        return MPP_NOK;
-                }
-            }
-        } else {
-            /* NOTE: in non-block mode the sleep is to avoid user's dead loop */
-            msleep(1);
-        }
-    }
+    if (ret)
+        return ret;
 
-    if (mFrames->list_size()) {
-        mFrames->del_at_head(&first, sizeof(frame));
-        mFrameGetCount++;
+    first = pop_frame();
+    if (first)
         notify(MPP_OUTPUT_DEQUEUE);
-
-        if (mMultiFrame) {
-            MppFrame prev = first;
-            MppFrame next = NULL;
-            while (mFrames->list_size()) {
-                mFrames->del_at_head(&next, sizeof(frame));
-                mFrameGetCount++;
-                notify(MPP_OUTPUT_DEQUEUE);
-                mpp_frame_set_next(prev, next);
-                prev = next;
-            }
-        }
-    } else {
-        // NOTE: Add signal here is not efficient
-        // This is for fix bug of stucking on decoder parser thread
-        // When decoder parser thread is block by info change and enter waiting.
-        // There is no way to wake up parser thread to continue decoding.
-        // The put_packet only signal sem on may be it better to use sem on info
-        // change too.
-        AutoMutex autoPacketLock(mPackets->mutex());
-        if (mPackets->list_size())
-            notify(MPP_INPUT_ENQUEUE);
-    }
+    else
+        kick_parser();
 
     *frame = first;
 
@@ -365,12 +463,61 @@ MPP_RET Mpp::get_frame(MppFrame *frame)
     return MPP_OK;
 }
 
+MPP_RET Mpp::get_frames(MppFrame *frames, RK_U32 max, RK_U32 *count)
+{
+    RK_U32 cnt = 0;
+
+    *count = 0;
+
+    if (!mInitDone)
+        return MPP_ERR_INIT;
+
+    AutoMutex autoFrameLock(mFrames->mutex());
+    MPP_RET ret = wait_frame();
+
+    if (ret)
+        return ret;
+
+    while (cnt < max) {
+        MppFrame frame = pop_frame();
+
+        if (NULL == frame)
+            break;
+
+        frames[cnt++] = frame;
+        // dump output
+        mpp_ops_dec_get_frm(mDump, frame);
+
+        /* caller should handle info change and eos before the later frames */
+        if (mpp_frame_get_info_change(frame) || mpp_frame_get_eos(frame))
+            break;
+    }
+
+    if (cnt)
+        notify(MPP_OUTPUT_DEQUEUE);
+    else
+        kick_parser();
+
+    *count = cnt;
+
+    return MPP_OK;
+}
+
 MPP_RET Mpp::put_frame(MppFrame frame)
 {
     if (!mInitDone)
         return MPP_ERR_INIT;
 
     MPP_RET ret = MPP_NOK;
+    MppTask task = NULL;
+
+    /* reuse idle task got back before polling the port */
+    if (mInputTask == NULL && mInputTaskIdleCnt) {
+        mInputTask = mInputTaskIdle[0];
+        mInputTaskIdleCnt--;
+        memmove(mInputTaskIdle, mInputTaskIdle + 1,
+                sizeof(mInputTaskIdle[0]) * mInputTaskIdleCnt);
+    }
 
     if (mInputTask == NULL) {
         /* poll input port for valid task */
@@ -421,22 +568,45 @@ MPP_RET Mpp::put_frame(MppFrame frame)
         goto RET;
     }
 
+    task = mInputTask;
     mInputTask = NULL;
-    /* wait enqueued task finished */
-    ret = poll(MPP_PORT_INPUT, mInputTimeout);
-    if (ret) {
-        mpp_log_f("poll on get timeout %d ret %d\n", mInputTimeout, ret);
-        goto RET;
-    }
+    /*
+     * wait enqueued task finished. The frame belongs to caller after return
+     * so the task has to come back even when the encoder has another idle task.
+     */
+    while (1) {
+        MppTask done = NULL;
 
-    /* get previous enqueued task back */
-    ret = dequeue(MPP_PORT_INPUT, &mInputTask);
-    if (ret) {
-        mpp_log_f("dequeue on get ret %d\n", ret);
-        goto RET;
+        ret = poll(MPP_PORT_INPUT, mInputTimeout);
+        if (ret) {
+            mpp_log_f("poll on get timeout %d ret %d\n", mInputTimeout, ret);
+            goto RET;
+        }
+
+        /* get previous enqueued task back */
+        ret = dequeue(MPP_PORT_INPUT, &done);
+        if (ret) {
+            mpp_log_f("dequeue on get ret %d\n", ret);
+            goto RET;
+        }
+
+        mpp_assert(done);
+        if (done == task)
+            break;
+
+        /*
+         * idle task of pipelined encoder or task of a timed out put_frame,
+         * kept for the next put_frame. Queue has no more tasks than fifo.
+         */
+        if (mInputTaskIdleCnt >= MPP_ARRAY_ELEMS(mInputTaskIdle)) {
+            mpp_err_f("too many idle task %d\n", mInputTaskIdleCnt);
+            ret = MPP_NOK;
+            goto RET;
+        }
+        mInputTaskIdle[mInputTaskIdleCnt++] = done;
     }
 
-    mpp_assert(mInputTask);
+    mInputTask = task;
 
 RET:
     return ret;
@@ -602,7 +772,7 @@ MPP_RET Mpp::control(MpiCmd cmd, MppParam param)
             ret = control_dec(cmd, param);
         } break;
         case CMD_CTX_ID_ENC : {
-            mpp_assert(mType == MPP_CTX_ENC);
+            mpp_assert(mType == MPP_CTX_ENC || mType == MPP_CTX_BUTT);
             mpp_assert(cmd > MPP_ENC_CMD_BASE);
             mpp_assert(cmd < MPP_ENC_CMD_END);
 
@@ -648,7 +818,7 @@ MPP_RET Mpp::reset()
         mPackets->lock();
         while (mPackets->list_size()) {
             MppPacket pkt = NULL;
-            mPackets->del_at_head(&pkt, sizeof(pkt));
+            mPackets->pop(&pkt);
             mPacketGetCount++;
 
             RK_U32 flags = mpp_packet_get_flag(pkt);
@@ -726,6 +896,48 @@ MPP_RET Mpp::control_mpp(MpiCmd cmd, MppParam param)
             mOutputTimeout = timeout;
     } break;
 
+    case MPP_SET_INPUT_QUEUE_DEPTH: {
+        RK_S32 depth = (param) ? *((RK_S32 *)param) : 0;
+
+        if (depth <= 0) {
+            mpp_err("invalid input queue depth %d\n", depth);
+            ret = MPP_ERR_VALUE;
+            break;
+        }
+
+        mInputQueueDepth = depth;
+        if (mPackets && mType == MPP_CTX_DEC) {
+            AutoMutex autoLock(mPackets->mutex());
+            mPackets->set_limit(depth);
+        }
+    } break;
+
+    case MPP_GET_INPUT_EVENTFD:
+    case MPP_GET_OUTPUT_EVENTFD: {
+        MppPtrQueue *queue = (cmd == MPP_GET_INPUT_EVENTFD) ? mPackets : mFrames;
+        RK_S32 fd = -1;
+
+        if (NULL == param) {
+            ret = MPP_ERR_NULL_PTR;
+            break;
+        }
+
+        if (mType != MPP_CTX_DEC || NULL == queue) {
+            mpp_err("eventfd is only available on initialized decoder\n");
+            ret = MPP_NOK;
+            break;
+        }
+
+        {
+            AutoMutex autoLock(queue->mutex());
+            fd = (cmd == MPP_GET_INPUT_EVENTFD) ? queue->get_wr_fd() : queue->get_rd_fd();
+        }
+
+        *((RK_S32 *)param) = fd;
+        if (fd < 0)
+            ret = MPP_NOK;
+    } break;
+
     default : {
         ret = MPP_NOK;
     } break;
@@ -809,6 +1021,14 @@ MPP_RET Mpp::control_dec(MpiCmd cmd, MppParam param)
         mParserFastMode = flag;
         ret = MPP_OK;
     } break;
+    case MPP_DEC_SET_DISPLAY_DELAY: {
+        mDisplayDelay = *((RK_U32 *)param);
+        ret = MPP_OK;
+    } break;
+    case MPP_DEC_SET_PIPELINE_DEPTH: {
+        mPipelineDepth = *((RK_U32 *)param);
+        ret = MPP_OK;
+    } break;
     case MPP_DEC_GET_STREAM_COUNT: {
         AutoMutex autoLock(mPackets->mutex());
         *((RK_S32 *)param) = mPackets->list_size();
@@ -836,6 +1056,50 @@ MPP_RET Mpp::control_dec(MpiCmd cmd, MppParam param)
 
 MPP_RET Mpp::control_enc(MpiCmd cmd, MppParam param)
 {
+    /* task queue size depends on pipeline depth so it is taken before init */
+    if (cmd == MPP_ENC_SET_PIPELINE_DEPTH) {
+        if (mInitDone) {
+            mpp_err("pipeline depth should be set before init\n");
+            return MPP_ERR_INIT;
+        }
+
+        mPipelineDepth = *((RK_U32 *)param);
+        return MPP_OK;
+    }
+
+    /*
+     * split:out before init decides the partition tasks. It is the only cfg
+     * taken before init, it is kept and applied after init.
+     */
+    if (cmd == MPP_ENC_SET_CFG && !mInitDone) {
+        MppEncCfgImpl *src = (MppEncCfgImpl *)param;
+        MppEncCfgSet *cfg = NULL;
+
+        if (NULL == src)
+            return MPP_ERR_NULL_PTR;
+
+        cfg = &src->cfg;
+        if (cfg->prep.change || cfg->rc.change || cfg->codec.change ||
+            cfg->split.change) {
+            mpp_err("only split:out can be set before init\n");
+            return MPP_ERR_VALUE;
+        }
+
+        if (cfg->split_out.change & MPP_ENC_SPLIT_OUT_CFG_CHANGE_MODE) {
+            MppEncSplitOutCfg *dst = NULL;
+
+            if (NULL == mEncCfg && mpp_enc_cfg_init(&mEncCfg))
+                return MPP_ERR_MALLOC;
+
+            dst = &((MppEncCfgImpl *)mEncCfg)->cfg.split_out;
+            dst->out_mode = cfg->split_out.out_mode;
+            dst->change |= MPP_ENC_SPLIT_OUT_CFG_CHANGE_MODE;
+        }
+        cfg->split_out.change = 0;
+
+        return MPP_OK;
+    }
+
     mpp_assert(mEnc);
     return mpp_enc_control_v2(mEnc, cmd, param);
 }
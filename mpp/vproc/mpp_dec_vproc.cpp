@@ -74,7 +74,7 @@ typedef struct MppDecVprocCtxImpl_t {
 
 static void dec_vproc_put_frame(Mpp *mpp, MppFrame frame, MppBuffer buf, RK_S64 pts)
 {
-    mpp_list *list = mpp->mFrames;
+    MppPtrQueue *list = mpp->mFrames;
     MppFrame out = NULL;
     MppFrameImpl *impl = NULL;
 
@@ -87,7 +87,7 @@ static void dec_vproc_put_frame(Mpp *mpp, MppFrame frame, MppBuffer buf, RK_S64
         impl->buffer = buf;
 
     list->lock();
-    list->add_at_tail(&out, sizeof(out));
+    list->push(out);
 
     if (mpp_debug & MPP_DBG_PTS)
         mpp_log("output frame pts %lld\n", mpp_frame_get_pts(out));
@@ -0,0 +1,284 @@
+/*
+ * Copyright 2020 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_dma_heap"
+
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+
+#include "os_mem.h"
+#include "allocator_dma_heap.h"
+
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_log.h"
+#include "mpp_common.h"
+
+static RK_U32 dma_heap_debug = 0;
+
+#define DMA_HEAP_FUNCTION           (0x00000001)
+#define DMA_HEAP_DEVICE             (0x00000002)
+#define DMA_HEAP_IOCTL              (0x00000004)
+
+#define dma_heap_dbg(flag, fmt, ...)    _mpp_dbg_f(dma_heap_debug, flag, fmt, ## __VA_ARGS__)
+#define dma_heap_dbg_func(fmt, ...)     dma_heap_dbg(DMA_HEAP_FUNCTION, fmt, ## __VA_ARGS__)
+
+/* from linux/dma-heap.h for toolchain without it */
+typedef struct DmaHeapAllocData_t {
+    RK_U64  len;
+    RK_U32  fd;
+    RK_U32  fd_flags;
+    RK_U64  heap_flags;
+} DmaHeapAllocData;
+
+#define DMA_HEAP_IOC_MAGIC          'H'
+#define DMA_HEAP_IOCTL_ALLOC        _IOWR(DMA_HEAP_IOC_MAGIC, 0x0, DmaHeapAllocData)
+
+#define DMA_HEAP_FLAGS_CONTIG       (MPP_BUFFER_FLAGS_CONTIG >> 16)
+#define DMA_HEAP_FLAGS_CACHABLE     (MPP_BUFFER_FLAGS_CACHABLE >> 16)
+
+typedef struct {
+    RK_U32  alignment;
+    RK_S32  device;
+    RK_U32  flags;
+} allocator_ctx_dma_heap;
+
+static const char *dev_dma_heap = "/dev/dma_heap";
+
+/*
+ * Heap candidates in order of preference. Mainline kernel only has the cached
+ * system heap. Rockchip kernel also has uncached and cma heaps. Non-cachable
+ * request never takes a cached heap, open fails and the allocator fails over
+ * to drm / ion. Cachable contiguous request falls back to the system heap.
+ */
+static const char *heap_normal[] = {
+    "system-uncached", NULL,
+};
+
+static const char *heap_cachable[] = {
+    "system", NULL,
+};
+
+static const char *heap_contig[] = {
+    "cma-uncached", NULL,
+};
+
+static const char *heap_contig_cachable[] = {
+    "cma", "linux,cma", "system", NULL,
+};
+
+static int dma_heap_ioctl(int fd, int req, void *arg)
+{
+    int ret;
+
+    do {
+        ret = ioctl(fd, req, arg);
+    } while (ret == -1 && (errno == EINTR || errno == EAGAIN));
+
+    dma_heap_dbg(DMA_HEAP_IOCTL, "dma_heap_ioctl %x with code %d: %s\n", req,
+                 ret, strerror(errno));
+
+    return ret;
+}
+
+static MPP_RET os_allocator_dma_heap_open(void **ctx, MppAllocatorCfg *cfg)
+{
+    const char **names = heap_normal;
+    allocator_ctx_dma_heap *p;
+    char path[64];
+    RK_S32 fd = -1;
+
+    if (NULL == ctx) {
+        mpp_err_f("does not accept NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    *ctx = NULL;
+
+    mpp_env_get_u32("dma_heap_debug", &dma_heap_debug, 0);
+
+    if (cfg->flags & DMA_HEAP_FLAGS_CONTIG)
+        names = (cfg->flags & DMA_HEAP_FLAGS_CACHABLE) ?
+                heap_contig_cachable : heap_contig;
+    else if (cfg->flags & DMA_HEAP_FLAGS_CACHABLE)
+        names = heap_cachable;
+
+    for (; *names; names++) {
+        snprintf(path, sizeof(path), "%s/%s", dev_dma_heap, *names);
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd >= 0)
+            break;
+    }
+
+    if (fd < 0) {
+        dma_heap_dbg(DMA_HEAP_DEVICE, "no dma heap found for flags %x\n", cfg->flags);
+        return MPP_ERR_UNKNOW;
+    }
+
+    dma_heap_dbg(DMA_HEAP_DEVICE, "open %s fd %d\n", path, fd);
+
+    p = mpp_malloc(allocator_ctx_dma_heap, 1);
+    if (NULL == p) {
+        close(fd);
+        mpp_err_f("failed to allocate context\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    p->alignment    = cfg->alignment;
+    p->flags        = cfg->flags;
+    p->device       = fd;
+    *ctx = p;
+
+    return MPP_OK;
+}
+
+static MPP_RET os_allocator_dma_heap_alloc(void *ctx, MppBufferInfo *info)
+{
+    allocator_ctx_dma_heap *p = (allocator_ctx_dma_heap *)ctx;
+    DmaHeapAllocData data;
+
+    if (NULL == ctx) {
+        mpp_err_f("does not accept NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    memset(&data, 0, sizeof(data));
+    data.len = MPP_ALIGN(info->size, p->alignment);
+    data.fd_flags = O_RDWR | O_CLOEXEC;
+
+    if (dma_heap_ioctl(p->device, DMA_HEAP_IOCTL_ALLOC, &data)) {
+        mpp_err_f("dev %d alloc size %d failed %s\n", p->device, info->size,
+                  strerror(errno));
+        return MPP_ERR_MALLOC;
+    }
+
+    info->fd = data.fd;
+    info->ptr = NULL;
+    info->hnd = NULL;
+
+    dma_heap_dbg_func("dev %d alloc size %d fd %d\n", p->device, info->size,
+                      info->fd);
+
+    return MPP_OK;
+}
+
+static MPP_RET os_allocator_dma_heap_import(void *ctx, MppBufferInfo *info)
+{
+    allocator_ctx_dma_heap *p = (allocator_ctx_dma_heap *)ctx;
+    RK_S32 fd;
+
+    if (NULL == ctx || info->fd < 0) {
+        mpp_err_f("invalid input ctx %p fd %d\n", ctx, info->fd);
+        return MPP_ERR_VALUE;
+    }
+
+    /* keep own fd so the buffer lives after user closes its fd */
+    fd = dup(info->fd);
+    if (fd < 0) {
+        mpp_err_f("dev %d dup fd %d failed %s\n", p->device, info->fd,
+                  strerror(errno));
+        return MPP_NOK;
+    }
+
+    dma_heap_dbg_func("dev %d import fd %d to %d\n", p->device, info->fd, fd);
+
+    info->fd = fd;
+    info->ptr = NULL;
+    info->hnd = NULL;
+
+    return MPP_OK;
+}
+
+static MPP_RET os_allocator_dma_heap_free(void *ctx, MppBufferInfo *info)
+{
+    if (NULL == ctx) {
+        mpp_err_f("does not accept NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    dma_heap_dbg_func("unmap %p size %d fd %d\n", info->ptr, info->size,
+                      info->fd);
+
+    if (info->ptr) {
+        munmap(info->ptr, info->size);
+        info->ptr = NULL;
+    }
+
+    if (info->fd >= 0)
+        close(info->fd);
+
+    info->fd = -1;
+
+    return MPP_OK;
+}
+
+static MPP_RET os_allocator_dma_heap_mmap(void *ctx, MppBufferInfo *info)
+{
+    void *ptr;
+
+    if (NULL == ctx) {
+        mpp_err_f("does not accept NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    if (info->ptr)
+        return MPP_OK;
+
+    ptr = mmap(NULL, info->size, PROT_READ | PROT_WRITE, MAP_SHARED,
+               info->fd, 0);
+    if (ptr == MAP_FAILED) {
+        mpp_err_f("fd %d mmap failed %s\n", info->fd, strerror(errno));
+        return MPP_ERR_NULL_PTR;
+    }
+
+    info->ptr = ptr;
+
+    dma_heap_dbg_func("fd %d mmap to %p\n", info->fd, info->ptr);
+
+    return MPP_OK;
+}
+
+static MPP_RET os_allocator_dma_heap_close(void *ctx)
+{
+    allocator_ctx_dma_heap *p = (allocator_ctx_dma_heap *)ctx;
+
+    if (NULL == ctx) {
+        mpp_err_f("does not accept NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    dma_heap_dbg(DMA_HEAP_DEVICE, "close fd %d\n", p->device);
+
+    close(p->device);
+    mpp_free(p);
+
+    return MPP_OK;
+}
+
+os_allocator allocator_dma_heap = {
+    .type = MPP_BUFFER_TYPE_DMA_HEAP,
+    .open = os_allocator_dma_heap_open,
+    .close = os_allocator_dma_heap_close,
+    .alloc = os_allocator_dma_heap_alloc,
+    .free = os_allocator_dma_heap_free,
+    .import = os_allocator_dma_heap_import,
+    .release = os_allocator_dma_heap_free,
+    .mmap = os_allocator_dma_heap_mmap,
+};
@@ -0,0 +1,222 @@
+/*
+ * Copyright 2020 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_memfd"
+
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "allocator_memfd.h"
+
+#include "mpp_mem.h"
+#include "mpp_log.h"
+#include "mpp_atomic.h"
+#include "mpp_common.h"
+
+/* from linux/memfd.h for toolchain without it */
+#define MEMFD_FLAG_CLOEXEC      0x0001U
+
+/* register only carries 10bit fd */
+#define MEMFD_FD_MAX            1024
+
+/* bitmap of fds held by memfd buffers */
+static RK_U32 memfd_fds[MEMFD_FD_MAX / 32];
+
+typedef struct {
+    size_t  alignment;
+} allocator_ctx_memfd;
+
+static RK_S32 memfd_get(void)
+{
+#ifdef __NR_memfd_create
+    return syscall(__NR_memfd_create, "mpp_memfd", MEMFD_FLAG_CLOEXEC);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+static void memfd_fd_mark(RK_S32 fd, RK_U32 used)
+{
+    RK_U32 bit;
+
+    if (fd < 0 || fd >= MEMFD_FD_MAX)
+        return;
+
+    bit = 1U << (fd & 31);
+    if (used)
+        MPP_FETCH_OR(&memfd_fds[fd >> 5], bit);
+    else
+        MPP_FETCH_AND(&memfd_fds[fd >> 5], ~bit);
+}
+
+RK_U32 allocator_memfd_has_fd(RK_S32 fd)
+{
+    if (fd < 0 || fd >= MEMFD_FD_MAX)
+        return 0;
+
+    return (MPP_FETCH_OR(&memfd_fds[fd >> 5], 0) >> (fd & 31)) & 1;
+}
+
+static MPP_RET allocator_memfd_open(void **ctx, MppAllocatorCfg *cfg)
+{
+    allocator_ctx_memfd *p;
+
+    if (NULL == ctx) {
+        mpp_err_f("does not accept NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    p = mpp_malloc(allocator_ctx_memfd, 1);
+    if (NULL == p) {
+        *ctx = NULL;
+        mpp_err_f("failed to allocate context\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    p->alignment = cfg->alignment;
+    *ctx = p;
+
+    return MPP_OK;
+}
+
+static MPP_RET allocator_memfd_alloc(void *ctx, MppBufferInfo *info)
+{
+    allocator_ctx_memfd *p = (allocator_ctx_memfd *)ctx;
+    RK_S32 fd;
+
+    if (NULL == ctx) {
+        mpp_err_f("does not accept NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    fd = memfd_get();
+    if (fd < 0) {
+        mpp_err_f("memfd create failed %s\n", strerror(errno));
+        return MPP_ERR_MALLOC;
+    }
+
+    /* new memfd pages read as zero */
+    if (ftruncate(fd, MPP_ALIGN(info->size, p->alignment))) {
+        mpp_err_f("fd %d resize to %d failed %s\n", fd, info->size,
+                  strerror(errno));
+        close(fd);
+        return MPP_ERR_MALLOC;
+    }
+
+    memfd_fd_mark(fd, 1);
+    info->fd = fd;
+    info->ptr = NULL;
+    info->hnd = NULL;
+
+    return MPP_OK;
+}
+
+static MPP_RET allocator_memfd_import(void *ctx, MppBufferInfo *info)
+{
+    RK_S32 fd;
+
+    if (NULL == ctx || info->fd < 0) {
+        mpp_err_f("invalid input ctx %p fd %d\n", ctx, info->fd);
+        return MPP_ERR_VALUE;
+    }
+
+    fd = dup(info->fd);
+    if (fd < 0) {
+        mpp_err_f("dup fd %d failed %s\n", info->fd, strerror(errno));
+        return MPP_NOK;
+    }
+
+    memfd_fd_mark(fd, 1);
+    info->fd = fd;
+    info->ptr = NULL;
+    info->hnd = NULL;
+
+    return MPP_OK;
+}
+
+static MPP_RET allocator_memfd_free(void *ctx, MppBufferInfo *info)
+{
+    if (NULL == ctx) {
+        mpp_err_f("does not accept NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    if (info->ptr) {
+        munmap(info->ptr, info->size);
+        info->ptr = NULL;
+    }
+
+    if (info->fd >= 0) {
+        memfd_fd_mark(info->fd, 0);
+        close(info->fd);
+    }
+
+    info->fd = -1;
+
+    return MPP_OK;
+}
+
+static MPP_RET allocator_memfd_mmap(void *ctx, MppBufferInfo *info)
+{
+    void *ptr;
+
+    if (NULL == ctx) {
+        mpp_err_f("does not accept NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    if (info->ptr)
+        return MPP_OK;
+
+    ptr = mmap(NULL, info->size, PROT_READ | PROT_WRITE, MAP_SHARED,
+               info->fd, 0);
+    if (ptr == MAP_FAILED) {
+        mpp_err_f("fd %d mmap failed %s\n", info->fd, strerror(errno));
+        return MPP_ERR_NULL_PTR;
+    }
+
+    info->ptr = ptr;
+
+    return MPP_OK;
+}
+
+static MPP_RET allocator_memfd_close(void *ctx)
+{
+    if (NULL == ctx) {
+        mpp_err_f("does not accept NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    mpp_free(ctx);
+
+    return MPP_OK;
+}
+
+/* plain memory without dma-buf sync, reported as normal type */
+os_allocator allocator_memfd = {
+    .type = MPP_BUFFER_TYPE_NORMAL,
+    .open = allocator_memfd_open,
+    .close = allocator_memfd_close,
+    .alloc = allocator_memfd_alloc,
+    .free = allocator_memfd_free,
+    .import = allocator_memfd_import,
+    .release = allocator_memfd_free,
+    .mmap = allocator_memfd_mmap,
+};
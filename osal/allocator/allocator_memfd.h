@@ -0,0 +1,39 @@
+/*
+ * Copyright 2020 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __ALLOCATOR_MEMFD_H__
+#define __ALLOCATOR_MEMFD_H__
+
+#include "os_allocator.h"
+
+/*
+ * Normal memory with a real fd for soft device. It replaces the std fallback
+ * of hardware buffer types so soft device can map the buffer by register fd.
+ */
+extern os_allocator allocator_memfd;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* whether fd belongs to a live memfd buffer */
+RK_U32 allocator_memfd_has_fd(RK_S32 fd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -15,6 +15,7 @@
  */
 
 #if defined(__ANDROID__)
+#include "allocator_dma_heap.h"
 #include "allocator_drm.h"
 #include "allocator_ext_dma.h"
 #include "allocator_ion.h"
@@ -43,6 +44,14 @@ MPP_RET os_allocator_get(os_allocator *api, MppBufferType type)
         *api = (mpp_rt_allcator_is_valid(MPP_BUFFER_TYPE_DRM)) ? allocator_drm :
 #else
         * api =
+#endif
+               (mpp_rt_allcator_is_valid(MPP_BUFFER_TYPE_ION)) ? allocator_ion :
+               allocator_std;
+    } break;
+    case MPP_BUFFER_TYPE_DMA_HEAP : {
+        *api = (mpp_rt_allcator_is_valid(MPP_BUFFER_TYPE_DMA_HEAP)) ? allocator_dma_heap :
+#if HAVE_DRM
+               (mpp_rt_allcator_is_valid(MPP_BUFFER_TYPE_DRM)) ? allocator_drm :
 #endif
                (mpp_rt_allcator_is_valid(MPP_BUFFER_TYPE_ION)) ? allocator_ion :
                allocator_std;
@@ -17,23 +17,38 @@
 #define MODULE_TAG "mpp_device"
 
 #include <string.h>
+#include <semaphore.h>
 
 #include "mpp_env.h"
 #include "mpp_log.h"
 #include "mpp_mem.h"
+#include "mpp_atomic.h"
+#include "mpp_dev_reactor.h"
 
 #include "mpp_device_debug.h"
 #include "mpp_service_api.h"
 #include "vcodec_service_api.h"
+#include "soft_device_api.h"
 
 typedef struct MppDevImpl_t {
     MppClientType   type;
 
     void            *ctx;
     const MppDevApi *api;
+
+    /* cmd sent but not polled yet */
+    RK_S32          cmd_pending;
+    /* shared completion thread of the client type, NULL for blocking poll */
+    MppDevReactor   reactor;
+    sem_t           poll_done;
 } MppDevImpl;
 
 RK_U32 mpp_device_debug = 0;
+/*
+ * wait hardware on the shared completion thread, 0 - poll on caller thread.
+ * Only backends with done_fd use it, the kernel drivers have no such fd yet.
+ */
+static RK_U32 mpp_dev_async_poll = 0;
 
 MPP_RET mpp_dev_init(MppDev *ctx, MppClientType type)
 {
@@ -64,6 +79,9 @@ MPP_RET mpp_dev_init(MppDev *ctx, MppClientType type)
     case IOCTL_MPP_SERVICE_V1 : {
         api = &mpp_service_api;
     } break;
+    case IOCTL_SOFT_DEVICE : {
+        api = &soft_device_api;
+    } break;
     default : {
         mpp_err_f("invalid ioctl verstion %d\n", ioctl_version);
         return MPP_NOK;
@@ -84,6 +102,12 @@ MPP_RET mpp_dev_init(MppDev *ctx, MppClientType type)
     impl->type = type;
     *ctx = impl;
 
+    /* one reactor per device node which is identified by client type */
+    mpp_env_get_u32("mpp_dev_async_poll", &mpp_dev_async_poll, 0);
+    if (mpp_dev_async_poll && api->done_fd &&
+        !mpp_dev_reactor_get(&impl->reactor, type))
+        sem_init(&impl->poll_done, 0, 0);
+
     return api->init(impl_ctx, type);
 }
 
@@ -97,6 +121,14 @@ MPP_RET mpp_dev_deinit(MppDev ctx)
     MppDevImpl *p = (MppDevImpl *)ctx;
     MPP_RET ret = MPP_OK;
 
+    /* wait async poll done before the device is gone */
+    if (p->reactor) {
+        mpp_dev_reactor_sync(p->reactor, p);
+        mpp_dev_reactor_put(p->reactor);
+        sem_destroy(&p->poll_done);
+        p->reactor = NULL;
+    }
+
     if (p->api && p->api->deinit && p->ctx)
         ret = p->api->deinit(p->ctx);
 
@@ -106,6 +138,33 @@ MPP_RET mpp_dev_deinit(MppDev ctx)
     return ret;
 }
 
+/* done fd is readable, the poll on the owner thread will not block */
+static void mpp_dev_poll_ready(void *ctx)
+{
+    MppDevImpl *p = (MppDevImpl *)ctx;
+
+    sem_post(&p->poll_done);
+}
+
+/*
+ * The caller sleeps until the reactor shared by the client type sees the done
+ * fd readable, then polls on its own thread. Without a done fd the blocking
+ * poll stays on the caller thread, a shared thread would serialize all
+ * instances of the device behind the slowest task.
+ */
+static MPP_RET mpp_dev_poll_wait(MppDevImpl *p)
+{
+    const MppDevApi *api = p->api;
+    RK_S32 fd = api->done_fd(p->ctx);
+
+    if (fd < 0 || mpp_dev_reactor_submit(p->reactor, fd, p, mpp_dev_poll_ready, p))
+        return api->cmd_poll(p->ctx);
+
+    sem_wait(&p->poll_done);
+
+    return api->cmd_poll(p->ctx);
+}
+
 MPP_RET mpp_dev_ioctl(MppDev ctx, RK_S32 cmd, void *param)
 {
     if (NULL == ctx) {
@@ -141,10 +200,29 @@ MPP_RET mpp_dev_ioctl(MppDev ctx, RK_S32 cmd, void *param)
     case MPP_DEV_CMD_SEND : {
         if (api->cmd_send)
             ret = api->cmd_send(impl_ctx);
+        if (!ret)
+            MPP_FETCH_ADD(&p->cmd_pending, 1);
     } break;
     case MPP_DEV_CMD_POLL : {
-        if (api->cmd_poll)
-            ret = api->cmd_poll(impl_ctx);
+        MppDevPollCfg *cfg = (MppDevPollCfg *)param;
+        RK_U32 done = 1;
+
+        if (cfg && api->cmd_poll_slice) {
+            ret = api->cmd_poll_slice(impl_ctx, cfg);
+            done = ret || (cfg->count_ret > 0 &&
+                           cfg->slice_info[cfg->count_ret - 1].last);
+        } else {
+            if (api->cmd_poll)
+                ret = (!cfg && p->reactor && p->cmd_pending > 0) ?
+                      mpp_dev_poll_wait(p) : api->cmd_poll(impl_ctx);
+            if (cfg) {
+                cfg->count_ret = 1;
+                cfg->slice_info[0].length = 0;
+                cfg->slice_info[0].last = 1;
+            }
+        }
+        if (done && p->cmd_pending > 0)
+            MPP_FETCH_SUB(&p->cmd_pending, 1);
     } break;
     default : {
         mpp_err_f("invalid cmd %d\n", cmd);
@@ -142,7 +142,7 @@ void check_mpp_service_cap(RK_U32 *codec_type, RK_U32 *hw_ids, MppServiceCmdCap
     /* for device check on startup */
     mpp_env_get_u32("mpp_device_debug", &mpp_device_debug, 0);
     mpp_device_debug = 1;
-    
+
     *codec_type = 0;
     memset(hw_ids, 0, sizeof(RK_U32) * 32);
 
@@ -263,6 +263,7 @@ typedef struct MppDevMppService_t {
     /* support max cmd buttom  */
     const MppServiceCmdCap *cap;
     RK_U32          support_set_info;
+    RK_U32          support_poll_irq;
 } MppDevMppService;
 
 MPP_RET mpp_service_init(void *ctx, MppClientType type)
@@ -285,6 +286,9 @@ MPP_RET mpp_service_init(void *ctx, MppClientType type)
     mpp_assert(p->cap);
     if (MPP_OK == mpp_service_check_cmd_valid(MPP_CMD_SEND_CODEC_INFO, p->cap))
         p->support_set_info = 1;
+    /* slice irq report is not verified on hardware yet so it is opt-in */
+    if (MPP_OK == mpp_service_check_cmd_valid(MPP_CMD_POLL_HW_IRQ, p->cap))
+        mpp_env_get_u32("mpp_dev_poll_slice", &p->support_poll_irq, 0);
 
     return ret;
 }
@@ -451,6 +455,45 @@ MPP_RET mpp_service_cmd_poll(void *ctx)
     return ret;
 }
 
+MPP_RET mpp_service_cmd_poll_slice(void *ctx, MppDevPollCfg *cfg)
+{
+    MppDevMppService *p = (MppDevMppService *)ctx;
+    MppReqV1 dev_req;
+    RK_S32 count_max;
+    MPP_RET ret;
+
+    /* kernel without slice irq report only tells the whole task */
+    if (!p->support_poll_irq) {
+        ret = mpp_service_cmd_poll(ctx);
+        cfg->count_ret = 1;
+        cfg->slice_info[0].length = 0;
+        cfg->slice_info[0].last = 1;
+        return ret;
+    }
+
+    /* kernel blocks until slices are done and fills count_ret and slice_info */
+    count_max = MPP_MIN(cfg->count_max, MPP_DEV_POLL_SLICE_MAX);
+    cfg->count_max = count_max;
+    cfg->count_ret = 0;
+
+    memset(&dev_req, 0, sizeof(dev_req));
+    dev_req.cmd = MPP_CMD_POLL_HW_IRQ;
+    dev_req.flag |= MPP_FLAGS_LAST_MSG;
+    dev_req.size = sizeof(*cfg) - sizeof(cfg->slice_info) +
+                   count_max * sizeof(cfg->slice_info[0]);
+    dev_req.offset = 0;
+    dev_req.data_ptr = REQ_DATA_PTR(cfg);
+
+    ret = mpp_service_ioctl_request(p->fd, &dev_req);
+    if (ret) {
+        mpp_err_f("ioctl MPP_IOC_CFG_V1 failed ret %d errno %d %s\n",
+                  ret, errno, strerror(errno));
+        ret = errno;
+    }
+
+    return ret;
+}
+
 const MppDevApi mpp_service_api = {
     "mpp_service",
     sizeof(MppDevMppService),
@@ -462,4 +505,6 @@ const MppDevApi mpp_service_api = {
     mpp_service_set_info,
     mpp_service_cmd_send,
     mpp_service_cmd_poll,
+    NULL,
+    mpp_service_cmd_poll_slice,
 };
@@ -0,0 +1,486 @@
+/*
+ * Copyright 2020 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "soft_device"
+
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/timerfd.h>
+
+#include "mpp_env.h"
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+
+#include "mpp_device_debug.h"
+#include "soft_device_api.h"
+#include "allocator_memfd.h"
+
+#define SOFT_TASK_MAX           8
+#define SOFT_REG_RD_MAX         8
+
+/* byte written to the whole encoder stream */
+#define SOFT_PKT_PATTERN        0xa5
+
+/* register value written on task done */
+typedef struct SoftDevResult_t {
+    RK_S32              client_type;
+    RK_U32              offset;
+    RK_U32              val;
+    /* non-zero for stream length register, 1 in bytes and 8 in bits */
+    RK_U32              len_scale;
+} SoftDevResult;
+
+static const SoftDevResult soft_results[] = {
+    /* rkvdec sw01 and vdpu34x sw224 dec_rdy_sta */
+    {   VPU_CLIENT_RKVDEC,  0x004,  1 << 12,    0,  },
+    {   VPU_CLIENT_RKVDEC,  0x380,  1 << 2,     0,  },
+    /* vdpu1 SwReg01 and vdpu2 reg55 sw_dec_rdy_int */
+    {   VPU_CLIENT_VDPU1,   0x004,  1 << 12,    0,  },
+    {   VPU_CLIENT_VDPU2,   0x0dc,  1 << 4,     0,  },
+    /* vepu541 st_bsl, vepu1 / vepu2 stream buffer limit */
+    {   VPU_CLIENT_RKVENC,  0x210,  0,          1,  },
+    {   VPU_CLIENT_VEPU1,   0x060,  0,          8,  },
+    {   VPU_CLIENT_VEPU2,   0x0d4,  0,          8,  },
+};
+
+typedef enum SoftDevBufType_e {
+    SOFT_BUF_FRAME,             /* decoder output, zeroed */
+    SOFT_BUF_STREAM,            /* encoder output, filled with pattern */
+} SoftDevBufType;
+
+/* register holding 10bit fd + (offset << 10) of the output buffer */
+typedef struct SoftDevBuf_t {
+    RK_S32              client_type;
+    RK_U32              offset;
+    SoftDevBufType      type;
+} SoftDevBuf;
+
+static const SoftDevBuf soft_bufs[] = {
+    /* rkvdec swreg7 decout_base */
+    {   VPU_CLIENT_RKVDEC,  0x01c,  SOFT_BUF_FRAME,     },
+    /* vdpu1 SwReg13 and vdpu2 reg63 dec_out_base */
+    {   VPU_CLIENT_VDPU1,   0x034,  SOFT_BUF_FRAME,     },
+    {   VPU_CLIENT_VDPU2,   0x0fc,  SOFT_BUF_FRAME,     },
+    /* vepu541 reg086 adr_bsbs, vepu1 / vepu2 output stream base */
+    {   VPU_CLIENT_RKVENC,  0x158,  SOFT_BUF_STREAM,    },
+    {   VPU_CLIENT_VEPU1,   0x014,  SOFT_BUF_STREAM,    },
+    {   VPU_CLIENT_VEPU2,   0x134,  SOFT_BUF_STREAM,    },
+};
+
+#define SOFT_BUF_MAX            MPP_ARRAY_ELEMS(soft_bufs)
+
+typedef struct SoftDevBufCfg_t {
+    RK_S32              fd;
+    RK_U32              offset;
+} SoftDevBufCfg;
+
+typedef struct SoftDevTask_t {
+    RK_S64              time_done;
+    SoftDevBufCfg       bufs[SOFT_BUF_MAX];
+    RK_U32              pkt_len;
+    /* slices already returned by slice poll */
+    RK_U32              slice_idx;
+    RK_S32              rd_cnt;
+    MppDevRegRdCfg      rd[SOFT_REG_RD_MAX];
+} SoftDevTask;
+
+typedef struct MppDevSoft_t {
+    RK_S32              client_type;
+    RK_U32              latency;
+    RK_U32              pkt_size;
+    /* slices of a task done evenly in its latency */
+    RK_U32              slice_cnt;
+    /* simulated hardware finishes tasks one by one */
+    RK_S64              time_busy;
+    /* timerfd expires at the done time of the first task */
+    RK_S32              timer_fd;
+    /* task ring is sent and polled on different threads */
+    pthread_mutex_t     lock;
+
+    /* registers to read back and buffers of the task being prepared */
+    RK_S32              rd_cnt;
+    MppDevRegRdCfg      rd[SOFT_REG_RD_MAX];
+    SoftDevBufCfg       bufs[SOFT_BUF_MAX];
+    RK_U32              buf_offset[SOFT_BUF_MAX];
+
+    SoftDevTask         tasks[SOFT_TASK_MAX];
+    RK_S32              task_idx;
+    RK_S32              task_cnt;
+} MppDevSoft;
+
+MPP_RET soft_device_init(void *ctx, MppClientType type)
+{
+    MppDevSoft *p = (MppDevSoft *)ctx;
+
+    p->client_type = type;
+
+    mpp_env_get_u32("mpp_dev_soft_latency", &p->latency, 0);
+    mpp_env_get_u32("mpp_dev_soft_pkt_size", &p->pkt_size, 1024);
+    mpp_env_get_u32("mpp_dev_soft_slice_cnt", &p->slice_cnt, 1);
+    if (!p->slice_cnt)
+        p->slice_cnt = 1;
+
+    mpp_dev_dbg_probe("soft device client %d latency %d us pkt_size %d slice %d\n",
+                      type, p->latency, p->pkt_size, p->slice_cnt);
+
+    p->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (p->timer_fd < 0) {
+        mpp_err_f("failed to create timerfd\n");
+        return MPP_NOK;
+    }
+
+    pthread_mutex_init(&p->lock, NULL);
+
+    return MPP_OK;
+}
+
+MPP_RET soft_device_deinit(void *ctx)
+{
+    MppDevSoft *p = (MppDevSoft *)ctx;
+
+    if (p->task_cnt)
+        mpp_log_f("client %d deinit with %d tasks not polled\n",
+                  p->client_type, p->task_cnt);
+
+    if (p->timer_fd >= 0) {
+        close(p->timer_fd);
+        p->timer_fd = -1;
+        pthread_mutex_destroy(&p->lock);
+    }
+
+    return MPP_OK;
+}
+
+MPP_RET soft_device_reg_wr(void *ctx, MppDevRegWrCfg *cfg)
+{
+    MppDevSoft *p = (MppDevSoft *)ctx;
+    RK_U32 i;
+
+    mpp_dev_dbg_reg("client %d write offset %x size %d\n",
+                    p->client_type, cfg->offset, cfg->size);
+
+    for (i = 0; i < SOFT_BUF_MAX; i++) {
+        const SoftDevBuf *buf = &soft_bufs[i];
+        RK_U32 val;
+
+        if (buf->client_type != p->client_type ||
+            buf->offset < cfg->offset ||
+            buf->offset + sizeof(RK_U32) > cfg->offset + cfg->size)
+            continue;
+
+        val = *(RK_U32 *)((RK_U8 *)cfg->reg + buf->offset - cfg->offset);
+        p->bufs[i].fd = val & 0x3ff;
+        p->bufs[i].offset = val >> 10;
+    }
+
+    return MPP_OK;
+}
+
+MPP_RET soft_device_reg_rd(void *ctx, MppDevRegRdCfg *cfg)
+{
+    MppDevSoft *p = (MppDevSoft *)ctx;
+
+    if (p->rd_cnt >= SOFT_REG_RD_MAX) {
+        mpp_err_f("too many read request %d\n", p->rd_cnt);
+        return MPP_NOK;
+    }
+
+    p->rd[p->rd_cnt++] = *cfg;
+
+    return MPP_OK;
+}
+
+MPP_RET soft_device_reg_offset(void *ctx, MppDevRegOffsetCfg *cfg)
+{
+    MppDevSoft *p = (MppDevSoft *)ctx;
+    RK_U32 i;
+
+    for (i = 0; i < SOFT_BUF_MAX; i++) {
+        if (soft_bufs[i].client_type == p->client_type &&
+            soft_bufs[i].offset == cfg->reg_idx * sizeof(RK_U32))
+            p->buf_offset[i] = cfg->offset;
+    }
+
+    return MPP_OK;
+}
+
+MPP_RET soft_device_set_info(void *ctx, MppDevInfoCfg *cfg)
+{
+    (void)ctx;
+    (void)cfg;
+    return MPP_OK;
+}
+
+/* arm done fd on the first task or disarm it when all tasks are polled */
+static void soft_device_arm(MppDevSoft *p)
+{
+    struct itimerspec its;
+
+    memset(&its, 0, sizeof(its));
+    if (p->task_cnt) {
+        /* zero it_value disarms the timer, past time expires at once */
+        RK_S64 time = MPP_MAX(p->tasks[p->task_idx].time_done, 1);
+
+        its.it_value.tv_sec = time / 1000000;
+        its.it_value.tv_nsec = (time % 1000000) * 1000;
+    }
+
+    timerfd_settime(p->timer_fd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+MPP_RET soft_device_cmd_send(void *ctx)
+{
+    MppDevSoft *p = (MppDevSoft *)ctx;
+    SoftDevTask *task = NULL;
+    RK_S64 now = mpp_time();
+    RK_U32 i;
+
+    pthread_mutex_lock(&p->lock);
+
+    if (p->task_cnt >= SOFT_TASK_MAX) {
+        mpp_err_f("too many task %d sent without poll\n", p->task_cnt);
+        pthread_mutex_unlock(&p->lock);
+        return MPP_NOK;
+    }
+
+    task = &p->tasks[(p->task_idx + p->task_cnt) % SOFT_TASK_MAX];
+    p->task_cnt++;
+
+    p->time_busy = MPP_MAX(p->time_busy, now) + p->latency;
+    task->time_done = p->time_busy;
+    task->pkt_len = p->pkt_size;
+    task->slice_idx = 0;
+    task->rd_cnt = p->rd_cnt;
+    memcpy(task->rd, p->rd, sizeof(p->rd[0]) * p->rd_cnt);
+    p->rd_cnt = 0;
+
+    for (i = 0; i < SOFT_BUF_MAX; i++) {
+        task->bufs[i].fd = p->bufs[i].fd;
+        task->bufs[i].offset = p->bufs[i].offset + p->buf_offset[i];
+        p->bufs[i].fd = 0;
+        p->bufs[i].offset = 0;
+        p->buf_offset[i] = 0;
+    }
+
+    if (p->task_cnt == 1)
+        soft_device_arm(p);
+
+    pthread_mutex_unlock(&p->lock);
+
+    return MPP_OK;
+}
+
+/*
+ * fd 0 is an unset register. Only fds of memfd buffers are mapped, other
+ * register values are not fds owned by mpp.
+ */
+static void soft_device_write_buf(MppDevSoft *p, SoftDevTask *task, RK_U32 idx)
+{
+    SoftDevBufCfg *cfg = &task->bufs[idx];
+    off_t size;
+    RK_U8 *ptr;
+
+    if (cfg->fd <= 0)
+        return;
+
+    if (!allocator_memfd_has_fd(cfg->fd)) {
+        mpp_dev_dbg_probe("client %d skip fd %d not from memfd\n",
+                          p->client_type, cfg->fd);
+        return;
+    }
+
+    size = lseek(cfg->fd, 0, SEEK_END);
+    if (size <= 0 || (size_t)size <= cfg->offset) {
+        mpp_dev_dbg_probe("client %d skip fd %d size %d offset %d\n",
+                          p->client_type, cfg->fd, (RK_S32)size, cfg->offset);
+        return;
+    }
+
+    ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, cfg->fd, 0);
+    if (ptr == MAP_FAILED) {
+        mpp_dev_dbg_probe("client %d skip fd %d mmap failed\n",
+                          p->client_type, cfg->fd);
+        return;
+    }
+
+    if (soft_bufs[idx].type == SOFT_BUF_FRAME) {
+        memset(ptr, 0, size);
+    } else {
+        task->pkt_len = MPP_MIN((off_t)p->pkt_size, size - cfg->offset);
+        memset(ptr + cfg->offset, SOFT_PKT_PATTERN, task->pkt_len);
+    }
+
+    munmap(ptr, size);
+}
+
+static void soft_device_fill(MppDevSoft *p, SoftDevTask *task, MppDevRegRdCfg *rd)
+{
+    RK_U32 i;
+
+    memset(rd->reg, 0, rd->size);
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(soft_results); i++) {
+        const SoftDevResult *res = &soft_results[i];
+        RK_U32 *reg;
+
+        if (res->client_type != p->client_type ||
+            res->offset < rd->offset ||
+            res->offset + sizeof(RK_U32) > rd->offset + rd->size)
+            continue;
+
+        reg = (RK_U32 *)((RK_U8 *)rd->reg + res->offset - rd->offset);
+        if (res->len_scale)
+            *reg = task->pkt_len * res->len_scale;
+        else
+            *reg |= res->val;
+    }
+}
+
+MPP_RET soft_device_cmd_poll(void *ctx)
+{
+    MppDevSoft *p = (MppDevSoft *)ctx;
+    SoftDevTask task;
+    RK_S64 wait;
+    RK_S32 i;
+
+    pthread_mutex_lock(&p->lock);
+
+    if (!p->task_cnt) {
+        mpp_err_f("poll without task sent\n");
+        pthread_mutex_unlock(&p->lock);
+        return MPP_NOK;
+    }
+
+    /* copy out as the slot is reused by next send */
+    task = p->tasks[p->task_idx];
+    p->task_idx = (p->task_idx + 1) % SOFT_TASK_MAX;
+    p->task_cnt--;
+    soft_device_arm(p);
+
+    pthread_mutex_unlock(&p->lock);
+
+    wait = task.time_done - mpp_time();
+    if (wait > 0)
+        usleep(wait);
+
+    for (i = 0; i < (RK_S32)SOFT_BUF_MAX; i++) {
+        if (soft_bufs[i].client_type == p->client_type)
+            soft_device_write_buf(p, &task, i);
+    }
+
+    for (i = 0; i < task.rd_cnt; i++)
+        soft_device_fill(p, &task, &task.rd[i]);
+
+    return MPP_OK;
+}
+
+/* slice idx is done at (idx + 1) / slice_cnt of the task latency */
+static RK_S64 soft_device_slice_time(MppDevSoft *p, SoftDevTask *task, RK_U32 idx)
+{
+    return task->time_done - p->latency +
+           (RK_S64)p->latency * (idx + 1) / p->slice_cnt;
+}
+
+MPP_RET soft_device_cmd_poll_slice(void *ctx, MppDevPollCfg *cfg)
+{
+    MppDevSoft *p = (MppDevSoft *)ctx;
+    RK_S32 count_max = MPP_MIN(cfg->count_max, MPP_DEV_POLL_SLICE_MAX);
+    SoftDevTask *task = NULL;
+    RK_S32 count = 0;
+    RK_S64 wait;
+    RK_S64 now;
+    RK_U32 i;
+
+    cfg->count_ret = 0;
+
+    if (count_max <= 0) {
+        mpp_err_f("invalid slice count max %d\n", cfg->count_max);
+        return MPP_ERR_VALUE;
+    }
+
+    pthread_mutex_lock(&p->lock);
+
+    if (!p->task_cnt) {
+        mpp_err_f("poll without task sent\n");
+        pthread_mutex_unlock(&p->lock);
+        return MPP_NOK;
+    }
+
+    /* first task is only removed by poll on this thread */
+    task = &p->tasks[p->task_idx];
+    wait = soft_device_slice_time(p, task, task->slice_idx) - mpp_time();
+
+    pthread_mutex_unlock(&p->lock);
+
+    if (wait > 0)
+        usleep(wait);
+
+    /* whole stream is written on the first slice and length is known */
+    if (!task->slice_idx) {
+        for (i = 0; i < SOFT_BUF_MAX; i++) {
+            if (soft_bufs[i].client_type == p->client_type &&
+                soft_bufs[i].type == SOFT_BUF_STREAM)
+                soft_device_write_buf(p, task, i);
+        }
+    }
+
+    now = mpp_time();
+    while (task->slice_idx < p->slice_cnt && count < count_max) {
+        RK_U32 idx = task->slice_idx;
+        RK_U32 start = task->pkt_len * idx / p->slice_cnt;
+        RK_U32 end = task->pkt_len * (idx + 1) / p->slice_cnt;
+
+        if (count && soft_device_slice_time(p, task, idx) > now)
+            break;
+
+        cfg->slice_info[count].length = end - start;
+        cfg->slice_info[count].last = (idx + 1 == p->slice_cnt);
+        count++;
+        task->slice_idx++;
+    }
+    cfg->count_ret = count;
+
+    /* last slice finishes the task like a normal poll */
+    if (task->slice_idx == p->slice_cnt)
+        return soft_device_cmd_poll(ctx);
+
+    return MPP_OK;
+}
+
+RK_S32 soft_device_done_fd(void *ctx)
+{
+    MppDevSoft *p = (MppDevSoft *)ctx;
+
+    return p->timer_fd;
+}
+
+const MppDevApi soft_device_api = {
+    "soft_device",
+    sizeof(MppDevSoft),
+    soft_device_init,
+    soft_device_deinit,
+    soft_device_reg_wr,
+    soft_device_reg_rd,
+    soft_device_reg_offset,
+    soft_device_set_info,
+    soft_device_cmd_send,
+    soft_device_cmd_poll,
+    soft_device_done_fd,
+    soft_device_cmd_poll_slice,
+};
@@ -46,6 +46,8 @@ extern "C" {
 MPP_RET mpp_allocator_get(MppAllocator *allocator,
                           MppAllocatorApi **api, MppBufferType type);
 MPP_RET mpp_allocator_put(MppAllocator *allocator);
+/* type of the allocator actually used after fallback */
+MppBufferType mpp_allocator_get_type(MppAllocator allocator);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,38 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __MPP_ATOMIC_H__
+#define __MPP_ATOMIC_H__
+
+/*
+ * Thin wrappers of the compiler atomic builtins. All operations are full
+ * memory barriers except MPP_XCHG which is an acquire barrier.
+ */
+#define MPP_FETCH_ADD(ptr, val)         __sync_fetch_and_add(ptr, val)
+#define MPP_FETCH_SUB(ptr, val)         __sync_fetch_and_sub(ptr, val)
+#define MPP_ADD_FETCH(ptr, val)         __sync_add_and_fetch(ptr, val)
+#define MPP_SUB_FETCH(ptr, val)         __sync_sub_and_fetch(ptr, val)
+#define MPP_FETCH_OR(ptr, val)          __sync_fetch_and_or(ptr, val)
+#define MPP_FETCH_AND(ptr, val)         __sync_fetch_and_and(ptr, val)
+
+#define MPP_BOOL_CAS(ptr, old, val)     __sync_bool_compare_and_swap(ptr, old, val)
+#define MPP_VAL_CAS(ptr, old, val)      __sync_val_compare_and_swap(ptr, old, val)
+#define MPP_XCHG(ptr, val)              __sync_lock_test_and_set(ptr, val)
+
+#define MPP_SYNC()                      __sync_synchronize()
+
+#endif /*__MPP_ATOMIC_H__*/
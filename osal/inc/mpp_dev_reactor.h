@@ -0,0 +1,61 @@
+/*
+ * Copyright 2020 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_DEV_REACTOR_H__
+#define __MPP_DEV_REACTOR_H__
+
+#include "rk_type.h"
+#include "mpp_err.h"
+
+typedef void* MppDevReactor;
+
+/*
+ * called on reactor thread when the fd of a request becomes readable, or when
+ * the request without fd is due and then the callback waits the hardware
+ */
+typedef void (*MppDevReactorDone)(void *ctx);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Shared hardware completion reactor.
+ *
+ * One thread polls the done fds of all devices with the same id and calls
+ * the owner's done callback of each fd which becomes readable. Devices
+ * complete in any order. Each owner has at most one request in flight.
+ *
+ * Device without done fd submits with fd -1. Its done callback is called in
+ * submit order and does the blocking poll on the reactor thread. This keeps
+ * the order of a kernel task queue which finishes tasks one by one.
+ *
+ * Done callback must not put the reactor or sync its own owner. It should
+ * only wake the owner up and leave the rest of the work to the owner.
+ */
+MPP_RET mpp_dev_reactor_get(MppDevReactor *reactor, RK_U32 id);
+MPP_RET mpp_dev_reactor_put(MppDevReactor reactor);
+
+MPP_RET mpp_dev_reactor_submit(MppDevReactor reactor, RK_S32 fd, void *owner,
+                               MppDevReactorDone done, void *ctx);
+/* wait until the request of owner is done and its callback has returned */
+MPP_RET mpp_dev_reactor_sync(MppDevReactor reactor, void *owner);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_DEV_REACTOR_H__*/
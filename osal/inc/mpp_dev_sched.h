@@ -0,0 +1,72 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_DEV_SCHED_H__
+#define __MPP_DEV_SCHED_H__
+
+#include "rk_type.h"
+#include "mpp_err.h"
+
+typedef void* MppDevSched;
+typedef void* MppDevSchedChan;
+
+/* per channel statistic, all time in us */
+typedef struct MppDevSchedStat_t {
+    RK_S64  count;
+    /* task finished after its deadline */
+    RK_S64  miss;
+    /* from request to hardware granted */
+    RK_S64  wait_sum;
+    RK_S64  wait_max;
+    /* from hardware granted to task done */
+    RK_S64  run_sum;
+    RK_S64  run_max;
+} MppDevSchedStat;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Earliest deadline first scheduler for instances sharing one device.
+ *
+ * Each instance adds a channel and brackets every hardware task with begin
+ * and end. begin blocks until the channel is the waiting one with the
+ * earliest deadline and the device has a free slot. The deadline is the
+ * request time plus the channel period scaled by 16 / weight. Channels
+ * without period have no deadline and run after the others.
+ *
+ * depth is the number of tasks allowed on the device at the same time. A
+ * depth above one keeps the next task queued in kernel while the current
+ * one runs. The depth of the first get on a device id is used.
+ */
+MPP_RET mpp_dev_sched_get(MppDevSched *sched, RK_U32 id, RK_S32 depth);
+MPP_RET mpp_dev_sched_put(MppDevSched sched);
+
+MPP_RET mpp_dev_sched_chan_add(MppDevSched sched, MppDevSchedChan *chan);
+MPP_RET mpp_dev_sched_chan_del(MppDevSchedChan chan);
+/* period in us, zero for no deadline. weight 16 is the default */
+MPP_RET mpp_dev_sched_chan_set(MppDevSchedChan chan, RK_S64 period, RK_S32 weight);
+
+MPP_RET mpp_dev_sched_begin(MppDevSchedChan chan);
+MPP_RET mpp_dev_sched_end(MppDevSchedChan chan);
+MPP_RET mpp_dev_sched_stat(MppDevSchedChan chan, MppDevSchedStat *stat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_DEV_SCHED_H__*/
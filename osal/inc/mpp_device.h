@@ -61,6 +61,33 @@ typedef struct MppDevSetInfoCfg_t {
     RK_U64  data;
 } MppDevInfoCfg;
 
+/*
+ * for MPP_DEV_CMD_POLL
+ *
+ * NULL param waits the whole task. With MppDevPollCfg the poll returns once
+ * one or more slices of the task are done on hardware and reports their
+ * stream length. The task is finished when the slice with last flag is
+ * returned. Backend without slice report returns one last slice with zero
+ * length when the task is finished.
+ *
+ * The layout follows the poll request of the kernel mpp_service driver:
+ * poll_type and poll_ret first, then count_max slice_info entries.
+ */
+#define MPP_DEV_POLL_SLICE_MAX  16
+
+typedef struct MppDevPollSlice_t {
+    RK_U32  length      : 31;
+    RK_U32  last        : 1;
+} MppDevPollSlice;
+
+typedef struct MppDevPollCfg_t {
+    RK_S32          poll_type;
+    RK_S32          poll_ret;
+    RK_S32          count_max;
+    RK_S32          count_ret;
+    MppDevPollSlice slice_info[MPP_DEV_POLL_SLICE_MAX];
+} MppDevPollCfg;
+
 typedef struct MppDevApi_t {
     const char  *name;
     RK_U32      ctx_size;
@@ -78,6 +105,15 @@ typedef struct MppDevApi_t {
 
     /* poll cmd from hardware */
     MPP_RET     (*cmd_poll)(void *ctx);
+
+    /*
+     * optional fd readable when the first sent cmd is done. Without it
+     * MPP_DEV_CMD_POLL runs the blocking cmd_poll on the caller thread.
+     */
+    RK_S32      (*done_fd)(void *ctx);
+
+    /* optional poll of the slices done on the first sent cmd */
+    MPP_RET     (*cmd_poll_slice)(void *ctx, MppDevPollCfg *cfg);
 } MppDevApi;
 
 typedef void* MppDev;
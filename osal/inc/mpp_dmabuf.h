@@ -0,0 +1,50 @@
+/*
+ * Copyright 2020 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_DMABUF_H__
+#define __MPP_DMABUF_H__
+
+#include "rk_type.h"
+#include "mpp_err.h"
+
+/*
+ * CPU access bracket for cached dma-buf
+ *
+ * mpp_dmabuf_sync_begin : call before cpu access, invalidate cache for read
+ * mpp_dmabuf_sync_end   : call after cpu access, flush cache for write
+ *
+ * ro     - 1 for read only access, 0 for read / write access
+ * offset - access range start in the buffer
+ * length - access range length, zero for the whole buffer
+ *
+ * Range sync is only done on kernel with partial sync ioctl, otherwise the
+ * whole buffer is synced.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET mpp_dmabuf_sync_begin(RK_S32 fd, RK_S32 ro, RK_U32 offset, RK_U32 length,
+                              const char *caller);
+MPP_RET mpp_dmabuf_sync_end(RK_S32 fd, RK_S32 ro, RK_U32 offset, RK_U32 length,
+                            const char *caller);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_DMABUF_H__*/
@@ -27,6 +27,8 @@ RK_S32 mpp_eventfd_get(RK_U32 init);
 RK_S32 mpp_eventfd_put(RK_S32 fd);
 
 RK_S32 mpp_eventfd_read(RK_S32 fd, RK_U64 *val, RK_S64 timeout);
+/* wait fd readable without consuming the counter */
+RK_S32 mpp_eventfd_poll(RK_S32 fd, RK_S64 timeout);
 RK_S32 mpp_eventfd_write(RK_S32 fd, RK_U64 val);
 
 #ifdef __cplusplus
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __MPP_MEM_POOL_H__
+#define __MPP_MEM_POOL_H__
+
+#include "rk_type.h"
+
+typedef void* MppMemPool;
+
+#define mpp_mem_pool_get(pool)      mpp_mem_pool_get_f(__FUNCTION__, pool)
+#define mpp_mem_pool_put(pool, p)   mpp_mem_pool_put_f(__FUNCTION__, pool, p)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fixed size object pool with per-thread cache.
+ *
+ * get / put do not take any lock. Objects are carved from slabs which are
+ * kept until the pool is deinit. When mpp_mem_debug is set the pool falls
+ * back to mpp_osal_calloc / mpp_osal_free so memory tracking still works.
+ * Returned objects are always zeroed.
+ */
+MppMemPool mpp_mem_pool_init(const char *name, size_t size);
+void mpp_mem_pool_deinit(MppMemPool pool);
+
+void *mpp_mem_pool_get_f(const char *caller, MppMemPool pool);
+void mpp_mem_pool_put_f(const char *caller, MppMemPool pool, void *p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_MEM_POOL_H__*/
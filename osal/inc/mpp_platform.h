@@ -26,6 +26,7 @@
 typedef enum MppIoctlVersion_e {
     IOCTL_VCODEC_SERVICE,
     IOCTL_MPP_SERVICE_V1,
+    IOCTL_SOFT_DEVICE,
     IOCTL_VERSION_BUTT,
 } MppIoctlVersion;
 
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2017 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_PTR_QUEUE_H__
+#define __MPP_PTR_QUEUE_H__
+
+#include "mpp_list.h"
+
+/*
+ * FIFO of pointers stored in a ring buffer.
+ *
+ * Unlike mpp_list no node is allocated and no payload is copied on push / pop.
+ * The ring only grows when it is full so a queue with stable depth does no
+ * allocation after warm up. Lock, wait and signal have the same semantics as
+ * mpp_list and the destructor is called with the address of the stored
+ * pointer, so mpp_list node destructors can be reused.
+ *
+ * Optional eventfd readiness handles follow the queue state level-triggered:
+ * the read fd is readable while the queue is not empty and the write fd is
+ * readable while the queue holds less than limit pointers. The fds are owned
+ * by the queue and should only be polled, never read.
+ */
+class MppPtrQueue
+{
+public:
+    MppPtrQueue(node_destructor func = NULL, RK_S32 capacity = 16);
+    ~MppPtrQueue();
+
+    // caller should hold the lock when queue is shared between threads
+    // pop with NULL drops the head pointer without calling destructor
+    RK_S32 push(void *ptr);
+    RK_S32 pop(void **ptr);
+
+    RK_S32 list_is_empty() { return !mCount; };
+    RK_S32 list_size() { return mCount; };
+
+    RK_S32 flush();
+
+    // limit is only used for write fd readiness, push does not check it
+    void   set_limit(RK_S32 limit);
+    RK_S32 get_limit() { return mLimit; };
+    RK_S32 get_rd_fd();
+    RK_S32 get_wr_fd();
+
+    void   lock();
+    void   unlock();
+    RK_S32 trylock();
+    Mutex *mutex();
+
+    void wait();
+    RK_S32 wait(RK_S64 timeout);
+    void signal();
+
+private:
+    Mutex               mMutex;
+    Condition           mCondition;
+
+    node_destructor     mDestroy;
+    void                **mRing;
+    RK_S32              mSize;
+    RK_S32              mHead;
+    RK_S32              mCount;
+    RK_S32              mLimit;
+
+    RK_S32              mRdFd;
+    RK_S32              mWrFd;
+    RK_U32              mRdReady;
+    RK_U32              mWrReady;
+
+    RK_S32 grow();
+    void   update_fd();
+
+    MppPtrQueue(const MppPtrQueue &);
+    MppPtrQueue &operator=(const MppPtrQueue &);
+};
+
+#endif /*__MPP_PTR_QUEUE_H__*/
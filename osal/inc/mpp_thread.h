@@ -144,6 +144,7 @@ public:
     RK_S32 timedwait(Mutex& mutex, RK_S64 timeout);
     RK_S32 timedwait(Mutex* mutex, RK_S64 timeout);
     RK_S32 signal();
+    RK_S32 broadcast();
 
 private:
     pthread_cond_t mCond;
@@ -187,6 +188,10 @@ inline RK_S32 Condition::signal()
 {
     return pthread_cond_signal(&mCond);
 }
+inline RK_S32 Condition::broadcast()
+{
+    return pthread_cond_broadcast(&mCond);
+}
 
 class MppMutexCond
 {
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2020 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SOFT_DEVICE_API_H__
+#define __SOFT_DEVICE_API_H__
+
+#include "mpp_device.h"
+
+/* hardware reported by platform when the soft device is selected */
+#define SOFT_DEVICE_VCODEC_TYPE     (HAVE_VDPU2 | HAVE_VEPU2 | HAVE_RKVDEC | HAVE_RKVENC)
+
+#ifdef ENABLE_SOFT_DEVICE
+#define SOFT_DEVICE_DEFAULT         1
+#else
+#define SOFT_DEVICE_DEFAULT         0
+#endif
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Stand-in device without hardware for running the software stack alone.
+ *
+ * Every sent task completes after a simulated latency. Registers read back
+ * are zero except the ready status of decoders and the stream length of
+ * encoders. Decoder output frames are zeroed and encoder output stream is
+ * filled with a fixed byte for the reported length. Hardware buffers get a
+ * real memfd when no dma-buf allocator exists so they can be mapped by fd.
+ *
+ * env mpp_dev_soft           - select soft device instead of kernel driver
+ * env mpp_dev_soft_type      - reported vcodec type, SOFT_DEVICE_VCODEC_TYPE
+ * env mpp_dev_soft_latency   - task latency in us, default 0
+ * env mpp_dev_soft_pkt_size  - encoder stream length in bytes, default 1024,
+ *                              limited by the output buffer size
+ * env mpp_dev_soft_slice_cnt - slices reported by slice poll, spread over the
+ *                              task latency, default 1
+ */
+extern const MppDevApi soft_device_api;
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* __SOFT_DEVICE_API_H__ */
@@ -17,10 +17,13 @@
 #if defined(__gnu_linux__)
 #include "mpp_log.h"
 #include "mpp_runtime.h"
+#include "mpp_platform.h"
 
+#include "allocator_dma_heap.h"
 #include "allocator_drm.h"
 #include "allocator_ext_dma.h"
 #include "allocator_ion.h"
+#include "allocator_memfd.h"
 #include "allocator_std.h"
 
 /*
@@ -28,6 +31,13 @@
  * we can support MPP_BUFFER_TYPE_V4L2 later
  */
 
+/* soft device needs real fd to access hardware buffer without kernel driver */
+static os_allocator os_allocator_fallback(void)
+{
+    return (mpp_get_ioctl_version() == IOCTL_SOFT_DEVICE) ? allocator_memfd :
+           allocator_std;
+}
+
 MPP_RET os_allocator_get(os_allocator *api, MppBufferType type)
 {
     MPP_RET ret = MPP_OK;
@@ -40,7 +50,7 @@ MPP_RET os_allocator_get(os_allocator *api, MppBufferType type)
 #if HAVE_DRM
                (mpp_rt_allcator_is_valid(MPP_BUFFER_TYPE_DRM)) ? allocator_drm :
 #endif
-               allocator_std;
+               os_allocator_fallback();
     } break;
     case MPP_BUFFER_TYPE_EXT_DMA: {
         *api = allocator_ext_dma;
@@ -52,7 +62,15 @@ MPP_RET os_allocator_get(os_allocator *api, MppBufferType type)
         * api =
 #endif
                (mpp_rt_allcator_is_valid(MPP_BUFFER_TYPE_ION)) ? allocator_ion :
-               allocator_std;
+               os_allocator_fallback();
+    } break;
+    case MPP_BUFFER_TYPE_DMA_HEAP : {
+        *api = (mpp_rt_allcator_is_valid(MPP_BUFFER_TYPE_DMA_HEAP)) ? allocator_dma_heap :
+#if HAVE_DRM
+               (mpp_rt_allcator_is_valid(MPP_BUFFER_TYPE_DRM)) ? allocator_drm :
+#endif
+               (mpp_rt_allcator_is_valid(MPP_BUFFER_TYPE_ION)) ? allocator_ion :
+               os_allocator_fallback();
     } break;
     default : {
         ret = MPP_NOK;
@@ -140,14 +140,20 @@ MPP_RET mpp_allocator_get(MppAllocator *allocator,
     }
 
 
+    MppAllocatorCfg cfg = {
+        .alignment = SZ_4K,
+        .flags = flags,
+    };
     MPP_RET ret = os_allocator_get(&p->os_api, buffer_type);
 
-    if (MPP_OK == ret) {
-        MppAllocatorCfg cfg = {
-            .alignment = SZ_4K,
-            .flags = flags,
-        };
+    if (MPP_OK == ret)
         ret = p->os_api.open(&p->ctx, &cfg);
+
+    /* no dma heap matches the cache flag then try the drm / ion types */
+    if (MPP_OK != ret && buffer_type == MPP_BUFFER_TYPE_DMA_HEAP) {
+        ret = os_allocator_get(&p->os_api, MPP_BUFFER_TYPE_DRM);
+        if (MPP_OK == ret)
+            ret = p->os_api.open(&p->ctx, &cfg);
     }
     if (MPP_OK == ret) {
         pthread_mutexattr_t attr;
@@ -185,3 +191,9 @@ MPP_RET mpp_allocator_put(MppAllocator *allocator)
     return MPP_OK;
 }
 
+MppBufferType mpp_allocator_get_type(MppAllocator allocator)
+{
+    MppAllocatorImpl *p = (MppAllocatorImpl *)allocator;
+
+    return (p) ? p->os_api.type : MPP_BUFFER_TYPE_NORMAL;
+}
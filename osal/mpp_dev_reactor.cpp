@@ -0,0 +1,357 @@
+/*
+ * Copyright 2020 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_dev_reactor"
+
+#include <poll.h>
+#include <stdio.h>
+#include <errno.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_list.h"
+#include "mpp_thread.h"
+#include "mpp_eventfd.h"
+#include "mpp_mem_pool.h"
+#include "mpp_dev_reactor.h"
+
+#define MAX_REACTOR_ID          (32)
+
+typedef struct MppDevReq_t {
+    struct list_head    list;
+    RK_S32              fd;
+    void                *owner;
+    MppDevReactorDone   done;
+    void                *ctx;
+} MppDevReq;
+
+typedef struct MppDevReactorImpl_t {
+    RK_U32              id;
+    RK_S32              ref_count;
+    MppThread           *thread;
+    pthread_t           tid;
+    /* eventfd to wake the thread up for new request and quit */
+    RK_S32              wakeup;
+
+    /* protected by thread work lock */
+    struct list_head    reqs;
+    RK_S32              req_count;
+    RK_U32              quit;
+    void                *running;
+    Condition           *sync_cond;
+} MppDevReactorImpl;
+
+static Mutex reactor_lock;
+static MppDevReactorImpl *reactors[MAX_REACTOR_ID];
+
+static MppMemPool get_req_pool()
+{
+    static MppMemPool pool = mpp_mem_pool_init(MODULE_TAG, sizeof(MppDevReq));
+    return pool;
+}
+
+static void reactor_done(MppDevReactorImpl *p, MppDevReq *req)
+{
+    MppThread *thd = p->thread;
+
+    {
+        AutoMutex autolock(thd->mutex());
+        list_del_init(&req->list);
+        p->req_count--;
+        p->running = req->owner;
+    }
+
+    req->done(req->ctx);
+
+    {
+        AutoMutex autolock(thd->mutex());
+        p->running = NULL;
+        p->sync_cond->broadcast();
+    }
+
+    mpp_mem_pool_put(get_req_pool(), req);
+}
+
+static void *reactor_thread(void *arg)
+{
+    MppDevReactorImpl *p = (MppDevReactorImpl *)arg;
+    MppThread *thd = p->thread;
+    struct pollfd *fds = NULL;
+    MppDevReq **reqs = NULL;
+    RK_S32 size = 0;
+
+    p->tid = pthread_self();
+
+    while (1) {
+        MppDevReq *req = NULL;
+        MppDevReq *wait = NULL;
+        RK_S32 count = 0;
+        RK_S32 i;
+
+        {
+            AutoMutex autolock(thd->mutex());
+
+            if (p->quit)
+                break;
+
+            if (size < p->req_count + 1) {
+                size = p->req_count + 1;
+                fds = mpp_realloc(fds, struct pollfd, size);
+                reqs = mpp_realloc(reqs, MppDevReq *, size);
+                if (NULL == fds || NULL == reqs) {
+                    mpp_err_f("failed to malloc %d poll fds\n", size);
+                    break;
+                }
+            }
+
+            /* requests are only removed on this thread so they stay valid */
+            list_for_each_entry(req, &p->reqs, MppDevReq, list) {
+                /* request without done fd waits the hardware on this thread */
+                if (req->fd < 0) {
+                    wait = req;
+                    break;
+                }
+
+                fds[count + 1].fd = req->fd;
+                fds[count + 1].events = POLLIN;
+                fds[count + 1].revents = 0;
+                reqs[count++] = req;
+            }
+        }
+
+        if (wait) {
+            reactor_done(p, wait);
+            continue;
+        }
+
+        fds[0].fd = p->wakeup;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+
+        if (poll(fds, count + 1, -1) < 0) {
+            if (errno != EINTR)
+                mpp_err_f("poll failed errno %d\n", errno);
+            continue;
+        }
+
+        if (fds[0].revents & POLLIN)
+            mpp_eventfd_read(p->wakeup, NULL, 0);
+
+        for (i = 0; i < count; i++) {
+            if (fds[i + 1].revents)
+                reactor_done(p, reqs[i]);
+        }
+    }
+
+    MPP_FREE(fds);
+    MPP_FREE(reqs);
+
+    return NULL;
+}
+
+static RK_U32 reactor_on_thread(MppDevReactorImpl *p)
+{
+    return p->tid && pthread_equal(p->tid, pthread_self());
+}
+
+MPP_RET mpp_dev_reactor_get(MppDevReactor *reactor, RK_U32 id)
+{
+    MppDevReactorImpl *p = NULL;
+
+    if (NULL == reactor || id >= MAX_REACTOR_ID) {
+        mpp_err_f("invalid input reactor %p id %d\n", reactor, id);
+        return MPP_ERR_VALUE;
+    }
+
+    *reactor = NULL;
+
+    AutoMutex autolock(&reactor_lock);
+
+    p = reactors[id];
+    if (NULL == p) {
+        char name[16];
+
+        p = mpp_calloc(MppDevReactorImpl, 1);
+        if (NULL == p) {
+            mpp_err_f("failed to malloc reactor %d\n", id);
+            return MPP_ERR_MALLOC;
+        }
+
+        p->wakeup = mpp_eventfd_get(0);
+        if (p->wakeup < 0) {
+            mpp_err_f("failed to get eventfd ret %d\n", p->wakeup);
+            mpp_free(p);
+            return MPP_NOK;
+        }
+
+        snprintf(name, sizeof(name), "mpp_dev_rx%d", id);
+        INIT_LIST_HEAD(&p->reqs);
+        p->id = id;
+        p->sync_cond = new Condition();
+        p->thread = new MppThread(reactor_thread, p, name);
+        p->thread->start();
+        if (MPP_THREAD_UNINITED == p->thread->get_status()) {
+            mpp_err_f("failed to start reactor %d thread\n", id);
+            delete p->thread;
+            delete p->sync_cond;
+            mpp_eventfd_put(p->wakeup);
+            mpp_free(p);
+            return MPP_NOK;
+        }
+
+        reactors[id] = p;
+    }
+
+    p->ref_count++;
+    *reactor = p;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_reactor_put(MppDevReactor reactor)
+{
+    MppDevReactorImpl *p = (MppDevReactorImpl *)reactor;
+
+    if (NULL == p) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    /* the last put would join the thread from itself */
+    if (reactor_on_thread(p)) {
+        mpp_err_f("reactor %d can not be put from its done callback\n", p->id);
+        return MPP_NOK;
+    }
+
+    {
+        AutoMutex autolock(&reactor_lock);
+
+        if (--p->ref_count > 0)
+            return MPP_OK;
+
+        reactors[p->id] = NULL;
+    }
+
+    {
+        AutoMutex autolock(p->thread->mutex());
+
+        if (p->req_count)
+            mpp_err_f("reactor %d quit with %d requests\n", p->id, p->req_count);
+
+        p->quit = 1;
+    }
+
+    mpp_eventfd_write(p->wakeup, 1);
+    p->thread->stop();
+
+    while (!list_empty(&p->reqs)) {
+        MppDevReq *req = list_entry(p->reqs.next, MppDevReq, list);
+
+        list_del_init(&req->list);
+        mpp_mem_pool_put(get_req_pool(), req);
+    }
+
+    delete p->thread;
+    delete p->sync_cond;
+    mpp_eventfd_put(p->wakeup);
+    mpp_free(p);
+
+    return MPP_OK;
+}
+
+static RK_U32 reactor_has_owner(MppDevReactorImpl *p, void *owner)
+{
+    MppDevReq *req = NULL;
+
+    if (p->running == owner)
+        return 1;
+
+    list_for_each_entry(req, &p->reqs, MppDevReq, list) {
+        if (req->owner == owner)
+            return 1;
+    }
+
+    return 0;
+}
+
+MPP_RET mpp_dev_reactor_submit(MppDevReactor reactor, RK_S32 fd, void *owner,
+                               MppDevReactorDone done, void *ctx)
+{
+    MppDevReactorImpl *p = (MppDevReactorImpl *)reactor;
+    MppDevReq *req = NULL;
+
+    if (NULL == p || NULL == done) {
+        mpp_err_f("invalid input reactor %p fd %d done %p\n", p, fd, done);
+        return MPP_ERR_VALUE;
+    }
+
+    req = (MppDevReq *)mpp_mem_pool_get(get_req_pool());
+    if (NULL == req) {
+        mpp_err_f("failed to get request\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    INIT_LIST_HEAD(&req->list);
+    req->fd     = fd;
+    req->owner  = owner;
+    req->done   = done;
+    req->ctx    = ctx;
+
+    {
+        AutoMutex autolock(p->thread->mutex());
+        MppDevReq *pos = NULL;
+
+        /* running owner may submit its next request from the done callback */
+        list_for_each_entry(pos, &p->reqs, MppDevReq, list) {
+            if (pos->owner == owner) {
+                mpp_err_f("owner %p already has a request in flight\n", owner);
+                mpp_mem_pool_put(get_req_pool(), req);
+                return MPP_NOK;
+            }
+        }
+
+        list_add_tail(&req->list, &p->reqs);
+        p->req_count++;
+    }
+
+    mpp_eventfd_write(p->wakeup, 1);
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_reactor_sync(MppDevReactor reactor, void *owner)
+{
+    MppDevReactorImpl *p = (MppDevReactorImpl *)reactor;
+
+    if (NULL == p) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    MppThread *thd = p->thread;
+    AutoMutex autolock(thd->mutex());
+
+    /* the callback of owner would wait for itself */
+    if (reactor_on_thread(p) && p->running == owner) {
+        mpp_err_f("owner %p can not sync from its done callback\n", owner);
+        return MPP_NOK;
+    }
+
+    while (reactor_has_owner(p, owner))
+        p->sync_cond->wait(thd->mutex());
+
+    return MPP_OK;
+}
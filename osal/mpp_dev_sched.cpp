@@ -0,0 +1,288 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_dev_sched"
+
+#include <stdint.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_list.h"
+#include "mpp_time.h"
+#include "mpp_thread.h"
+#include "mpp_dev_sched.h"
+
+#define MAX_SCHED_ID            (32)
+#define SCHED_WEIGHT_DEFAULT    (16)
+
+typedef struct MppDevSchedImpl_t MppDevSchedImpl;
+
+typedef struct MppDevSchedChanImpl_t {
+    /* node in waiting list sorted by deadline */
+    struct list_head    list;
+    MppDevSchedImpl     *sched;
+
+    RK_S64              period;
+    RK_S32              weight;
+
+    RK_S64              deadline;
+    RK_S64              time_req;
+    RK_S64              time_run;
+    RK_S32              running;
+
+    MppDevSchedStat     stat;
+} MppDevSchedChanImpl;
+
+struct MppDevSchedImpl_t {
+    RK_U32              id;
+    RK_S32              ref_count;
+    RK_S32              depth;
+
+    /* protected by lock */
+    Mutex               *lock;
+    Condition           *cond;
+    struct list_head    waits;
+    RK_S32              running;
+};
+
+static Mutex sched_lock;
+static MppDevSchedImpl *scheds[MAX_SCHED_ID];
+
+MPP_RET mpp_dev_sched_get(MppDevSched *sched, RK_U32 id, RK_S32 depth)
+{
+    MppDevSchedImpl *p = NULL;
+
+    if (NULL == sched || id >= MAX_SCHED_ID) {
+        mpp_err_f("invalid input sched %p id %d\n", sched, id);
+        return MPP_ERR_VALUE;
+    }
+
+    *sched = NULL;
+
+    AutoMutex autolock(&sched_lock);
+
+    p = scheds[id];
+    if (NULL == p) {
+        p = mpp_calloc(MppDevSchedImpl, 1);
+        if (NULL == p) {
+            mpp_err_f("failed to malloc sched %d\n", id);
+            return MPP_ERR_MALLOC;
+        }
+
+        INIT_LIST_HEAD(&p->waits);
+        p->id = id;
+        p->depth = depth > 0 ? depth : 1;
+        p->lock = new Mutex();
+        p->cond = new Condition();
+
+        scheds[id] = p;
+    }
+
+    p->ref_count++;
+    *sched = p;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_sched_put(MppDevSched sched)
+{
+    MppDevSchedImpl *p = (MppDevSchedImpl *)sched;
+
+    if (NULL == p) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    {
+        AutoMutex autolock(&sched_lock);
+
+        if (--p->ref_count > 0)
+            return MPP_OK;
+
+        scheds[p->id] = NULL;
+    }
+
+    if (!list_empty(&p->waits) || p->running)
+        mpp_err_f("sched %d put with running %d\n", p->id, p->running);
+
+    delete p->cond;
+    delete p->lock;
+    mpp_free(p);
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_sched_chan_add(MppDevSched sched, MppDevSchedChan *chan)
+{
+    MppDevSchedChanImpl *c = NULL;
+
+    if (NULL == sched || NULL == chan) {
+        mpp_err_f("invalid input sched %p chan %p\n", sched, chan);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    c = mpp_calloc(MppDevSchedChanImpl, 1);
+    if (NULL == c) {
+        mpp_err_f("failed to malloc channel\n");
+        *chan = NULL;
+        return MPP_ERR_MALLOC;
+    }
+
+    INIT_LIST_HEAD(&c->list);
+    c->sched = (MppDevSchedImpl *)sched;
+    c->weight = SCHED_WEIGHT_DEFAULT;
+    *chan = c;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_sched_chan_del(MppDevSchedChan chan)
+{
+    MppDevSchedChanImpl *c = (MppDevSchedChanImpl *)chan;
+
+    if (NULL == c) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    /* release the slot of a task which is never waited */
+    mpp_dev_sched_end(c);
+    mpp_free(c);
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_sched_chan_set(MppDevSchedChan chan, RK_S64 period, RK_S32 weight)
+{
+    MppDevSchedChanImpl *c = (MppDevSchedChanImpl *)chan;
+
+    if (NULL == c) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    AutoMutex autolock(c->sched->lock);
+
+    c->period = period > 0 ? period : 0;
+    c->weight = weight > 0 ? weight : SCHED_WEIGHT_DEFAULT;
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_sched_begin(MppDevSchedChan chan)
+{
+    MppDevSchedChanImpl *c = (MppDevSchedChanImpl *)chan;
+    MppDevSchedImpl *p = NULL;
+    struct list_head *pos = NULL;
+    RK_S64 wait;
+
+    if (NULL == c) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    p = c->sched;
+
+    AutoMutex autolock(p->lock);
+
+    if (c->running) {
+        mpp_err_f("channel %p begin twice\n", c);
+        return MPP_NOK;
+    }
+
+    c->time_req = mpp_time();
+    /* channel without period runs after all channels with deadline */
+    c->deadline = c->period ?
+                  c->time_req + c->period * SCHED_WEIGHT_DEFAULT / c->weight :
+                  INT64_MAX;
+
+    /* keep request order for equal deadline */
+    pos = p->waits.next;
+    while (pos != &p->waits &&
+           list_entry(pos, MppDevSchedChanImpl, list)->deadline <= c->deadline)
+        pos = pos->next;
+    list_add_tail(&c->list, pos);
+
+    while (p->running >= p->depth || p->waits.next != &c->list)
+        p->cond->wait(p->lock);
+
+    list_del_init(&c->list);
+    p->running++;
+    c->running = 1;
+    c->time_run = mpp_time();
+
+    wait = c->time_run - c->time_req;
+    c->stat.wait_sum += wait;
+    if (c->stat.wait_max < wait)
+        c->stat.wait_max = wait;
+
+    /* next waiting channel may also fit in the device queue */
+    if (p->running < p->depth && !list_empty(&p->waits))
+        p->cond->broadcast();
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_sched_end(MppDevSchedChan chan)
+{
+    MppDevSchedChanImpl *c = (MppDevSchedChanImpl *)chan;
+    MppDevSchedImpl *p = NULL;
+    RK_S64 now;
+    RK_S64 run;
+
+    if (NULL == c) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    p = c->sched;
+
+    AutoMutex autolock(p->lock);
+
+    if (!c->running)
+        return MPP_OK;
+
+    now = mpp_time();
+    run = now - c->time_run;
+
+    c->running = 0;
+    c->stat.count++;
+    c->stat.run_sum += run;
+    if (c->stat.run_max < run)
+        c->stat.run_max = run;
+    if (c->period && now > c->deadline)
+        c->stat.miss++;
+
+    p->running--;
+    p->cond->broadcast();
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dev_sched_stat(MppDevSchedChan chan, MppDevSchedStat *stat)
+{
+    MppDevSchedChanImpl *c = (MppDevSchedChanImpl *)chan;
+
+    if (NULL == c || NULL == stat) {
+        mpp_err_f("invalid input chan %p stat %p\n", c, stat);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    AutoMutex autolock(c->sched->lock);
+    *stat = c->stat;
+
+    return MPP_OK;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2020 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_dmabuf"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/ioctl.h>
+
+#include "mpp_log.h"
+#include "mpp_dmabuf.h"
+
+/* from linux/dma-buf.h for toolchain without it */
+typedef struct DmaBufSync_t {
+    RK_U64  flags;
+} DmaBufSync;
+
+/* range sync on Rockchip kernel */
+typedef struct DmaBufSyncPartial_t {
+    RK_U64  flags;
+    RK_U32  offset;
+    RK_U32  len;
+} DmaBufSyncPartial;
+
+#define DMABUF_SYNC_READ            (1 << 0)
+#define DMABUF_SYNC_WRITE           (2 << 0)
+#define DMABUF_SYNC_RW              (DMABUF_SYNC_READ | DMABUF_SYNC_WRITE)
+#define DMABUF_SYNC_START           (0 << 2)
+#define DMABUF_SYNC_END             (1 << 2)
+
+#define DMABUF_BASE                 'b'
+#define DMABUF_IOCTL_SYNC           _IOW(DMABUF_BASE, 0, DmaBufSync)
+#define DMABUF_IOCTL_SYNC_PARTIAL   _IOW(DMABUF_BASE, 2, DmaBufSyncPartial)
+
+// cleared on the first kernel without partial sync
+static RK_U32 dmabuf_partial_valid = 1;
+
+static MPP_RET dmabuf_sync(RK_S32 fd, RK_U64 flags, RK_U32 offset, RK_U32 length,
+                           const char *caller)
+{
+    RK_S32 ret;
+
+    if (fd < 0) {
+        mpp_err_f("invalid fd %d from %s\n", fd, caller);
+        return MPP_ERR_VALUE;
+    }
+
+    if (length && dmabuf_partial_valid) {
+        DmaBufSyncPartial sync;
+
+        sync.flags = flags;
+        sync.offset = offset;
+        sync.len = length;
+
+        do {
+            ret = ioctl(fd, DMABUF_IOCTL_SYNC_PARTIAL, &sync);
+        } while (ret < 0 && (errno == EINTR || errno == EAGAIN));
+
+        if (!ret)
+            return MPP_OK;
+
+        if (errno != ENOTTY && errno != EINVAL) {
+            mpp_err_f("fd %d partial sync failed %s from %s\n", fd,
+                      strerror(errno), caller);
+            return MPP_NOK;
+        }
+
+        dmabuf_partial_valid = 0;
+    }
+
+    {
+        DmaBufSync sync;
+
+        sync.flags = flags;
+
+        do {
+            ret = ioctl(fd, DMABUF_IOCTL_SYNC, &sync);
+        } while (ret < 0 && (errno == EINTR || errno == EAGAIN));
+    }
+
+    if (ret) {
+        mpp_err_f("fd %d sync failed %s from %s\n", fd, strerror(errno), caller);
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_dmabuf_sync_begin(RK_S32 fd, RK_S32 ro, RK_U32 offset, RK_U32 length,
+                              const char *caller)
+{
+    RK_U64 flags = DMABUF_SYNC_START | (ro ? DMABUF_SYNC_READ : DMABUF_SYNC_RW);
+
+    return dmabuf_sync(fd, flags, offset, length, caller);
+}
+
+MPP_RET mpp_dmabuf_sync_end(RK_S32 fd, RK_S32 ro, RK_U32 offset, RK_U32 length,
+                            const char *caller)
+{
+    RK_U64 flags = DMABUF_SYNC_END | (ro ? DMABUF_SYNC_READ : DMABUF_SYNC_RW);
+
+    return dmabuf_sync(fd, flags, offset, length, caller);
+}
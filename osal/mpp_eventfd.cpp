@@ -26,7 +26,7 @@ RK_S32 mpp_eventfd_get(RK_U32 init)
     RK_S32 fd = eventfd(init, 0);
 
     if (fd < 0)
-        fd = errno;
+        fd = -errno;
 
     return fd;
 }
@@ -61,6 +61,22 @@ RK_S32 mpp_eventfd_read(RK_S32 fd, RK_U64 *val, RK_S64 timeout)
     return ret;
 }
 
+RK_S32 mpp_eventfd_poll(RK_S32 fd, RK_S64 timeout)
+{
+    struct pollfd nfds;
+    RK_S32 ret = 0;
+
+    nfds.fd = fd;
+    nfds.events = POLLIN;
+    nfds.revents = 0;
+
+    ret = poll(&nfds, 1, timeout);
+    if (ret == 1 && (nfds.revents & POLLIN))
+        return 0;
+
+    return (ret < 0) ? errno : ETIMEDOUT;
+}
+
 RK_S32 mpp_eventfd_write(RK_S32 fd, RK_U64 val)
 {
     RK_S32 ret = 0;
@@ -23,6 +23,7 @@
 
 #include "mpp_log.h"
 #include "mpp_list.h"
+#include "mpp_mem_pool.h"
 
 
 #define LIST_DEBUG(fmt, ...) mpp_log(fmt, ## __VA_ARGS__)
@@ -37,6 +38,35 @@ typedef struct mpp_list_node {
     RK_S32          size;
 } mpp_list_node;
 
+/*
+ * Nodes with small payload come from a fixed size pool. The payload size is
+ * kept in node->size so the release path can tell which allocator was used.
+ */
+#define LIST_NODE_POOL_DATA     (32)
+#define LIST_NODE_POOL_SIZE     (sizeof(mpp_list_node) + sizeof(RK_S32) + LIST_NODE_POOL_DATA)
+
+static MppMemPool get_node_pool()
+{
+    static MppMemPool pool = mpp_mem_pool_init(MODULE_TAG, LIST_NODE_POOL_SIZE);
+    return pool;
+}
+
+static mpp_list_node *alloc_node(RK_S32 size, size_t alloc_size)
+{
+    if (size <= LIST_NODE_POOL_DATA)
+        return (mpp_list_node *)mpp_mem_pool_get(get_node_pool());
+
+    return (mpp_list_node *)malloc(alloc_size);
+}
+
+static void free_node(mpp_list_node *node)
+{
+    if (node->size <= LIST_NODE_POOL_DATA)
+        mpp_mem_pool_put(get_node_pool(), node);
+    else
+        free(node);
+}
+
 static inline void list_node_init(mpp_list_node *node)
 {
     node->prev = node->next = node;
@@ -51,7 +81,7 @@ static inline void list_node_init_with_key_and_size(mpp_list_node *node, RK_U32
 
 static mpp_list_node* create_list(void *data, RK_S32 size, RK_U32 key)
 {
-    mpp_list_node *node = (mpp_list_node*)malloc(sizeof(mpp_list_node) + size);
+    mpp_list_node *node = alloc_node(size, sizeof(mpp_list_node) + size);
     if (node) {
         void *dst = (void*)(node + 1);
         list_node_init_with_key_and_size(node, key, size);
@@ -124,7 +154,7 @@ static void release_list(mpp_list_node*node, void *data, RK_S32 size)
         if (data)
             memcpy(data, src, size);
     }
-    free(node);
+    free_node(node);
 }
 
 static inline void _mpp_list_del(mpp_list_node *prev, mpp_list_node *next)
@@ -169,8 +199,8 @@ RK_S32 mpp_list::del_at_tail(void *data, RK_S32 size)
 
 static mpp_list_node* create_list_with_size(void *data, RK_S32 size, RK_U32 key)
 {
-    mpp_list_node *node = (mpp_list_node*)malloc(sizeof(mpp_list_node) +
-                                                 sizeof(size) + size);
+    mpp_list_node *node = alloc_node(size, sizeof(mpp_list_node) +
+                                     sizeof(size) + size);
     if (node) {
         RK_S32 *dst = (RK_S32 *)(node + 1);
         list_node_init_with_key_and_size(node, key, size);
@@ -208,7 +238,7 @@ static void release_list_with_size(mpp_list_node* node, void *data, RK_S32 *size
     if (data)
         memcpy(data, src, data_size);
 
-    free(node);
+    free_node(node);
 }
 
 RK_S32 mpp_list::fifo_rd(void *data, RK_S32 *size)
@@ -290,7 +320,7 @@ RK_S32 mpp_list::flush()
             if (destroy) {
                 destroy((void*)(node + 1));
             }
-            free(node);
+            free_node(node);
             count--;
         }
     }
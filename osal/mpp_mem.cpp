@@ -634,28 +634,35 @@ void MppMemService::dump(const char *caller)
     }
 }
 
+/*
+ * NOTE: debug is fixed after service construction. Only the debug tracking
+ * touches the shared node / log records so only it needs the lock.
+ */
 void *mpp_osal_malloc(const char *caller, size_t size)
 {
-    AutoMutex auto_lock(&service.lock);
     RK_U32 debug = service.debug;
     size_t size_align = MEM_ALIGNED(size);
     size_t size_real = (debug & MEM_EXT_ROOM) ? (size_align + 2 * MEM_ALIGN) :
                        (size_align);
     void *ptr;
 
-    os_malloc(&ptr, MEM_ALIGN, size_real);
+    if (!debug) {
+        os_malloc(&ptr, MEM_ALIGN, size_real);
+        return ptr;
+    }
 
-    if (debug) {
-        service.add_log(MEM_MALLOC, caller, NULL, ptr, size, size_real);
+    AutoMutex auto_lock(&service.lock);
 
-        if (ptr) {
-            if (debug & MEM_EXT_ROOM) {
-                ptr = (RK_U8 *)ptr + MEM_ALIGN;
-                set_mem_ext_room(ptr, size);
-            }
+    os_malloc(&ptr, MEM_ALIGN, size_real);
+    service.add_log(MEM_MALLOC, caller, NULL, ptr, size, size_real);
 
-            service.add_node(caller, ptr, size);
+    if (ptr) {
+        if (debug & MEM_EXT_ROOM) {
+            ptr = (RK_U8 *)ptr + MEM_ALIGN;
+            set_mem_ext_room(ptr, size);
         }
+
+        service.add_node(caller, ptr, size);
     }
 
     return ptr;
@@ -671,7 +678,6 @@ void *mpp_osal_calloc(const char *caller, size_t size)
 
 void *mpp_osal_realloc(const char *caller, void *ptr, size_t size)
 {
-    AutoMutex auto_lock(&service.lock);
     RK_U32 debug = service.debug;
     void *ret;
 
@@ -688,6 +694,16 @@ void *mpp_osal_realloc(const char *caller, void *ptr, size_t size)
                        (size_align);
     void *ptr_real = (RK_U8 *)ptr - MEM_HEAD_ROOM(debug);
 
+    if (!debug) {
+        os_realloc(ptr_real, &ret, MEM_ALIGN, size_align);
+        if (NULL == ret)
+            mpp_err("mpp_realloc ptr %p to size %d failed\n", ptr, size);
+
+        return ret;
+    }
+
+    AutoMutex auto_lock(&service.lock);
+
     os_realloc(ptr_real, &ret, MEM_ALIGN, size_align);
 
     if (NULL == ret) {
@@ -710,7 +726,6 @@ void *mpp_osal_realloc(const char *caller, void *ptr, size_t size)
 
 void mpp_osal_free(const char *caller, void *ptr)
 {
-    AutoMutex auto_lock(&service.lock);
     RK_U32 debug = service.debug;
     if (NULL == ptr)
         return;
@@ -720,6 +735,7 @@ void mpp_osal_free(const char *caller, void *ptr)
         return ;
     }
 
+    AutoMutex auto_lock(&service.lock);
     size_t size = 0;
 
     if (debug & MEM_POISON) {
@@ -0,0 +1,305 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define MODULE_TAG "mpp_mem_pool"
+
+#include <string.h>
+#include <pthread.h>
+
+#include "mpp_log.h"
+#include "mpp_env.h"
+#include "mpp_mem.h"
+#include "mpp_atomic.h"
+#include "mpp_common.h"
+#include "mpp_mem_pool.h"
+
+#include "os_mem.h"
+
+#define MEM_POOL_MAX            (16)
+#define MEM_POOL_ALIGN          (16)
+#define MEM_POOL_SLAB_CNT       (32)
+#define MEM_POOL_CACHE_MAX      (64)
+
+typedef struct MppMemPoolNode_t {
+    struct MppMemPoolNode_t *next;
+} MppMemPoolNode;
+
+typedef struct MppMemPoolSlab_t {
+    struct MppMemPoolSlab_t *next;
+} MppMemPoolSlab;
+
+typedef struct MppMemPoolImpl_t {
+    const char          *name;
+    size_t              size;
+    /* slot in the thread cache, -1 for plain malloc mode */
+    RK_S32              index;
+    RK_U32              debug;
+
+    /* objects flushed from thread caches, push chain by cas and take all by xchg */
+    MppMemPoolNode      *shared;
+    MppMemPoolSlab      *slabs;
+    RK_S32              slab_count;
+} MppMemPoolImpl;
+
+typedef struct MppMemPoolCache_t {
+    MppMemPoolNode      *head[MEM_POOL_MAX];
+    RK_S32              count[MEM_POOL_MAX];
+} MppMemPoolCache;
+
+/* pool index is never reused so a stale thread cache slot is never popped */
+static MppMemPoolImpl *pools[MEM_POOL_MAX];
+static RK_S32 pool_index = 0;
+
+static pthread_key_t cache_key;
+static pthread_once_t cache_once = PTHREAD_ONCE_INIT;
+
+static void pool_push_chain(MppMemPoolImpl *impl, MppMemPoolNode *head,
+                            MppMemPoolNode *tail)
+{
+    MppMemPoolNode *old;
+
+    do {
+        old = impl->shared;
+        tail->next = old;
+    } while (!MPP_BOOL_CAS(&impl->shared, old, head));
+}
+
+static MppMemPoolNode *pool_grow(MppMemPoolImpl *impl, RK_S32 *count)
+{
+    size_t head_size = MPP_ALIGN(sizeof(MppMemPoolSlab), MEM_POOL_ALIGN);
+    MppMemPoolSlab *slab = NULL;
+    MppMemPoolSlab *old;
+    RK_U8 *buf;
+    RK_S32 i;
+
+    os_malloc((void **)&slab, MEM_POOL_ALIGN,
+              head_size + impl->size * MEM_POOL_SLAB_CNT);
+    if (NULL == slab) {
+        mpp_err_f("pool %s failed to grow\n", impl->name);
+        return NULL;
+    }
+
+    do {
+        old = impl->slabs;
+        slab->next = old;
+    } while (!MPP_BOOL_CAS(&impl->slabs, old, slab));
+    MPP_FETCH_ADD(&impl->slab_count, 1);
+
+    buf = (RK_U8 *)slab + head_size;
+    for (i = 0; i < MEM_POOL_SLAB_CNT; i++) {
+        MppMemPoolNode *node = (MppMemPoolNode *)(buf + i * impl->size);
+
+        node->next = (i + 1 < MEM_POOL_SLAB_CNT) ?
+                     (MppMemPoolNode *)(buf + (i + 1) * impl->size) : NULL;
+    }
+
+    *count = MEM_POOL_SLAB_CNT;
+    return (MppMemPoolNode *)buf;
+}
+
+/* hand the objects cached by an exiting thread back to the pools */
+static void cache_destroy(void *ctx)
+{
+    MppMemPoolCache *cache = (MppMemPoolCache *)ctx;
+    RK_S32 i;
+
+    for (i = 0; i < MEM_POOL_MAX; i++) {
+        MppMemPoolNode *head = cache->head[i];
+        MppMemPoolNode *tail = head;
+
+        if (NULL == head || NULL == pools[i])
+            continue;
+
+        while (tail->next)
+            tail = tail->next;
+
+        pool_push_chain(pools[i], head, tail);
+    }
+
+    os_free(cache);
+}
+
+static void cache_key_init(void)
+{
+    pthread_key_create(&cache_key, cache_destroy);
+}
+
+static MppMemPoolCache *get_cache(void)
+{
+    MppMemPoolCache *cache = (MppMemPoolCache *)pthread_getspecific(cache_key);
+
+    if (NULL == cache) {
+        os_malloc((void **)&cache, MEM_POOL_ALIGN, sizeof(*cache));
+        if (NULL == cache)
+            return NULL;
+
+        memset(cache, 0, sizeof(*cache));
+        pthread_setspecific(cache_key, cache);
+    }
+
+    return cache;
+}
+
+MppMemPool mpp_mem_pool_init(const char *name, size_t size)
+{
+    MppMemPoolImpl *impl = NULL;
+    RK_S32 index;
+
+    os_malloc((void **)&impl, MEM_POOL_ALIGN, sizeof(*impl));
+    if (NULL == impl) {
+        mpp_err_f("failed to create pool %s\n", name);
+        return NULL;
+    }
+
+    memset(impl, 0, sizeof(*impl));
+    impl->name = name;
+    impl->size = MPP_ALIGN(MPP_MAX(size, sizeof(MppMemPoolNode)), MEM_POOL_ALIGN);
+    mpp_env_get_u32("mpp_mem_debug", &impl->debug, 0);
+
+    pthread_once(&cache_once, cache_key_init);
+
+    index = MPP_FETCH_ADD(&pool_index, 1);
+    if (index < MEM_POOL_MAX) {
+        impl->index = index;
+        pools[index] = impl;
+    } else {
+        mpp_log_f("pool %s runs in malloc mode for no free slot\n", name);
+        impl->index = -1;
+    }
+
+    return impl;
+}
+
+void mpp_mem_pool_deinit(MppMemPool pool)
+{
+    MppMemPoolImpl *impl = (MppMemPoolImpl *)pool;
+    MppMemPoolSlab *slab;
+
+    if (NULL == impl)
+        return;
+
+    if (impl->index >= 0)
+        pools[impl->index] = NULL;
+
+    slab = impl->slabs;
+    while (slab) {
+        MppMemPoolSlab *next = slab->next;
+
+        os_free(slab);
+        slab = next;
+    }
+
+    os_free(impl);
+}
+
+void *mpp_mem_pool_get_f(const char *caller, MppMemPool pool)
+{
+    MppMemPoolImpl *impl = (MppMemPoolImpl *)pool;
+    MppMemPoolCache *cache;
+    MppMemPoolNode *node;
+    RK_S32 index;
+
+    if (NULL == impl) {
+        mpp_err_f("invalid NULL pool from %s\n", caller);
+        return NULL;
+    }
+
+    if (impl->debug || impl->index < 0)
+        return mpp_osal_calloc(caller, impl->size);
+
+    cache = get_cache();
+    if (NULL == cache)
+        return NULL;
+
+    index = impl->index;
+    node = cache->head[index];
+    if (NULL == node) {
+        RK_S32 count = 0;
+
+        node = MPP_XCHG(&impl->shared, (MppMemPoolNode *)NULL);
+        if (node) {
+            MppMemPoolNode *tmp;
+
+            for (tmp = node; tmp; tmp = tmp->next)
+                count++;
+        } else {
+            node = pool_grow(impl, &count);
+            if (NULL == node)
+                return NULL;
+        }
+
+        cache->count[index] = count;
+    }
+
+    cache->head[index] = node->next;
+    cache->count[index]--;
+    memset(node, 0, impl->size);
+
+    return node;
+}
+
+void mpp_mem_pool_put_f(const char *caller, MppMemPool pool, void *p)
+{
+    MppMemPoolImpl *impl = (MppMemPoolImpl *)pool;
+    MppMemPoolNode *node = (MppMemPoolNode *)p;
+    MppMemPoolCache *cache;
+    RK_S32 index;
+
+    if (NULL == p)
+        return;
+
+    if (NULL == impl) {
+        mpp_err_f("invalid NULL pool from %s\n", caller);
+        return;
+    }
+
+    if (impl->debug || impl->index < 0) {
+        mpp_osal_free(caller, p);
+        return;
+    }
+
+    cache = get_cache();
+    if (NULL == cache) {
+        pool_push_chain(impl, node, node);
+        return;
+    }
+
+    index = impl->index;
+    node->next = cache->head[index];
+    cache->head[index] = node;
+    cache->count[index]++;
+
+    if (cache->count[index] > MEM_POOL_CACHE_MAX) {
+        /* keep half in the thread cache and hand the rest to other threads */
+        MppMemPoolNode *tail = node;
+        MppMemPoolNode *rest;
+        RK_S32 i;
+
+        for (i = 1; i < MEM_POOL_CACHE_MAX / 2; i++)
+            tail = tail->next;
+
+        rest = tail->next;
+        tail->next = NULL;
+        cache->count[index] = MEM_POOL_CACHE_MAX / 2;
+
+        tail = rest;
+        while (tail->next)
+            tail = tail->next;
+
+        pool_push_chain(impl, rest, tail);
+    }
+}
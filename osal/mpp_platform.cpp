@@ -25,6 +25,7 @@
 #include "mpp_common.h"
 #include "mpp_platform.h"
 #include "mpp_service.h"
+#include "soft_device_api.h"
 
 #define MAX_SOC_NAME_LENGTH     128
 
@@ -242,6 +243,17 @@ MppPlatformService::MppPlatformService()
     /* read soc name */
     read_soc_name(soc_name, sizeof(soc_name));
 
+    /* stand-in software device replaces all the kernel drivers */
+    RK_U32 soft = 0;
+
+    mpp_env_get_u32("mpp_dev_soft", &soft, SOFT_DEVICE_DEFAULT);
+    if (soft) {
+        ioctl_version = IOCTL_SOFT_DEVICE;
+        mpp_env_get_u32("mpp_dev_soft_type", &vcodec_type, SOFT_DEVICE_VCODEC_TYPE);
+        mpp_log("use soft device with vcodec type %08x\n", vcodec_type);
+        goto __return;
+    }
+
     /* set vpu1 defalut for old chip without dts */
     vcodec_type = HAVE_VDPU1 | HAVE_VEPU1;
     {
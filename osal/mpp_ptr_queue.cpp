@@ -0,0 +1,212 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_ptr_queue"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "mpp_log.h"
+#include "mpp_eventfd.h"
+#include "mpp_ptr_queue.h"
+
+MppPtrQueue::MppPtrQueue(node_destructor func, RK_S32 capacity)
+    : mDestroy(func),
+      mRing(NULL),
+      mSize(0),
+      mHead(0),
+      mCount(0),
+      mLimit(0),
+      mRdFd(-1),
+      mWrFd(-1),
+      mRdReady(0),
+      mWrReady(0)
+{
+    if (capacity < 1)
+        capacity = 1;
+
+    mRing = (void **)malloc(sizeof(*mRing) * capacity);
+    if (NULL == mRing)
+        mpp_err_f("failed to allocate ring with capacity %d\n", capacity);
+    else
+        mSize = capacity;
+}
+
+MppPtrQueue::~MppPtrQueue()
+{
+    flush();
+    if (mRing)
+        free(mRing);
+    mRing = NULL;
+    mDestroy = NULL;
+
+    mpp_eventfd_put(mRdFd);
+    mpp_eventfd_put(mWrFd);
+    mRdFd = -1;
+    mWrFd = -1;
+}
+
+static void update_event(RK_S32 fd, RK_U32 *status, RK_U32 ready)
+{
+    if (fd < 0 || *status == ready)
+        return;
+
+    /* the counter is non-zero exactly while the state is ready */
+    if (ready)
+        mpp_eventfd_write(fd, 1);
+    else
+        mpp_eventfd_read(fd, NULL, 0);
+
+    *status = ready;
+}
+
+void MppPtrQueue::update_fd()
+{
+    update_event(mRdFd, &mRdReady, mCount > 0);
+    update_event(mWrFd, &mWrReady, !mLimit || mCount < mLimit);
+}
+
+void MppPtrQueue::set_limit(RK_S32 limit)
+{
+    mLimit = (limit > 0) ? limit : 0;
+    update_fd();
+}
+
+RK_S32 MppPtrQueue::get_rd_fd()
+{
+    if (mRdFd < 0) {
+        mRdFd = mpp_eventfd_get(0);
+        mRdReady = 0;
+        update_fd();
+    }
+
+    return mRdFd;
+}
+
+RK_S32 MppPtrQueue::get_wr_fd()
+{
+    if (mWrFd < 0) {
+        mWrFd = mpp_eventfd_get(0);
+        mWrReady = 0;
+        update_fd();
+    }
+
+    return mWrFd;
+}
+
+RK_S32 MppPtrQueue::grow()
+{
+    RK_S32 size = mSize ? mSize * 2 : 16;
+    void **ring = (void **)malloc(sizeof(*ring) * size);
+    RK_S32 i;
+
+    if (NULL == ring) {
+        mpp_err_f("failed to grow ring to %d\n", size);
+        return -ENOMEM;
+    }
+
+    for (i = 0; i < mCount; i++)
+        ring[i] = mRing[(mHead + i) % mSize];
+
+    if (mRing)
+        free(mRing);
+
+    mRing = ring;
+    mSize = size;
+    mHead = 0;
+    return 0;
+}
+
+RK_S32 MppPtrQueue::push(void *ptr)
+{
+    if (mCount == mSize && grow())
+        return -ENOMEM;
+
+    RK_S32 tail = mHead + mCount;
+
+    if (tail >= mSize)
+        tail -= mSize;
+
+    mRing[tail] = ptr;
+    mCount++;
+    update_fd();
+    return 0;
+}
+
+RK_S32 MppPtrQueue::pop(void **ptr)
+{
+    if (!mCount)
+        return -EINVAL;
+
+    if (ptr)
+        *ptr = mRing[mHead];
+
+    mHead++;
+    if (mHead >= mSize)
+        mHead = 0;
+    mCount--;
+    update_fd();
+    return 0;
+}
+
+RK_S32 MppPtrQueue::flush()
+{
+    while (mCount) {
+        if (mDestroy)
+            mDestroy(&mRing[mHead]);
+        pop(NULL);
+    }
+
+    mHead = 0;
+    mCondition.signal();
+    return 0;
+}
+
+void MppPtrQueue::lock()
+{
+    mMutex.lock();
+}
+
+void MppPtrQueue::unlock()
+{
+    mMutex.unlock();
+}
+
+RK_S32 MppPtrQueue::trylock()
+{
+    return mMutex.trylock();
+}
+
+Mutex *MppPtrQueue::mutex()
+{
+    return &mMutex;
+}
+
+void MppPtrQueue::wait()
+{
+    mCondition.wait(mMutex);
+}
+
+RK_S32 MppPtrQueue::wait(RK_S64 timeout)
+{
+    return mCondition.timedwait(mMutex, timeout);
+}
+
+void MppPtrQueue::signal()
+{
+    mCondition.signal();
+}
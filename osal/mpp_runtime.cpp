@@ -94,6 +94,14 @@ MppRuntimeService::MppRuntimeService()
         mpp_log("found drm allocator\n");
     }
 
+    if (access("/dev/dma_heap", F_OK | R_OK)) {
+        allocator_valid[MPP_BUFFER_TYPE_DMA_HEAP] = 0;
+        mpp_log("NOT found dma_heap allocator\n");
+    } else {
+        allocator_valid[MPP_BUFFER_TYPE_DMA_HEAP] = 1;
+        mpp_log("found dma_heap allocator\n");
+    }
+
     if ((!access("/dev/mpp_service", F_OK | R_OK | W_OK)) &&
         allocator_valid[MPP_BUFFER_TYPE_DRM]) {
         allocator_valid[MPP_BUFFER_TYPE_ION] = 0;
@@ -0,0 +1,203 @@
+/*
+ * Copyright 2020 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_dev_reactor_test"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_device.h"
+#include "mpp_dev_reactor.h"
+
+#define REACTOR_TEST_REQS   2
+
+typedef struct ReactorTestReq_t {
+    MppDevReactor   reactor;
+    RK_S32          fd;
+    RK_U32          latency;
+    /* set in done callback */
+    RK_S32          order;
+    MPP_RET         sync_ret;
+} ReactorTestReq;
+
+static RK_S32 done_cnt = 0;
+
+static void reactor_test_done(void *ctx)
+{
+    ReactorTestReq *p = (ReactorTestReq *)ctx;
+
+    p->order = done_cnt++;
+    /* waiting for itself is refused instead of dead lock */
+    p->sync_ret = mpp_dev_reactor_sync(p->reactor, p);
+}
+
+/* request without fd does the blocking wait in its callback */
+static void reactor_test_wait(void *ctx)
+{
+    ReactorTestReq *p = (ReactorTestReq *)ctx;
+
+    usleep(p->latency);
+    reactor_test_done(ctx);
+}
+
+static RK_S32 reactor_test_timer(RK_U32 latency)
+{
+    struct itimerspec its;
+    RK_S32 fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+    if (fd < 0)
+        return fd;
+
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = latency / 1000000;
+    its.it_value.tv_nsec = (latency % 1000000) * 1000;
+    timerfd_settime(fd, 0, &its, NULL);
+
+    return fd;
+}
+
+/* fd requests finish by their fd, the first submitted finishes last */
+static RK_S32 reactor_test_fd(MppDevReactor reactor)
+{
+    ReactorTestReq reqs[REACTOR_TEST_REQS] = {
+        { reactor, -1, 40000, -1, MPP_OK, },
+        { reactor, -1, 10000, -1, MPP_OK, },
+    };
+    RK_S32 errors = 0;
+    RK_S32 i;
+
+    done_cnt = 0;
+
+    for (i = 0; i < REACTOR_TEST_REQS; i++) {
+        ReactorTestReq *p = &reqs[i];
+
+        p->fd = reactor_test_timer(p->latency);
+        if (mpp_dev_reactor_submit(reactor, p->fd, p, reactor_test_done, p))
+            errors++;
+
+        /* one request in flight per owner */
+        if (!mpp_dev_reactor_submit(reactor, p->fd, p, reactor_test_done, p))
+            errors++;
+    }
+
+    for (i = 0; i < REACTOR_TEST_REQS; i++) {
+        ReactorTestReq *p = &reqs[i];
+
+        mpp_dev_reactor_sync(reactor, p);
+
+        mpp_log("fd req %d latency %d us done order %d\n", i, p->latency, p->order);
+
+        if (p->order != REACTOR_TEST_REQS - 1 - i || !p->sync_ret)
+            errors++;
+
+        close(p->fd);
+    }
+
+    return errors;
+}
+
+/* requests without fd finish in submit order */
+static RK_S32 reactor_test_wait_order(MppDevReactor reactor)
+{
+    ReactorTestReq reqs[REACTOR_TEST_REQS] = {
+        { reactor, -1, 20000, -1, MPP_OK, },
+        { reactor, -1, 10000, -1, MPP_OK, },
+    };
+    RK_S32 errors = 0;
+    RK_S32 i;
+
+    done_cnt = 0;
+
+    for (i = 0; i < REACTOR_TEST_REQS; i++) {
+        if (mpp_dev_reactor_submit(reactor, -1, &reqs[i], reactor_test_wait, &reqs[i]))
+            errors++;
+    }
+
+    for (i = 0; i < REACTOR_TEST_REQS; i++) {
+        ReactorTestReq *p = &reqs[i];
+
+        mpp_dev_reactor_sync(reactor, p);
+
+        mpp_log("wait req %d latency %d us done order %d\n", i, p->latency, p->order);
+
+        if (p->order != i || !p->sync_ret)
+            errors++;
+    }
+
+    return errors;
+}
+
+/* MPP_DEV_CMD_POLL of the soft device waits on the reactor */
+static RK_S32 reactor_test_dev(void)
+{
+    MppDev dev = NULL;
+    RK_S32 errors = 0;
+    RK_S64 start;
+    RK_S64 time;
+
+    setenv("mpp_dev_soft", "1", 1);
+    setenv("mpp_dev_soft_latency", "20000", 1);
+    setenv("mpp_dev_async_poll", "1", 1);
+
+    if (mpp_dev_init(&dev, VPU_CLIENT_RKVDEC)) {
+        mpp_err("mpp_dev_init failed\n");
+        return 1;
+    }
+
+    start = mpp_time();
+    mpp_dev_ioctl(dev, MPP_DEV_CMD_SEND, NULL);
+    if (mpp_dev_ioctl(dev, MPP_DEV_CMD_POLL, NULL))
+        errors++;
+    time = mpp_time() - start;
+
+    mpp_log("dev poll %lld us\n", time);
+
+    if (time < 20000)
+        errors++;
+
+    mpp_dev_deinit(dev);
+
+    return errors;
+}
+
+int main()
+{
+    MppDevReactor reactor = NULL;
+    RK_S32 errors = 0;
+
+    mpp_log("mpp_dev_reactor_test start\n");
+
+    if (mpp_dev_reactor_get(&reactor, VPU_CLIENT_RKVDEC)) {
+        mpp_err("mpp_dev_reactor_get failed\n");
+        return -1;
+    }
+
+    errors += reactor_test_fd(reactor);
+    errors += reactor_test_wait_order(reactor);
+
+    mpp_dev_reactor_put(reactor);
+
+    errors += reactor_test_dev();
+
+    mpp_log("mpp_dev_reactor_test %s\n", errors ? "failed" : "success");
+
+    return errors;
+}
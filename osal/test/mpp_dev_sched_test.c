@@ -0,0 +1,155 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_dev_sched_test"
+
+#include <pthread.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_dev_sched.h"
+
+#define SCHED_TEST_CHANS    4
+
+typedef struct SchedTestChan_t {
+    MppDevSchedChan chan;
+    RK_S64          period;
+    RK_S32          expect;
+    RK_S32          order;
+} SchedTestChan;
+
+static RK_S32 grant_cnt = 0;
+
+static void *sched_test_thread(void *arg)
+{
+    SchedTestChan *p = (SchedTestChan *)arg;
+
+    mpp_dev_sched_begin(p->chan);
+    p->order = __sync_fetch_and_add(&grant_cnt, 1);
+    /* fake hardware run time */
+    msleep(1);
+    mpp_dev_sched_end(p->chan);
+
+    return NULL;
+}
+
+/* the channel with the earliest deadline should get the device first */
+static RK_S32 sched_test_edf(void)
+{
+    /* channel without period runs after all channels with deadline */
+    SchedTestChan chans[SCHED_TEST_CHANS] = {
+        { NULL,      0, 3, -1, },
+        { NULL, 300000, 2, -1, },
+        { NULL, 200000, 1, -1, },
+        { NULL, 100000, 0, -1, },
+    };
+    pthread_t threads[SCHED_TEST_CHANS];
+    MppDevSchedChan owner = NULL;
+    MppDevSched sched = NULL;
+    MppDevSchedStat stat;
+    RK_S32 errors = 0;
+    RK_S32 i;
+
+    if (mpp_dev_sched_get(&sched, 0, 1) ||
+        mpp_dev_sched_chan_add(sched, &owner)) {
+        mpp_err("failed to get sched\n");
+        return -1;
+    }
+
+    /* hold the device while all the other channels are queued */
+    mpp_dev_sched_begin(owner);
+
+    for (i = 0; i < SCHED_TEST_CHANS; i++) {
+        mpp_dev_sched_chan_add(sched, &chans[i].chan);
+        mpp_dev_sched_chan_set(chans[i].chan, chans[i].period, 0);
+        pthread_create(&threads[i], NULL, sched_test_thread, &chans[i]);
+        msleep(5);
+    }
+
+    mpp_dev_sched_end(owner);
+
+    for (i = 0; i < SCHED_TEST_CHANS; i++)
+        pthread_join(threads[i], NULL);
+
+    for (i = 0; i < SCHED_TEST_CHANS; i++) {
+        mpp_dev_sched_stat(chans[i].chan, &stat);
+        mpp_log("chan %d period %lld order %d wait %lld run %lld us\n", i,
+                chans[i].period, chans[i].order, stat.wait_sum, stat.run_sum);
+
+        if (chans[i].order != chans[i].expect || stat.count != 1)
+            errors++;
+
+        mpp_dev_sched_chan_del(chans[i].chan);
+    }
+
+    mpp_dev_sched_chan_del(owner);
+    mpp_dev_sched_put(sched);
+
+    return errors;
+}
+
+/* depth two allows a second channel on the device before the first ends */
+static RK_S32 sched_test_depth(void)
+{
+    MppDevSched sched = NULL;
+    MppDevSchedChan chan[2];
+    MppDevSchedStat stat;
+    RK_S32 errors = 0;
+
+    if (mpp_dev_sched_get(&sched, 1, 2) ||
+        mpp_dev_sched_chan_add(sched, &chan[0]) ||
+        mpp_dev_sched_chan_add(sched, &chan[1])) {
+        mpp_err("failed to get sched\n");
+        return -1;
+    }
+
+    mpp_dev_sched_chan_set(chan[0], 1000, 0);
+    mpp_dev_sched_begin(chan[0]);
+    mpp_dev_sched_begin(chan[1]);
+    msleep(5);
+    mpp_dev_sched_end(chan[1]);
+    mpp_dev_sched_end(chan[0]);
+
+    /* chan 0 finished after its 1ms deadline */
+    mpp_dev_sched_stat(chan[0], &stat);
+    if (stat.count != 1 || stat.miss != 1)
+        errors++;
+
+    /* chan 1 has no deadline */
+    mpp_dev_sched_stat(chan[1], &stat);
+    if (stat.count != 1 || stat.miss)
+        errors++;
+
+    mpp_dev_sched_chan_del(chan[0]);
+    mpp_dev_sched_chan_del(chan[1]);
+    mpp_dev_sched_put(sched);
+
+    return errors;
+}
+
+int main()
+{
+    RK_S32 errors = 0;
+
+    mpp_log("mpp_dev_sched_test start\n");
+
+    errors += sched_test_edf();
+    errors += sched_test_depth();
+
+    mpp_log("mpp_dev_sched_test %s\n", errors ? "failed" : "success");
+
+    return errors;
+}
@@ -127,6 +127,19 @@ int main()
             wr_val, wr_ret, rd_val, rd_ret,
             (wr_val != rd_val) ? "success" : "failed");
 
+    reset_test();
+    {
+        RK_S32 ret0, ret1, ret2;
+
+        mpp_eventfd_write(data_fd, wr_val);
+        ret0 = mpp_eventfd_poll(data_fd, 0);
+        ret1 = mpp_eventfd_poll(data_fd, 0);
+        mpp_eventfd_read(data_fd, NULL, 0);
+        ret2 = mpp_eventfd_poll(data_fd, 0);
+        mpp_log("eventfd poll      mode test ret %d %d %d - %s\n", ret0, ret1, ret2,
+                (!ret0 && !ret1 && ret2) ? "success" : "failed");
+    }
+
     mpp_eventfd_put(data_fd);
     mpp_eventfd_put(sync_fd);
 
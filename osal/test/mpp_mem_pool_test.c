@@ -0,0 +1,119 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define MODULE_TAG "mpp_mem_pool_test"
+
+#include <string.h>
+#include <pthread.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_mem_pool.h"
+
+#define POOL_TEST_THREADS   4
+#define POOL_TEST_OBJS      256
+#define POOL_TEST_LOOP      2000
+#define POOL_TEST_SIZE      48
+
+static MppMemPool pool = NULL;
+
+/* objects handed from every thread to the next one to free them cross thread */
+static void *handoff[POOL_TEST_THREADS][POOL_TEST_OBJS];
+static pthread_barrier_t barrier;
+static RK_S32 errors = 0;
+
+static void *pool_test_thread(void *arg)
+{
+    RK_S32 id = (RK_S32)(intptr_t)arg;
+    RK_S32 next = (id + 1) % POOL_TEST_THREADS;
+    void *objs[POOL_TEST_OBJS];
+    RK_S32 i, loop;
+
+    for (loop = 0; loop < POOL_TEST_LOOP; loop++) {
+        for (i = 0; i < POOL_TEST_OBJS; i++) {
+            RK_U8 *p = (RK_U8 *)mpp_mem_pool_get(pool);
+            RK_S32 j;
+
+            for (j = 0; j < POOL_TEST_SIZE; j++) {
+                if (p[j]) {
+                    __sync_fetch_and_add(&errors, 1);
+                    break;
+                }
+            }
+            memset(p, id + 1, POOL_TEST_SIZE);
+            objs[i] = p;
+        }
+
+        for (i = 0; i < POOL_TEST_OBJS; i++) {
+            RK_U8 *p = (RK_U8 *)objs[i];
+
+            if (p[0] != id + 1 || p[POOL_TEST_SIZE - 1] != id + 1)
+                __sync_fetch_and_add(&errors, 1);
+        }
+
+        /* free half locally and hand the other half to the next thread */
+        for (i = 0; i < POOL_TEST_OBJS / 2; i++)
+            mpp_mem_pool_put(pool, objs[i]);
+
+        memcpy(handoff[next], &objs[POOL_TEST_OBJS / 2],
+               sizeof(void *) * POOL_TEST_OBJS / 2);
+
+        pthread_barrier_wait(&barrier);
+
+        for (i = 0; i < POOL_TEST_OBJS / 2; i++)
+            mpp_mem_pool_put(pool, handoff[id][i]);
+
+        pthread_barrier_wait(&barrier);
+    }
+
+    return NULL;
+}
+
+int main()
+{
+    pthread_t threads[POOL_TEST_THREADS];
+    RK_S64 start;
+    RK_S32 i;
+
+    mpp_log("mpp_mem_pool_test start\n");
+
+    pool = mpp_mem_pool_init(MODULE_TAG, POOL_TEST_SIZE);
+    if (NULL == pool) {
+        mpp_err("mpp_mem_pool_init failed\n");
+        return -1;
+    }
+
+    pthread_barrier_init(&barrier, NULL, POOL_TEST_THREADS);
+
+    start = mpp_time();
+    for (i = 0; i < POOL_TEST_THREADS; i++)
+        pthread_create(&threads[i], NULL, pool_test_thread, (void *)(intptr_t)i);
+
+    for (i = 0; i < POOL_TEST_THREADS; i++)
+        pthread_join(threads[i], NULL);
+
+    mpp_log("%d threads %d get/put in %lld us\n", POOL_TEST_THREADS,
+            POOL_TEST_THREADS * POOL_TEST_LOOP * POOL_TEST_OBJS,
+            mpp_time() - start);
+
+    pthread_barrier_destroy(&barrier);
+    mpp_mem_pool_deinit(pool);
+
+    mpp_log("mpp_mem_pool_test %s\n", errors ? "failed" : "success");
+
+    return errors;
+}
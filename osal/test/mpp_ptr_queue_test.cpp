@@ -0,0 +1,218 @@
+/*
+ * Copyright 2020 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_ptr_queue_test"
+
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+
+#include "mpp_err.h"
+#include "mpp_log.h"
+#include "mpp_ptr_queue.h"
+
+#define QUEUE_TEST_CAPACITY     4
+#define QUEUE_TEST_LIMIT        8
+#define QUEUE_TEST_COUNT        10000
+
+static RK_S32 destroy_count = 0;
+
+static void *ptr_destroy(void *data)
+{
+    (void)data;
+    destroy_count++;
+    return NULL;
+}
+
+static RK_S32 fd_ready(RK_S32 fd)
+{
+    struct pollfd pfd;
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    return poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN);
+}
+
+#define TEST_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            mpp_err("check %s failed at line %d\n", #cond, __LINE__); \
+            return MPP_NOK; \
+        } \
+    } while (0)
+
+/* head and tail wrap in the ring, then grow while wrapped keeps the order */
+static MPP_RET test_wrap_around(void)
+{
+    MppPtrQueue queue(NULL, QUEUE_TEST_CAPACITY);
+    RK_S32 seq = 0;
+    RK_S32 expect = 0;
+    RK_S32 loop;
+    void *ptr = NULL;
+
+    for (loop = 0; loop < QUEUE_TEST_CAPACITY * 4; loop++) {
+        TEST_CHECK(!queue.push((void *)(intptr_t)seq++));
+        TEST_CHECK(!queue.push((void *)(intptr_t)seq++));
+        TEST_CHECK(!queue.pop(&ptr));
+        TEST_CHECK((intptr_t)ptr == expect++);
+
+        /* keep the depth below capacity so the ring only wraps */
+        if (queue.list_size() >= QUEUE_TEST_CAPACITY - 1) {
+            TEST_CHECK(!queue.pop(&ptr));
+            TEST_CHECK((intptr_t)ptr == expect++);
+        }
+    }
+
+    /* head is in the middle of the ring now, grow twice */
+    while (queue.list_size() < QUEUE_TEST_CAPACITY * 3)
+        TEST_CHECK(!queue.push((void *)(intptr_t)seq++));
+
+    while (!queue.list_is_empty()) {
+        TEST_CHECK(!queue.pop(&ptr));
+        TEST_CHECK((intptr_t)ptr == expect++);
+    }
+
+    TEST_CHECK(expect == seq);
+    return MPP_OK;
+}
+
+/* empty pop fails and fd readiness follows empty / full state */
+static MPP_RET test_full_empty(void)
+{
+    MppPtrQueue queue(ptr_destroy, QUEUE_TEST_CAPACITY);
+    RK_S32 rd_fd;
+    RK_S32 wr_fd;
+    RK_S32 i;
+    void *ptr = NULL;
+
+    TEST_CHECK(queue.list_is_empty());
+    TEST_CHECK(queue.pop(&ptr));
+
+    queue.set_limit(QUEUE_TEST_LIMIT);
+    rd_fd = queue.get_rd_fd();
+    wr_fd = queue.get_wr_fd();
+    TEST_CHECK(rd_fd >= 0 && wr_fd >= 0);
+
+    TEST_CHECK(!fd_ready(rd_fd));
+    TEST_CHECK(fd_ready(wr_fd));
+
+    for (i = 0; i < QUEUE_TEST_LIMIT; i++) {
+        TEST_CHECK(!queue.push(&queue));
+        TEST_CHECK(fd_ready(rd_fd));
+        TEST_CHECK(fd_ready(wr_fd) == (i < QUEUE_TEST_LIMIT - 1));
+    }
+
+    /* limit only drives the write fd, push over it still succeeds */
+    TEST_CHECK(!queue.push(&queue));
+    TEST_CHECK(queue.list_size() == QUEUE_TEST_LIMIT + 1);
+
+    TEST_CHECK(!queue.pop(NULL));
+    TEST_CHECK(!fd_ready(wr_fd));
+    TEST_CHECK(!queue.pop(NULL));
+    TEST_CHECK(fd_ready(wr_fd));
+
+    /* pop with NULL skips destructor, flush calls it for the rest */
+    TEST_CHECK(!destroy_count);
+    queue.flush();
+    TEST_CHECK(destroy_count == QUEUE_TEST_LIMIT - 1);
+    TEST_CHECK(queue.list_is_empty());
+    TEST_CHECK(!fd_ready(rd_fd));
+    TEST_CHECK(fd_ready(wr_fd));
+
+    return MPP_OK;
+}
+
+static void *producer(void *arg)
+{
+    MppPtrQueue *queue = (MppPtrQueue *)arg;
+    RK_S32 i;
+
+    for (i = 0; i < QUEUE_TEST_COUNT; i++) {
+        queue->lock();
+        while (queue->list_size() >= QUEUE_TEST_LIMIT)
+            queue->wait();
+
+        queue->push((void *)(intptr_t)i);
+        queue->signal();
+        queue->unlock();
+    }
+
+    return NULL;
+}
+
+/* one thread pushes a sequence with bounded depth, another pops it in order */
+static MPP_RET test_producer_consumer(void)
+{
+    MppPtrQueue queue(NULL, QUEUE_TEST_CAPACITY);
+    MPP_RET ret = MPP_OK;
+    pthread_t thd;
+    RK_S32 i;
+
+    pthread_create(&thd, NULL, producer, &queue);
+
+    for (i = 0; i < QUEUE_TEST_COUNT; i++) {
+        void *ptr = NULL;
+
+        queue.lock();
+        while (queue.list_is_empty())
+            queue.wait();
+
+        if (queue.list_size() > QUEUE_TEST_LIMIT)
+            ret = MPP_NOK;
+
+        queue.pop(&ptr);
+        queue.signal();
+        queue.unlock();
+
+        if ((intptr_t)ptr != i) {
+            mpp_err("pop %d expect %d\n", (RK_S32)(intptr_t)ptr, i);
+            ret = MPP_NOK;
+        }
+    }
+
+    pthread_join(thd, NULL);
+
+    return ret;
+}
+
+int main()
+{
+    MPP_RET ret;
+
+    mpp_log("mpp_ptr_queue_test start\n");
+
+    ret = test_wrap_around();
+    if (ret) {
+        mpp_err("mpp_ptr_queue_test wrap around failed\n");
+        goto DONE;
+    }
+
+    ret = test_full_empty();
+    if (ret) {
+        mpp_err("mpp_ptr_queue_test full and empty failed\n");
+        goto DONE;
+    }
+
+    ret = test_producer_consumer();
+    if (ret)
+        mpp_err("mpp_ptr_queue_test producer and consumer failed\n");
+
+DONE:
+    mpp_log("mpp_ptr_queue_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
@@ -31,5 +31,10 @@ int main()
     else
         mpp_log("mpp found drm buffer is invalid\n");
 
+    if (mpp_rt_allcator_is_valid(MPP_BUFFER_TYPE_DMA_HEAP))
+        mpp_log("mpp found dma_heap buffer is valid\n");
+    else
+        mpp_log("mpp found dma_heap buffer is invalid\n");
+
     return 0;
 }
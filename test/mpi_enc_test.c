@@ -86,6 +86,7 @@ typedef struct {
     RK_U32 osd_mode;
     RK_U32 split_mode;
     RK_U32 split_arg;
+    RK_U32 split_out;
 
     RK_U32 user_data_enable;
     RK_U32 roi_enable;
@@ -377,14 +378,18 @@ MPP_RET test_mpp_enc_cfg_setup(MpiEncTestData *p)
 
     p->split_mode = 0;
     p->split_arg = 0;
+    p->split_out = 0;
 
     mpp_env_get_u32("split_mode", &p->split_mode, MPP_ENC_SPLIT_NONE);
     mpp_env_get_u32("split_arg", &p->split_arg, 0);
+    mpp_env_get_u32("split_out", &p->split_out, 0);
 
     if (p->split_mode) {
-        mpp_log("%p split_mode %d split_arg %d\n", ctx, p->split_mode, p->split_arg);
+        mpp_log("%p split_mode %d split_arg %d split_out %d\n", ctx,
+                p->split_mode, p->split_arg, p->split_out);
         mpp_enc_cfg_set_s32(cfg, "split:mode", p->split_mode);
         mpp_enc_cfg_set_s32(cfg, "split:arg", p->split_arg);
+        mpp_enc_cfg_set_u32(cfg, "split:out", p->split_out);
     }
 
     ret = mpi->control(ctx, MPP_ENC_SET_CFG, cfg);
@@ -488,6 +493,7 @@ MPP_RET test_mpp_run(MpiEncTestData *p)
         MppPacket packet = NULL;
         void *buf = mpp_buffer_get_ptr(p->frm_buf);
         RK_S32 cam_frm_idx = -1;
+        RK_U32 eoi = 1;
         MppBuffer cam_buf = NULL;
 
         if (p->fp_input) {
@@ -651,23 +657,30 @@ MPP_RET test_mpp_run(MpiEncTestData *p)
         }
         mpp_frame_deinit(&frame);
 
-        ret = mpi->encode_get_packet(ctx, &packet);
-        if (ret) {
-            mpp_err("mpp encode get packet failed\n");
-            goto RET;
-        }
-
-        mpp_assert(packet);
-
-        if (packet) {
-            // write packet to file here
-            void *ptr   = mpp_packet_get_pos(packet);
-            size_t len  = mpp_packet_get_length(packet);
+        /* low delay output returns partitions of a frame until eoi */
+        do {
+            void *ptr = NULL;
+            size_t len = 0;
             char log_buf[256];
             RK_S32 log_size = sizeof(log_buf) - 1;
             RK_S32 log_len = 0;
 
+            ret = mpi->encode_get_packet(ctx, &packet);
+            if (ret) {
+                mpp_err("mpp encode get packet failed\n");
+                goto RET;
+            }
+
+            mpp_assert(packet);
+            if (NULL == packet)
+                break;
+
+            // write packet to file here
+            ptr = mpp_packet_get_pos(packet);
+            len = mpp_packet_get_length(packet);
+
             p->pkt_eos = mpp_packet_get_eos(packet);
+            eoi = mpp_packet_is_partition(packet) ? mpp_packet_is_eoi(packet) : 1;
 
             if (p->fp_output)
                 fwrite(ptr, 1, len, p->fp_output);
@@ -676,6 +689,10 @@ MPP_RET test_mpp_run(MpiEncTestData *p)
                                 "encoded frame %-4d size %-7d",
                                 p->frame_count, len);
 
+            if (mpp_packet_is_partition(packet))
+                log_len += snprintf(log_buf + log_len, log_size - log_len,
+                                    " part%s", eoi ? " eoi" : "");
+
             if (mpp_packet_has_meta(packet)) {
                 meta = mpp_packet_get_meta(packet);
                 RK_S32 temporal_id = 0;
@@ -695,13 +712,14 @@ MPP_RET test_mpp_run(MpiEncTestData *p)
             mpp_packet_deinit(&packet);
 
             p->stream_size += len;
-            p->frame_count++;
+            if (eoi)
+                p->frame_count++;
 
             if (p->pkt_eos) {
                 mpp_log("%p found last packet\n", ctx);
                 mpp_assert(p->frm_eos);
             }
-        }
+        } while (!eoi);
 
         if (cam_frm_idx >= 0)
             camera_source_put_frame(p->cam_ctx, cam_frm_idx);
@@ -766,15 +784,26 @@ int mpi_enc_test(MpiEncTestArgs *cmd)
         goto MPP_TEST_OUT;
     }
 
-    ret = mpp_init(p->ctx, MPP_CTX_ENC, p->type);
+    ret = mpp_enc_cfg_init(&p->cfg);
     if (ret) {
-        mpp_err("mpp_init failed ret %d\n", ret);
+        mpp_err_f("mpp_enc_cfg_init failed ret %d\n", ret);
         goto MPP_TEST_OUT;
     }
 
-    ret = mpp_enc_cfg_init(&p->cfg);
+    /* low delay output is set before init for its partition tasks */
+    mpp_env_get_u32("split_out", &p->split_out, 0);
+    if (p->split_out) {
+        mpp_enc_cfg_set_u32(p->cfg, "split:out", p->split_out);
+        ret = p->mpi->control(p->ctx, MPP_ENC_SET_CFG, p->cfg);
+        if (ret) {
+            mpp_err("mpi control enc set split out cfg failed ret %d\n", ret);
+            goto MPP_TEST_OUT;
+        }
+    }
+
+    ret = mpp_init(p->ctx, MPP_CTX_ENC, p->type);
     if (ret) {
-        mpp_err_f("mpp_enc_cfg_init failed ret %d\n", ret);
+        mpp_err("mpp_init failed ret %d\n", ret);
         goto MPP_TEST_OUT;
     }
 
@@ -57,6 +57,7 @@ void dump_mpp_frame_to_file(MppFrame frame, FILE *fp)
         return ;
 
     base = (RK_U8 *)mpp_buffer_get_ptr(buffer);
+    mpp_buffer_sync_begin(buffer, 1, 0, 0);
 
     switch (fmt) {
     case MPP_FMT_YUV422SP : {
@@ -148,6 +149,8 @@ void dump_mpp_frame_to_file(MppFrame frame, FILE *fp)
         mpp_err("not supported format %d\n", fmt);
     } break;
     }
+
+    mpp_buffer_sync_end(buffer, 1, 0, 0);
 }
 
 void calc_data_crc(RK_U8 *dat, RK_U32 len, DataCrc *crc)
@@ -208,7 +211,10 @@ void calc_frm_crc(MppFrame frame, FrmCrc *crc)
     RK_U32 width  = mpp_frame_get_width(frame);
     RK_U32 height = mpp_frame_get_height(frame);
     RK_U32 stride = mpp_frame_get_hor_stride(frame);
-    RK_U8 *buf = (RK_U8 *)mpp_buffer_get_ptr(mpp_frame_get_buffer(frame));
+    MppBuffer buffer = mpp_frame_get_buffer(frame);
+    RK_U8 *buf = (RK_U8 *)mpp_buffer_get_ptr(buffer);
+
+    mpp_buffer_sync_begin(buffer, 1, 0, 0);
 
     /* luma */
     dat8 = buf;
@@ -239,6 +245,8 @@ void calc_frm_crc(MppFrame frame, FrmCrc *crc)
     crc->chroma.len = height * width / 2;
     crc->chroma.sum = sum;
     crc->chroma.vor = xor;
+
+    mpp_buffer_sync_end(buffer, 1, 0, 0);
 }
 
 void write_frm_crc(FILE *fp, FrmCrc *crc)